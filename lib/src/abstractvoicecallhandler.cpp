@@ -21,34 +21,37 @@
 
 #include "common.h"
 #include "abstractvoicecallhandler.h"
+#include "voicecallstatemachine.h"
+#include "voicecallpendingoperation.h"
 
 QString AbstractVoiceCallHandler::statusText() const
 {
     TRACE
-    switch(status())
-    {
-        case STATUS_ACTIVE:
-            return "active";
-        case STATUS_HELD:
-            return "held";
-        case STATUS_DIALING:
-            return "dialing";
-        case STATUS_ALERTING:
-            return "alerting";
-        case STATUS_INCOMING:
-            return "incoming";
-        case STATUS_WAITING:
-            return "waiting";
-        case STATUS_DISCONNECTED:
-            return "disconnected";
-
-        default:
-            return "null";
-    }
+    return VoiceCallStateMachine::statusText(status());
 }
 
 bool AbstractVoiceCallHandler::isOngoing() const
 {
-    VoiceCallStatus status_ = status();
-    return status_ == STATUS_ACTIVE || status_ == STATUS_HELD;
+    return VoiceCallStateMachine::isOngoing(status());
+}
+
+VoiceCallPendingOperation* AbstractVoiceCallHandler::requestAnswer()
+{
+    TRACE
+    answer();
+    return VoiceCallPendingOperation::completed(true, QString(), this);
+}
+
+VoiceCallPendingOperation* AbstractVoiceCallHandler::requestHangup()
+{
+    TRACE
+    hangup();
+    return VoiceCallPendingOperation::completed(true, QString(), this);
+}
+
+VoiceCallPendingOperation* AbstractVoiceCallHandler::requestHold(bool on)
+{
+    TRACE
+    hold(on);
+    return VoiceCallPendingOperation::completed(true, QString(), this);
 }
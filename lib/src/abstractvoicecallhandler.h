@@ -24,7 +24,10 @@
 #include <QObject>
 #include <QDateTime>
 
+#include "voicecallhandle.h"
+
 class AbstractVoiceCallProvider;
+class VoiceCallPendingOperation;
 
 class AbstractVoiceCallHandler : public QObject
 {
@@ -64,6 +67,7 @@ public:
 
     virtual AbstractVoiceCallProvider* provider() const = 0;
 
+    virtual const VoiceCallHandle& handle() const = 0;
     virtual QString handlerId() const = 0;
     virtual QString lineId() const = 0;
     virtual QDateTime startedAt() const = 0;
@@ -81,6 +85,12 @@ public:
     virtual bool isOngoing() const;
     QString statusText() const;
 
+    // Like answer(), hangup() and hold(), but report when the backend has
+    // confirmed the request. The default implementations finish at once.
+    virtual VoiceCallPendingOperation* requestAnswer();
+    virtual VoiceCallPendingOperation* requestHangup();
+    virtual VoiceCallPendingOperation* requestHold(bool on);
+
 Q_SIGNALS:
     void statusChanged(VoiceCallStatus);
     void lineIdChanged(QString);
@@ -23,6 +23,7 @@
 
 #include <QObject>
 #include "abstractvoicecallhandler.h"
+#include "voicecallpendingoperation.h"
 
 class AbstractVoiceCallProvider : public QObject
 {
@@ -43,6 +44,14 @@ public:
     virtual QList<AbstractVoiceCallHandler*> voiceCalls() const = 0;
     virtual QString errorString() const = 0;
 
+    // Like dial(), but reports when the backend has accepted or rejected the
+    // request. The default implementation finishes at once.
+    virtual VoiceCallPendingOperation* requestDial(const QString &msisdn)
+    {
+        bool ok = dial(msisdn);
+        return VoiceCallPendingOperation::completed(ok, errorString(), this);
+    }
+
 Q_SIGNALS:
     void error(QString);
 
@@ -22,3 +22,99 @@
 #include "common.h"
 
 Q_LOGGING_CATEGORY(voicecall, "org.nemomobile.voicecall", QtWarningMsg)
+
+#ifdef WANT_TRACE
+#include <QList>
+#include <QMutex>
+#include <QScopedArrayPointer>
+#include <QThread>
+
+#include <string.h>
+#include <time.h>
+
+#define VOICECALL_TRACE_BUFFER_SIZE 4096 // Power of two.
+
+namespace {
+
+struct TraceEvent
+{
+    const VoiceCallTracePoint *point;
+    qint64 timestamp;
+    const void *object;
+};
+
+// Written only by its owning thread. The lock is only ever contended while a
+// dump copies the ring, so recording stays an uncontended lock and a store.
+struct TraceBuffer
+{
+    TraceBuffer() : thread(QThread::currentThreadId()), head(0) {/* ... */}
+
+    Qt::HANDLE thread;
+    QBasicMutex lock;
+    quint32 head;
+    TraceEvent events[VOICECALL_TRACE_BUFFER_SIZE];
+};
+
+QMutex traceBuffersLock;
+QList<TraceBuffer*> traceBuffers;
+
+thread_local TraceBuffer *threadTraceBuffer = 0;
+
+TraceBuffer* createTraceBuffer()
+{
+    // Buffers outlive their threads, so a dump still shows what they did.
+    TraceBuffer *buffer = new TraceBuffer;
+    QMutexLocker locker(&traceBuffersLock);
+    traceBuffers.append(buffer);
+    return buffer;
+}
+
+}
+
+void voicecallTraceRecord(const VoiceCallTracePoint *point, const void *object)
+{
+    TraceBuffer *buffer = threadTraceBuffer;
+    if (!buffer) buffer = threadTraceBuffer = createTraceBuffer();
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    QMutexLocker locker(&buffer->lock);
+    TraceEvent &event = buffer->events[buffer->head++ & (VOICECALL_TRACE_BUFFER_SIZE - 1)];
+    event.point = point;
+    event.timestamp = qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    event.object = object;
+}
+
+void voicecallTraceDump()
+{
+    QMutexLocker locker(&traceBuffersLock);
+
+    // Copied out so the owning threads are held up only for the copy, not
+    // while the events are formatted.
+    QScopedArrayPointer<TraceEvent> events(new TraceEvent[VOICECALL_TRACE_BUFFER_SIZE]);
+
+    foreach (TraceBuffer *buffer, traceBuffers)
+    {
+        quint32 head;
+        {
+            QMutexLocker bufferLocker(&buffer->lock);
+            head = buffer->head;
+            memcpy(events.data(), buffer->events, sizeof(buffer->events));
+        }
+        quint32 count = qMin<quint32>(head, VOICECALL_TRACE_BUFFER_SIZE);
+
+        qInfo("voicecall trace: thread %p, %u of %u events", buffer->thread, count, head);
+
+        for (quint32 i = head - count; i != head; ++i)
+        {
+            const TraceEvent &event = events[i & (VOICECALL_TRACE_BUFFER_SIZE - 1)];
+            if (!event.point) continue;
+
+            qInfo("%lld.%09lld %s:%d %p",
+                  event.timestamp / 1000000000, event.timestamp % 1000000000,
+                  event.point->function, event.point->line, event.object);
+        }
+    }
+}
+#endif
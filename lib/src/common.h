@@ -26,7 +26,33 @@
 Q_DECLARE_LOGGING_CATEGORY(voicecall)
 
 #define WARNING_T(message, ...) qCWarning(voicecall, "%s " message, Q_FUNC_INFO, ##__VA_ARGS__)
-#define TRACE qCInfo(voicecall, "%s:%d %p", Q_FUNC_INFO, __LINE__, this);
 #define DEBUG_T(message, ...) qCDebug(voicecall, "%s " message, Q_FUNC_INFO, ##__VA_ARGS__)
 
+/*
+ * TRACE compiles to nothing unless WANT_TRACE is defined (CONFIG+=enable-debug).
+ *
+ * With WANT_TRACE every trace site owns a constant-initialized descriptor and
+ * a hit records only (descriptor, monotonic timestamp, this) into a ring buffer
+ * owned by the calling thread. Nothing is formatted until voicecallTraceDump().
+ * Static functions use TRACE_STATIC, which records a null object.
+ */
+#ifdef WANT_TRACE
+struct VoiceCallTracePoint
+{
+    const char *function;
+    int line;
+};
+
+void voicecallTraceRecord(const VoiceCallTracePoint *point, const void *object);
+void voicecallTraceDump();
+
+#define TRACE { static const VoiceCallTracePoint voicecall_trace_point = { Q_FUNC_INFO, __LINE__ }; \
+                voicecallTraceRecord(&voicecall_trace_point, this); }
+#define TRACE_STATIC { static const VoiceCallTracePoint voicecall_trace_point = { Q_FUNC_INFO, __LINE__ }; \
+                       voicecallTraceRecord(&voicecall_trace_point, 0); }
+#else
+#define TRACE
+#define TRACE_STATIC
+#endif
+
 #endif // COMMON_H
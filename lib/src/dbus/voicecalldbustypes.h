@@ -0,0 +1,52 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLDBUSTYPES_H
+#define VOICECALLDBUSTYPES_H
+
+#include <QMap>
+#include <QString>
+#include <QVariantMap>
+#include <QMetaType>
+#include <QDBusObjectPath>
+
+#include <time.h>
+
+// Call handler id -> call properties, marshalled as a{sa{sv}}.
+typedef QMap<QString, QVariantMap> VoiceCallPropertiesMap;
+
+Q_DECLARE_METATYPE(VoiceCallPropertiesMap)
+
+// Object path -> interface name -> properties, marshalled as a{oa{sa{sv}}}
+// for org.freedesktop.DBus.ObjectManager.
+typedef QMap<QDBusObjectPath, VoiceCallPropertiesMap> VoiceCallManagedObjects;
+
+Q_DECLARE_METATYPE(VoiceCallManagedObjects)
+
+// Clock of the connectedAt call property, CLOCK_BOOTTIME in milliseconds so
+// that it keeps counting while the device is suspended.
+inline qint64 voicecallBootTimestamp()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return qint64(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+#endif // VOICECALLDBUSTYPES_H
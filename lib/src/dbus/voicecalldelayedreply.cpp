@@ -0,0 +1,85 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "common.h"
+#include "voicecalldelayedreply.h"
+
+#include "voicecallpendingoperation.h"
+
+#include <QDBusError>
+
+/*!
+  Sends the reply to \a message on \a connection when \a operation finishes,
+  or a timeout error after \a timeout milliseconds. The caller has to have
+  marked \a message as having a delayed reply, when it came in through an
+  adaptor.
+*/
+void VoiceCallDelayedReply::send(VoiceCallPendingOperation *operation, const QDBusMessage &message,
+                                 const QDBusConnection &connection, int timeout)
+{
+    TRACE_STATIC
+    new VoiceCallDelayedReply(operation, message, connection, timeout);
+}
+
+VoiceCallDelayedReply::VoiceCallDelayedReply(VoiceCallPendingOperation *operation, const QDBusMessage &message,
+                                             const QDBusConnection &connection, int timeout)
+    : QObject(), m_message(message), m_connection(connection)
+{
+    TRACE
+    QObject::connect(operation, SIGNAL(finished(VoiceCallPendingOperation*)), SLOT(onFinished(VoiceCallPendingOperation*)));
+    QObject::connect(operation, SIGNAL(destroyed()), SLOT(onDestroyed()));
+
+    m_timer.setSingleShot(true);
+    QObject::connect(&m_timer, SIGNAL(timeout()), SLOT(onTimeout()));
+    m_timer.start(timeout);
+}
+
+void VoiceCallDelayedReply::onFinished(VoiceCallPendingOperation *operation)
+{
+    TRACE
+    if(operation->isError())
+    {
+        reply(m_message.createErrorReply("org.nemomobile.voicecall.Error.Failed", operation->errorMessage()));
+    }
+    else
+    {
+        reply(m_message.createReply(true));
+    }
+}
+
+void VoiceCallDelayedReply::onDestroyed()
+{
+    TRACE
+    // Only reached when the operation went away with its call, unfinished.
+    reply(m_message.createErrorReply("org.nemomobile.voicecall.Error.Failed", "The call went away"));
+}
+
+void VoiceCallDelayedReply::onTimeout()
+{
+    TRACE
+    WARNING_T("No confirmation for %s in time", qPrintable(m_message.member()));
+    reply(m_message.createErrorReply(QDBusError::Timeout, "The request was not confirmed in time"));
+}
+
+void VoiceCallDelayedReply::reply(const QDBusMessage &reply)
+{
+    m_connection.send(reply);
+    delete this;
+}
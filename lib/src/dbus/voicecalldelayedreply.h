@@ -0,0 +1,62 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLDELAYEDREPLY_H
+#define VOICECALLDELAYEDREPLY_H
+
+#include <QObject>
+#include <QTimer>
+#include <QDBusMessage>
+#include <QDBusConnection>
+
+class VoiceCallPendingOperation;
+
+/*
+ * Answers a D-Bus method call once the provider has confirmed the request.
+ *
+ * The reply is a plain true when the operation succeeds, an error carrying
+ * the backend's message when it fails, and a timeout error if it does not
+ * finish within the given time. The object deletes itself once it replied.
+ */
+class VoiceCallDelayedReply : public QObject
+{
+    Q_OBJECT
+
+public:
+    static void send(VoiceCallPendingOperation *operation, const QDBusMessage &message,
+                     const QDBusConnection &connection, int timeout);
+
+protected Q_SLOTS:
+    void onFinished(VoiceCallPendingOperation *operation);
+    void onDestroyed();
+    void onTimeout();
+
+private:
+    VoiceCallDelayedReply(VoiceCallPendingOperation *operation, const QDBusMessage &message,
+                          const QDBusConnection &connection, int timeout);
+
+    void reply(const QDBusMessage &reply);
+
+    QDBusMessage m_message;
+    QDBusConnection m_connection;
+    QTimer m_timer;
+};
+
+#endif // VOICECALLDELAYEDREPLY_H
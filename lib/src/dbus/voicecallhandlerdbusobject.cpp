@@ -0,0 +1,863 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "common.h"
+#include "voicecallhandlerdbusobject.h"
+#include "voicecallpropertiesnotifier.h"
+#include "voicecallsignalscheduler.h"
+#include "voicecalldbustypes.h"
+#include "voicecalldelayedreply.h"
+
+#include "abstractvoicecallprovider.h"
+#include "voicecallmanagerinterface.h"
+#include "voicecallstatemachine.h"
+#include "voicecallstats.h"
+#include "voicecalldurationtracker.h"
+#include "voicecallpendingoperation.h"
+
+#include <QHash>
+#include <QTimer>
+#include <QPointer>
+#include <QDBusError>
+#include <QDBusMessage>
+#include <QDBusMetaType>
+#include <QDBusVariant>
+#include <QDBusServiceWatcher>
+
+#define VOICECALL_INTERFACE "org.nemomobile.voicecall.VoiceCall"
+#define VOICECALL_CALLS_PATH "/calls"
+#define VOICECALL_ACTIVE_PATH "/calls/active"
+
+// How long answer, hangup and hold wait for the provider, shorter than the
+// default D-Bus client timeout so that callers see why they failed.
+#define VOICECALL_REQUEST_REPLY_TIMEOUT 10000
+
+static const char introspectionDocType[] =
+    "<!DOCTYPE node PUBLIC \"-//freedesktop//DTD D-BUS Object Introspection 1.0//EN\"\n"
+    "\"http://www.freedesktop.org/standards/dbus/1.0/introspect.dtd\">\n";
+
+static const char voicecallIntrospection[] =
+    "  <interface name=\"org.nemomobile.voicecall.VoiceCall\">\n"
+    "    <property name=\"handlerId\" type=\"s\" access=\"read\"/>\n"
+    "    <property name=\"providerId\" type=\"s\" access=\"read\"/>\n"
+    "    <property name=\"status\" type=\"i\" access=\"read\"/>\n"
+    "    <property name=\"statusText\" type=\"s\" access=\"read\"/>\n"
+    "    <property name=\"lineId\" type=\"s\" access=\"read\"/>\n"
+    "    <property name=\"startedAt\" type=\"((iii)(iiii)i)\" access=\"read\">\n"
+    "      <annotation name=\"org.qtproject.QtDBus.QtTypeName\" value=\"QDateTime\"/>\n"
+    "    </property>\n"
+    "    <property name=\"duration\" type=\"i\" access=\"read\"/>\n"
+    "    <property name=\"connectedAt\" type=\"x\" access=\"read\"/>\n"
+    "    <property name=\"heldTime\" type=\"x\" access=\"read\"/>\n"
+    "    <property name=\"isIncoming\" type=\"b\" access=\"read\"/>\n"
+    "    <property name=\"isEmergency\" type=\"b\" access=\"read\"/>\n"
+    "    <property name=\"isMultiparty\" type=\"b\" access=\"read\"/>\n"
+    "    <property name=\"isForwarded\" type=\"b\" access=\"read\"/>\n"
+    "    <property name=\"isRemoteHeld\" type=\"b\" access=\"read\"/>\n"
+    "    <property name=\"parentHandlerId\" type=\"s\" access=\"read\"/>\n"
+    "    <property name=\"childCalls\" type=\"as\" access=\"read\"/>\n"
+    "    <signal name=\"error\">\n"
+    "      <arg name=\"message\" type=\"s\" direction=\"out\"/>\n"
+    "    </signal>\n"
+    "    <signal name=\"statusChanged\">\n"
+    "      <arg type=\"i\" direction=\"out\"/>\n"
+    "      <arg type=\"s\" direction=\"out\"/>\n"
+    "    </signal>\n"
+    "    <signal name=\"lineIdChanged\">\n"
+    "      <arg type=\"s\" direction=\"out\"/>\n"
+    "    </signal>\n"
+    "    <signal name=\"startedAtChanged\">\n"
+    "      <arg type=\"((iii)(iiii)i)\" direction=\"out\"/>\n"
+    "      <annotation name=\"org.qtproject.QtDBus.QtTypeName.Out0\" value=\"QDateTime\"/>\n"
+    "    </signal>\n"
+    "    <signal name=\"durationChanged\">\n"
+    "      <arg type=\"i\" direction=\"out\"/>\n"
+    "    </signal>\n"
+    "    <signal name=\"emergencyChanged\">\n"
+    "      <arg type=\"b\" direction=\"out\"/>\n"
+    "    </signal>\n"
+    "    <signal name=\"multipartyChanged\">\n"
+    "      <arg type=\"b\" direction=\"out\"/>\n"
+    "    </signal>\n"
+    "    <signal name=\"forwardedChanged\">\n"
+    "      <arg type=\"b\" direction=\"out\"/>\n"
+    "    </signal>\n"
+    "    <signal name=\"remoteHeldChanged\">\n"
+    "      <arg type=\"b\" direction=\"out\"/>\n"
+    "    </signal>\n"
+    "    <signal name=\"parentHandlerIdChanged\">\n"
+    "      <arg type=\"s\" direction=\"out\"/>\n"
+    "    </signal>\n"
+    "    <signal name=\"childCallsChanged\">\n"
+    "      <arg type=\"as\" direction=\"out\"/>\n"
+    "    </signal>\n"
+    "    <method name=\"answer\">\n"
+    "      <arg type=\"b\" direction=\"out\"/>\n"
+    "    </method>\n"
+    "    <method name=\"hangup\">\n"
+    "      <arg type=\"b\" direction=\"out\"/>\n"
+    "    </method>\n"
+    "    <method name=\"hold\">\n"
+    "      <arg type=\"b\" direction=\"out\"/>\n"
+    "      <arg name=\"on\" type=\"b\" direction=\"in\"/>\n"
+    "    </method>\n"
+    "    <method name=\"deflect\">\n"
+    "      <arg type=\"b\" direction=\"out\"/>\n"
+    "      <arg name=\"target\" type=\"s\" direction=\"in\"/>\n"
+    "    </method>\n"
+    "    <method name=\"sendDtmf\">\n"
+    "      <arg name=\"tones\" type=\"s\" direction=\"in\"/>\n"
+    "    </method>\n"
+    "    <method name=\"merge\">\n"
+    "      <arg type=\"b\" direction=\"out\"/>\n"
+    "      <arg name=\"callHandle\" type=\"s\" direction=\"in\"/>\n"
+    "    </method>\n"
+    "    <method name=\"split\">\n"
+    "      <arg type=\"b\" direction=\"out\"/>\n"
+    "    </method>\n"
+    "    <method name=\"getProperties\">\n"
+    "      <arg type=\"a{sv}\" direction=\"out\"/>\n"
+    "      <annotation name=\"org.qtproject.QtDBus.QtTypeName.Out0\" value=\"QVariantMap\"/>\n"
+    "    </method>\n"
+    "    <method name=\"getCallProperties\">\n"
+    "      <arg type=\"" VOICECALL_PROPERTIES_SIGNATURE "\" direction=\"out\"/>\n"
+    "      <annotation name=\"org.qtproject.QtDBus.QtTypeName.Out0\" value=\"VoiceCallProperties\"/>\n"
+    "    </method>\n"
+    "    <method name=\"SubscribeDuration\"/>\n"
+    "    <method name=\"UnsubscribeDuration\"/>\n"
+    "  </interface>\n";
+
+static const char standardIntrospection[] =
+    "  <interface name=\"org.freedesktop.DBus.Properties\">\n"
+    "    <method name=\"Get\">\n"
+    "      <arg name=\"interface_name\" type=\"s\" direction=\"in\"/>\n"
+    "      <arg name=\"property_name\" type=\"s\" direction=\"in\"/>\n"
+    "      <arg name=\"value\" type=\"v\" direction=\"out\"/>\n"
+    "    </method>\n"
+    "    <method name=\"Set\">\n"
+    "      <arg name=\"interface_name\" type=\"s\" direction=\"in\"/>\n"
+    "      <arg name=\"property_name\" type=\"s\" direction=\"in\"/>\n"
+    "      <arg name=\"value\" type=\"v\" direction=\"in\"/>\n"
+    "    </method>\n"
+    "    <method name=\"GetAll\">\n"
+    "      <arg name=\"interface_name\" type=\"s\" direction=\"in\"/>\n"
+    "      <arg name=\"values\" type=\"a{sv}\" direction=\"out\"/>\n"
+    "      <annotation name=\"org.qtproject.QtDBus.QtTypeName.Out0\" value=\"QVariantMap\"/>\n"
+    "    </method>\n"
+    "    <signal name=\"PropertiesChanged\">\n"
+    "      <arg name=\"interface_name\" type=\"s\" direction=\"out\"/>\n"
+    "      <arg name=\"changed_properties\" type=\"a{sv}\" direction=\"out\"/>\n"
+    "      <annotation name=\"org.qtproject.QtDBus.QtTypeName.Out1\" value=\"QVariantMap\"/>\n"
+    "      <arg name=\"invalidated_properties\" type=\"as\" direction=\"out\"/>\n"
+    "    </signal>\n"
+    "  </interface>\n"
+    "  <interface name=\"org.freedesktop.DBus.Introspectable\">\n"
+    "    <method name=\"Introspect\">\n"
+    "      <arg name=\"xml_data\" type=\"s\" direction=\"out\"/>\n"
+    "    </method>\n"
+    "  </interface>\n";
+
+/*!
+  \class VoiceCallHandlerDBusObject
+  \brief Exports every voice call under /calls from a single D-Bus object.
+
+  Rather than an adaptor and an object registration per call, this virtual
+  object is registered once with QDBusConnection::SubPath and resolves
+  /calls/<id> and /calls/active against its handle registry for each message.
+  Adding a call only inserts it into that registry; the introspection data is
+  a constant and the connection's object tree is never touched.
+*/
+class VoiceCallHandlerDBusObjectPrivate
+{
+    Q_DECLARE_PUBLIC(VoiceCallHandlerDBusObject)
+
+public:
+    struct Subscriber
+    {
+        QString connectionName;
+        QString service;
+
+        bool operator==(const Subscriber &other) const
+        {
+            return connectionName == other.connectionName && service == other.service;
+        }
+    };
+
+    // What is kept for each exported call.
+    struct Call
+    {
+        Call(AbstractVoiceCallHandler *pHandler)
+            : handler(pHandler), status(AbstractVoiceCallHandler::STATUS_NULL),
+              connectedAt(0), heldTime(0), heldSince(0)
+        {/*...*/}
+
+        QPointer<AbstractVoiceCallHandler> handler;
+        QList<QMetaObject::Connection> connections;
+
+        // Clients that asked for the per second durationChanged signal.
+        QList<Subscriber> subscribers;
+
+        // Properties to send in the next PropertiesChanged.
+        QStringList changed;
+
+        // Call timing on the voicecallBootTimestamp() clock.
+        AbstractVoiceCallHandler::VoiceCallStatus status;
+        qint64 connectedAt;
+        qint64 heldTime;
+        qint64 heldSince;
+
+        void updateTiming(AbstractVoiceCallHandler::VoiceCallStatus newStatus)
+        {
+            qint64 now = voicecallBootTimestamp();
+
+            if(VoiceCallStateMachine::isOngoing(newStatus) && connectedAt == 0)
+            {
+                // The call may have been going on before it was exported.
+                // Providers on the shared tracker know it to the millisecond,
+                // the others only report whole seconds.
+                qint64 duration = VoiceCallDurationTracker::instance()->duration(handler->handle().value());
+                if(duration < 0) duration = qint64(handler->duration()) * 1000;
+                connectedAt = now - duration;
+            }
+
+            if(status == AbstractVoiceCallHandler::STATUS_HELD && newStatus != status)
+            {
+                heldTime += now - heldSince;
+            }
+            else if(newStatus == AbstractVoiceCallHandler::STATUS_HELD && newStatus != status)
+            {
+                heldSince = now;
+            }
+
+            status = newStatus;
+        }
+
+        qint64 currentHeldTime() const
+        {
+            if(status == AbstractVoiceCallHandler::STATUS_HELD)
+            {
+                return heldTime + voicecallBootTimestamp() - heldSince;
+            }
+            return heldTime;
+        }
+    };
+
+    VoiceCallHandlerDBusObjectPrivate(VoiceCallHandlerDBusObject *q)
+        : q_ptr(q), manager(NULL), activeHandle(0), subscriberWatcher(NULL)
+    {/*...*/}
+
+    VoiceCallHandlerDBusObject *q_ptr;
+    VoiceCallManagerInterface *manager;
+
+    // Exported calls keyed by handle value, the last element of their path.
+    QHash<quint64, Call*> calls;
+    quint64 activeHandle;
+
+    QList<Call*> pending;
+    QTimer flushTimer;
+
+    QDBusServiceWatcher *subscriberWatcher;
+
+    Call* callForPath(const QString &path) const
+    {
+        if(!path.startsWith(QLatin1String(VOICECALL_CALLS_PATH "/"))) return NULL;
+
+        QString id = path.mid(sizeof(VOICECALL_CALLS_PATH));
+        quint64 handle = id == QLatin1String("active") ? activeHandle : VoiceCallHandle::valueOf(id);
+
+        Call *call = handle ? calls.value(handle) : NULL;
+        return call && call->handler ? call : NULL;
+    }
+
+    QStringList paths(Call *call) const
+    {
+        QStringList results(call->handler->handle().path());
+        if(call->handler->handle().value() == activeHandle) results.append(VOICECALL_ACTIVE_PATH);
+        return results;
+    }
+
+    void emitSignal(Call *call, const QString &name, const QVariantList &arguments,
+                    const QString &interface = VOICECALL_INTERFACE)
+    {
+        foreach(const QString &connectionName, VoiceCallPropertiesNotifier::connections())
+        {
+            foreach(const QString &path, paths(call))
+            {
+                QDBusMessage message = QDBusMessage::createSignal(path, interface, name);
+                message.setArguments(arguments);
+                VoiceCallSignalScheduler::instance()->send(connectionName, message);
+            }
+        }
+    }
+
+    void propertyChanged(Call *call, const QString &name)
+    {
+        if(!call->changed.contains(name)) call->changed.append(name);
+        if(!pending.contains(call)) pending.append(call);
+        if(!flushTimer.isActive()) flushTimer.start();
+    }
+
+    void notify(Call *call, const QString &property, const QString &signal, const QVariant &value)
+    {
+        propertyChanged(call, property);
+        emitSignal(call, signal, QVariantList() << value);
+    }
+
+    // The shared duration timer only ticks while a client wants durationChanged.
+    void updateDurationTicks()
+    {
+        Q_Q(VoiceCallHandlerDBusObject);
+        foreach(Call *call, calls)
+        {
+            if(!call->subscribers.isEmpty())
+            {
+                VoiceCallDurationTracker::instance()->subscribe(q);
+                return;
+            }
+        }
+        VoiceCallDurationTracker::instance()->unsubscribe(q);
+    }
+
+    void onStatusChanged(Call *call);
+    void onDurationChanged(Call *call);
+
+    bool handleCall(Call *call, const QDBusMessage &message, const QDBusConnection &connection);
+    bool handlePropertiesCall(Call *call, const QDBusMessage &message, const QDBusConnection &connection);
+
+    void subscribe(Call *call, const QDBusMessage &message, const QDBusConnection &connection);
+    void unsubscribe(Call *call, const QDBusMessage &message, const QDBusConnection &connection);
+};
+
+static QStringList childCallIds(AbstractVoiceCallHandler *handler)
+{
+    QStringList results;
+
+    foreach(AbstractVoiceCallHandler *child, handler->childCalls())
+    {
+        results.append(child->handlerId());
+    }
+
+    return results;
+}
+
+/*!
+  Constructs the D-Bus object for the voice calls, it has to be configured
+  and registered at /calls with QDBusConnection::SubPath.
+*/
+VoiceCallHandlerDBusObject::VoiceCallHandlerDBusObject(QObject *parent)
+    : QDBusVirtualObject(parent), d_ptr(new VoiceCallHandlerDBusObjectPrivate(this))
+{
+    TRACE
+    Q_D(VoiceCallHandlerDBusObject);
+    qDBusRegisterMetaType<VoiceCallProperties>();
+
+    d->flushTimer.setSingleShot(true);
+    d->flushTimer.setInterval(0);
+    QObject::connect(&d->flushTimer, SIGNAL(timeout()), SLOT(flush()));
+}
+
+VoiceCallHandlerDBusObject::~VoiceCallHandlerDBusObject()
+{
+    TRACE
+    Q_D(VoiceCallHandlerDBusObject);
+
+    qDeleteAll(d->calls);
+    delete d;
+}
+
+/*!
+  Starts exporting the voice calls of \a manager.
+*/
+void VoiceCallHandlerDBusObject::configure(VoiceCallManagerInterface *manager)
+{
+    TRACE
+    Q_D(VoiceCallHandlerDBusObject);
+    d->manager = manager;
+
+    QObject::connect(d->manager, SIGNAL(voiceCallAdded(AbstractVoiceCallHandler*)), SLOT(onVoiceCallAdded(AbstractVoiceCallHandler*)));
+    QObject::connect(d->manager, SIGNAL(voiceCallRemoved(QString)), SLOT(onVoiceCallRemoved(QString)));
+    QObject::connect(d->manager, SIGNAL(activeVoiceCallChanged()), SLOT(onActiveVoiceCallChanged()));
+
+    foreach(AbstractVoiceCallHandler *handler, d->manager->voiceCalls())
+    {
+        onVoiceCallAdded(handler);
+    }
+    onActiveVoiceCallChanged();
+}
+
+/*!
+  Returns the properties of \a handler, with startedAt in milliseconds since
+  the epoch. This is what getCallProperties() returns, and what the manager
+  sends for each call in GetCallList().
+*/
+VoiceCallProperties VoiceCallHandlerDBusObject::properties(AbstractVoiceCallHandler *handler) const
+{
+    TRACE
+    VoiceCallProperties props;
+
+    props.handlerId = handler->handlerId();
+    props.providerId = handler->provider()->providerId();
+    props.status = int(handler->status());
+    props.statusText = handler->statusText();
+    props.lineId = handler->lineId();
+    props.startedAt = handler->startedAt().toMSecsSinceEpoch();
+    props.duration = handler->duration();
+    props.connectedAt = connectedAt(handler);
+    props.heldTime = heldTime(handler);
+    props.isIncoming = handler->isIncoming();
+    props.isEmergency = handler->isEmergency();
+    props.isMultiparty = handler->isMultiparty();
+    props.isForwarded = handler->isForwarded();
+    props.isRemoteHeld = handler->isRemoteHeld();
+    props.parentHandlerId = handler->parentHandlerId();
+    props.childCalls = childCallIds(handler);
+
+    return props;
+}
+
+/*!
+  Returns the properties of \a handler as a map, as getProperties() returns
+  them and CallAdded carries them.
+*/
+QVariantMap VoiceCallHandlerDBusObject::callProperties(AbstractVoiceCallHandler *handler) const
+{
+    TRACE
+    return properties(handler).toMap();
+}
+
+/*!
+  Returns the properties of the voice call interface of \a handler, as Get and
+  GetAll return them, with startedAt as a date.
+*/
+QVariantMap VoiceCallHandlerDBusObject::interfaceProperties(AbstractVoiceCallHandler *handler) const
+{
+    QVariantMap props = callProperties(handler);
+    props.insert("startedAt", QVariant(handler->startedAt()));
+    return props;
+}
+
+/*!
+  Returns when \a handler was first connected, in milliseconds on the
+  CLOCK_BOOTTIME clock, or 0 if it never was. While the call is going on its
+  duration is the current CLOCK_BOOTTIME time minus this value, which lets
+  clients show it without listening to durationChanged.
+*/
+qlonglong VoiceCallHandlerDBusObject::connectedAt(AbstractVoiceCallHandler *handler) const
+{
+    Q_D(const VoiceCallHandlerDBusObject);
+    VoiceCallHandlerDBusObjectPrivate::Call *call = d->calls.value(handler->handle().value());
+    return call ? call->connectedAt : 0;
+}
+
+/*!
+  Returns the time \a handler has spent on hold, in milliseconds.
+*/
+qlonglong VoiceCallHandlerDBusObject::heldTime(AbstractVoiceCallHandler *handler) const
+{
+    Q_D(const VoiceCallHandlerDBusObject);
+    VoiceCallHandlerDBusObjectPrivate::Call *call = d->calls.value(handler->handle().value());
+    return call ? call->currentHeldTime() : 0;
+}
+
+/*!
+  Returns the introspection data of \a path: the child nodes for /calls, and
+  the voice call interface for a call.
+*/
+QString VoiceCallHandlerDBusObject::introspect(const QString &path) const
+{
+    Q_D(const VoiceCallHandlerDBusObject);
+
+    if(path == QLatin1String(VOICECALL_CALLS_PATH))
+    {
+        QString xml;
+        foreach(VoiceCallHandlerDBusObjectPrivate::Call *call, d->calls)
+        {
+            if(!call->handler) continue;
+            xml += QString("  <node name=\"%1\"/>\n").arg(call->handler->handlerId());
+        }
+        if(d->calls.contains(d->activeHandle)) xml += "  <node name=\"active\"/>\n";
+        return xml;
+    }
+
+    return d->callForPath(path) ? QLatin1String(voicecallIntrospection) : QString();
+}
+
+/*!
+  Dispatches \a message, received on \a connection for a path under /calls,
+  to the voice call it names.
+*/
+bool VoiceCallHandlerDBusObject::handleMessage(const QDBusMessage &message, const QDBusConnection &connection)
+{
+    TRACE
+    Q_D(VoiceCallHandlerDBusObject);
+    if(message.type() != QDBusMessage::MethodCallMessage) return false;
+
+    const QString interface = message.interface();
+
+    if(message.member() == "Introspect" && message.signature().isEmpty()
+            && (interface.isEmpty() || interface == "org.freedesktop.DBus.Introspectable"))
+    {
+        QString xml = QLatin1String(introspectionDocType);
+        xml += "<node>\n";
+        xml += introspect(message.path());
+        if(d->callForPath(message.path())) xml += QLatin1String(standardIntrospection);
+        xml += "</node>\n";
+
+        connection.send(message.createReply(xml));
+        return true;
+    }
+
+    VoiceCallHandlerDBusObjectPrivate::Call *call = d->callForPath(message.path());
+    if(!call)
+    {
+        connection.send(message.createErrorReply(QDBusError::UnknownObject,
+                                                 QString("No voice call at %1").arg(message.path())));
+        return true;
+    }
+
+    if(interface == "org.freedesktop.DBus.Properties")
+    {
+        return d->handlePropertiesCall(call, message, connection);
+    }
+    if(interface.isEmpty() || interface == VOICECALL_INTERFACE)
+    {
+        return d->handleCall(call, message, connection);
+    }
+
+    return false;
+}
+
+bool VoiceCallHandlerDBusObjectPrivate::handleCall(Call *call, const QDBusMessage &message, const QDBusConnection &connection)
+{
+    Q_Q(VoiceCallHandlerDBusObject);
+    AbstractVoiceCallHandler *handler = call->handler;
+    const QString member = message.member();
+    const QString signature = message.signature();
+    const QVariantList arguments = message.arguments();
+    QDBusMessage reply;
+
+    // These are answered once the provider has confirmed them.
+    if(member == "answer" && signature.isEmpty())
+    {
+        VoiceCallDelayedReply::send(handler->requestAnswer(), message, connection, VOICECALL_REQUEST_REPLY_TIMEOUT);
+        return true;
+    }
+    else if(member == "hangup" && signature.isEmpty())
+    {
+        VoiceCallDelayedReply::send(handler->requestHangup(), message, connection, VOICECALL_REQUEST_REPLY_TIMEOUT);
+        return true;
+    }
+    else if(member == "hold" && signature == "b")
+    {
+        VoiceCallDelayedReply::send(handler->requestHold(arguments.at(0).toBool()), message, connection,
+                                    VOICECALL_REQUEST_REPLY_TIMEOUT);
+        return true;
+    }
+
+    if(member == "deflect" && signature == "s")
+    {
+        handler->deflect(arguments.at(0).toString());
+        reply = message.createReply(true);
+    }
+    else if(member == "sendDtmf" && signature == "s")
+    {
+        handler->sendDtmf(arguments.at(0).toString());
+        reply = message.createReply();
+    }
+    else if(member == "merge" && signature == "s")
+    {
+        handler->merge(arguments.at(0).toString());
+        reply = message.createReply(true);
+    }
+    else if(member == "split" && signature.isEmpty())
+    {
+        handler->split();
+        reply = message.createReply(true);
+    }
+    else if(member == "getProperties" && signature.isEmpty())
+    {
+        reply = message.createReply(q->callProperties(handler));
+    }
+    else if(member == "getCallProperties" && signature.isEmpty())
+    {
+        reply = message.createReply(QVariant::fromValue(q->properties(handler)));
+    }
+    else if(member == "SubscribeDuration" && signature.isEmpty())
+    {
+        subscribe(call, message, connection);
+        reply = message.createReply();
+    }
+    else if(member == "UnsubscribeDuration" && signature.isEmpty())
+    {
+        unsubscribe(call, message, connection);
+        reply = message.createReply();
+    }
+    else
+    {
+        return false;
+    }
+
+    connection.send(reply);
+    return true;
+}
+
+bool VoiceCallHandlerDBusObjectPrivate::handlePropertiesCall(Call *call, const QDBusMessage &message, const QDBusConnection &connection)
+{
+    Q_Q(VoiceCallHandlerDBusObject);
+    const QString member = message.member();
+    const QString signature = message.signature();
+    const QVariantList arguments = message.arguments();
+    QDBusMessage reply;
+
+    if(signature.isEmpty() || (arguments.at(0).toString() != VOICECALL_INTERFACE && !arguments.at(0).toString().isEmpty()))
+    {
+        reply = message.createErrorReply(QDBusError::InvalidArgs, "No such interface");
+    }
+    else if(member == "Get" && signature == "ss")
+    {
+        QVariant value = q->interfaceProperties(call->handler).value(arguments.at(1).toString());
+        if(value.isValid())
+        {
+            reply = message.createReply(QVariant::fromValue(QDBusVariant(value)));
+        }
+        else
+        {
+            reply = message.createErrorReply(QDBusError::UnknownProperty, "No such property");
+        }
+    }
+    else if(member == "GetAll" && signature == "s")
+    {
+        reply = message.createReply(q->interfaceProperties(call->handler));
+    }
+    else if(member == "Set" && signature == "ssv")
+    {
+        reply = message.createErrorReply(QDBusError::PropertyReadOnly, "Voice call properties are read-only");
+    }
+    else
+    {
+        return false;
+    }
+
+    connection.send(reply);
+    return true;
+}
+
+/*!
+  Starts sending the per second durationChanged signal of \a call to the
+  client that sent \a message, until it unsubscribes or leaves the bus.
+*/
+void VoiceCallHandlerDBusObjectPrivate::subscribe(Call *call, const QDBusMessage &message, const QDBusConnection &connection)
+{
+    Q_Q(VoiceCallHandlerDBusObject);
+
+    Subscriber subscriber;
+    subscriber.connectionName = connection.name();
+    subscriber.service = message.service();
+
+    if(call->subscribers.contains(subscriber)) return;
+    call->subscribers.append(subscriber);
+    updateDurationTicks();
+
+    if(subscriber.service.isEmpty()) return;
+
+    if(!subscriberWatcher)
+    {
+        subscriberWatcher = new QDBusServiceWatcher(q);
+        subscriberWatcher->setConnection(connection);
+        subscriberWatcher->setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+        QObject::connect(subscriberWatcher, SIGNAL(serviceUnregistered(QString)), q, SLOT(onSubscriberUnregistered(QString)));
+    }
+    subscriberWatcher->addWatchedService(subscriber.service);
+}
+
+void VoiceCallHandlerDBusObjectPrivate::unsubscribe(Call *call, const QDBusMessage &message, const QDBusConnection &connection)
+{
+    Subscriber subscriber;
+    subscriber.connectionName = connection.name();
+    subscriber.service = message.service();
+
+    call->subscribers.removeAll(subscriber);
+    updateDurationTicks();
+}
+
+void VoiceCallHandlerDBusObjectPrivate::onStatusChanged(Call *call)
+{
+    call->updateTiming(call->handler->status());
+
+    // Clients compute the duration from these while the call is going on,
+    // and take the final value from the duration property once it ends.
+    propertyChanged(call, "status");
+    propertyChanged(call, "statusText");
+    propertyChanged(call, "connectedAt");
+    propertyChanged(call, "heldTime");
+    propertyChanged(call, "duration");
+
+    emitSignal(call, "statusChanged", QVariantList() << int(call->handler->status()) << call->handler->statusText());
+}
+
+void VoiceCallHandlerDBusObjectPrivate::onDurationChanged(Call *call)
+{
+    if(call->subscribers.isEmpty()) return;
+
+    QString path = call->handler->handle().path();
+    for(int i = call->subscribers.count() - 1; i >= 0; --i)
+    {
+        const Subscriber &subscriber = call->subscribers.at(i);
+        QDBusConnection connection(subscriber.connectionName);
+
+        // Peer connections have no bus name to watch, drop them once closed.
+        if(!connection.isConnected())
+        {
+            call->subscribers.removeAt(i);
+            if(call->subscribers.isEmpty()) updateDurationTicks();
+            continue;
+        }
+
+        QDBusMessage message = QDBusMessage::createTargetedSignal(subscriber.service, path,
+                                                                  VOICECALL_INTERFACE, "durationChanged");
+        message << call->handler->duration();
+        VoiceCallSignalScheduler::instance()->send(subscriber.connectionName, message);
+    }
+}
+
+/*!
+  Adds \a handler to the exported calls, which makes /calls/<id> resolve to it.
+*/
+void VoiceCallHandlerDBusObject::onVoiceCallAdded(AbstractVoiceCallHandler *handler)
+{
+    TRACE
+    Q_D(VoiceCallHandlerDBusObject);
+    quint64 handle = handler->handle().value();
+    if(d->calls.contains(handle)) return;
+
+    VoiceCallHandlerDBusObjectPrivate::Call *call = new VoiceCallHandlerDBusObjectPrivate::Call(handler);
+    d->calls.insert(handle, call);
+
+    call->connections << QObject::connect(handler, &AbstractVoiceCallHandler::statusChanged, this, [d, call]() {
+        d->onStatusChanged(call);
+    });
+    call->connections << QObject::connect(handler, &AbstractVoiceCallHandler::lineIdChanged, this, [d, call](const QString &lineId) {
+        d->notify(call, "lineId", "lineIdChanged", lineId);
+    });
+    call->connections << QObject::connect(handler, &AbstractVoiceCallHandler::startedAtChanged, this, [d, call](const QDateTime &startedAt) {
+        d->notify(call, "startedAt", "startedAtChanged", startedAt);
+    });
+    call->connections << QObject::connect(handler, &AbstractVoiceCallHandler::durationChanged, this, [d, call]() {
+        d->onDurationChanged(call);
+    });
+    call->connections << QObject::connect(handler, &AbstractVoiceCallHandler::emergencyChanged, this, [d, call](bool on) {
+        d->notify(call, "isEmergency", "emergencyChanged", on);
+    });
+    call->connections << QObject::connect(handler, &AbstractVoiceCallHandler::multipartyChanged, this, [d, call](bool on) {
+        d->notify(call, "isMultiparty", "multipartyChanged", on);
+    });
+    call->connections << QObject::connect(handler, &AbstractVoiceCallHandler::forwardedChanged, this, [d, call](bool on) {
+        d->notify(call, "isForwarded", "forwardedChanged", on);
+    });
+    call->connections << QObject::connect(handler, &AbstractVoiceCallHandler::remoteHeldChanged, this, [d, call](bool on) {
+        d->notify(call, "isRemoteHeld", "remoteHeldChanged", on);
+    });
+    call->connections << QObject::connect(handler, &AbstractVoiceCallHandler::parentHandlerIdChanged, this, [d, call](const QString &handlerId) {
+        d->notify(call, "parentHandlerId", "parentHandlerIdChanged", handlerId);
+    });
+    call->connections << QObject::connect(handler, &AbstractVoiceCallHandler::childCallsChanged, this, [d, call]() {
+        d->notify(call, "childCalls", "childCallsChanged", childCallIds(call->handler));
+    });
+
+    call->updateTiming(handler->status());
+
+    VoiceCallStats::instance()->markStage(handler, VoiceCallStats::STAGE_DBUS_REGISTERED);
+}
+
+/*!
+  Drops the call \a handlerId from the exported calls.
+*/
+void VoiceCallHandlerDBusObject::onVoiceCallRemoved(const QString &handlerId)
+{
+    TRACE
+    Q_D(VoiceCallHandlerDBusObject);
+    VoiceCallHandlerDBusObjectPrivate::Call *call = d->calls.take(VoiceCallHandle::valueOf(handlerId));
+    if(!call) return;
+
+    foreach(const QMetaObject::Connection &connection, call->connections)
+    {
+        QObject::disconnect(connection);
+    }
+
+    d->pending.removeAll(call);
+    delete call;
+    d->updateDurationTicks();
+}
+
+void VoiceCallHandlerDBusObject::onActiveVoiceCallChanged()
+{
+    TRACE
+    Q_D(VoiceCallHandlerDBusObject);
+    AbstractVoiceCallHandler *handler = d->manager->activeVoiceCall();
+    d->activeHandle = handler ? handler->handle().value() : 0;
+}
+
+void VoiceCallHandlerDBusObject::onSubscriberUnregistered(const QString &service)
+{
+    TRACE
+    Q_D(VoiceCallHandlerDBusObject);
+
+    foreach(VoiceCallHandlerDBusObjectPrivate::Call *call, d->calls)
+    {
+        for(int i = call->subscribers.count() - 1; i >= 0; --i)
+        {
+            if(call->subscribers.at(i).service == service) call->subscribers.removeAt(i);
+        }
+    }
+    d->subscriberWatcher->removeWatchedService(service);
+    d->updateDurationTicks();
+}
+
+/*!
+  Sends one PropertiesChanged signal for each call with pending changes.
+*/
+void VoiceCallHandlerDBusObject::flush()
+{
+    TRACE
+    Q_D(VoiceCallHandlerDBusObject);
+    d->flushTimer.stop();
+
+    QList<VoiceCallHandlerDBusObjectPrivate::Call*> pending;
+    pending.swap(d->pending);
+
+    foreach(VoiceCallHandlerDBusObjectPrivate::Call *call, pending)
+    {
+        QStringList names;
+        names.swap(call->changed);
+        if(!call->handler) continue;
+
+        QVariantMap properties = interfaceProperties(call->handler);
+        QVariantMap changed;
+
+        foreach(const QString &name, names)
+        {
+            changed.insert(name, properties.value(name));
+        }
+
+        d->emitSignal(call, "PropertiesChanged",
+                      QVariantList() << QString(VOICECALL_INTERFACE) << changed << QStringList(),
+                      "org.freedesktop.DBus.Properties");
+    }
+}
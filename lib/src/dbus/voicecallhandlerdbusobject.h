@@ -0,0 +1,67 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLHANDLERDBUSOBJECT_H
+#define VOICECALLHANDLERDBUSOBJECT_H
+
+#include "abstractvoicecallhandler.h"
+#include "voicecallproperties.h"
+
+#include <QDBusVirtualObject>
+
+class VoiceCallManagerInterface;
+
+class VoiceCallHandlerDBusObject : public QDBusVirtualObject
+{
+    Q_OBJECT
+
+public:
+    explicit VoiceCallHandlerDBusObject(QObject *parent = 0);
+            ~VoiceCallHandlerDBusObject();
+
+    void configure(VoiceCallManagerInterface *manager);
+
+    VoiceCallProperties properties(AbstractVoiceCallHandler *handler) const;
+    QVariantMap callProperties(AbstractVoiceCallHandler *handler) const;
+    QVariantMap interfaceProperties(AbstractVoiceCallHandler *handler) const;
+
+    qlonglong connectedAt(AbstractVoiceCallHandler *handler) const;
+    qlonglong heldTime(AbstractVoiceCallHandler *handler) const;
+
+    QString introspect(const QString &path) const;
+    bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection);
+
+protected Q_SLOTS:
+    void onVoiceCallAdded(AbstractVoiceCallHandler *handler);
+    void onVoiceCallRemoved(const QString &handlerId);
+    void onActiveVoiceCallChanged();
+
+    void onSubscriberUnregistered(const QString &service);
+
+    void flush();
+
+private:
+    class VoiceCallHandlerDBusObjectPrivate *d_ptr;
+
+    Q_DISABLE_COPY(VoiceCallHandlerDBusObject)
+    Q_DECLARE_PRIVATE(VoiceCallHandlerDBusObject)
+};
+
+#endif // VOICECALLHANDLERDBUSOBJECT_H
@@ -20,8 +20,22 @@
  */
 #include "common.h"
 #include "voicecallmanagerdbusadapter.h"
+#include "voicecallhandlerdbusobject.h"
+#include "voicecallpropertiesnotifier.h"
+#include "voicecallsignalscheduler.h"
+#include "voicecalldelayedreply.h"
 
 #include "voicecallmanagerinterface.h"
+#include "voicecallpendingoperation.h"
+
+#include <QMetaProperty>
+#include <QDBusMetaType>
+
+#define VOICECALL_MANAGER_INTERFACE "org.nemomobile.voicecall.VoiceCallManager"
+
+// How long a dial call waits for the provider, shorter than the default
+// D-Bus client timeout so that callers see why it failed.
+#define VOICECALL_DIAL_REPLY_TIMEOUT 20000
 
 /*!
   \class VoiceCallManagerDBusAdapter
@@ -33,11 +47,32 @@ class VoiceCallManagerDBusAdapterPrivate
 
 public:
     VoiceCallManagerDBusAdapterPrivate(VoiceCallManagerDBusAdapter *q)
-        : q_ptr(q), manager(NULL)
+        : q_ptr(q), manager(NULL), calls(NULL), notifier(NULL), generation(0)
     {/*...*/}
 
     VoiceCallManagerDBusAdapter *q_ptr;
     VoiceCallManagerInterface *manager;
+    VoiceCallHandlerDBusObject *calls;
+    VoiceCallPropertiesNotifier *notifier;
+
+    // Sequence number of the last CallAdded or CallRemoved signal. The upper
+    // half is the handle epoch, so numbers of a restarted daemon never repeat.
+    qulonglong generation;
+
+    QString peerAddress;
+    QDBusUnixFileDescriptor stateTable;
+
+    // The adaptor's signals are sent from here rather than relayed by QtDBus,
+    // so that on peer connections they share the queue of the other signals.
+    void sendSignal(const QString &name, const QVariantList &arguments = QVariantList())
+    {
+        foreach(const QString &connectionName, VoiceCallPropertiesNotifier::connections())
+        {
+            QDBusMessage message = QDBusMessage::createSignal("/", VOICECALL_MANAGER_INTERFACE, name);
+            message.setArguments(arguments);
+            VoiceCallSignalScheduler::instance()->send(connectionName, message);
+        }
+    }
 };
 
 /*!
@@ -47,6 +82,9 @@ VoiceCallManagerDBusAdapter::VoiceCallManagerDBusAdapter(QObject *parent)
     : QDBusAbstractAdaptor(parent), d_ptr(new VoiceCallManagerDBusAdapterPrivate(this))
 {
     TRACE
+    qDBusRegisterMetaType<VoiceCallPropertiesMap>();
+    qDBusRegisterMetaType<VoiceCallProperties>();
+    qDBusRegisterMetaType<VoiceCallPropertiesList>();
 }
 
 VoiceCallManagerDBusAdapter::~VoiceCallManagerDBusAdapter()
@@ -58,22 +96,84 @@ VoiceCallManagerDBusAdapter::~VoiceCallManagerDBusAdapter()
 
 /*!
   Configures the D-Bus adapter to work with the supplied manager. \a manager
+  Call properties are taken from \a calls, the object exporting the calls.
 */
-void VoiceCallManagerDBusAdapter::configure(VoiceCallManagerInterface *manager)
+void VoiceCallManagerDBusAdapter::configure(VoiceCallManagerInterface *manager, VoiceCallHandlerDBusObject *calls)
 {
     TRACE
     Q_D(VoiceCallManagerDBusAdapter);
     d->manager = manager;
-    QObject::connect(d->manager, SIGNAL(error(QString)), SIGNAL(error(QString)));
-    QObject::connect(d->manager, SIGNAL(providersChanged()), SIGNAL(providersChanged()));
-    QObject::connect(d->manager, SIGNAL(voiceCallsChanged()), SIGNAL(voiceCallsChanged()));
-    QObject::connect(d->manager, SIGNAL(activeVoiceCallChanged()), SIGNAL(activeVoiceCallChanged()));
-    QObject::connect(d->manager, SIGNAL(audioModeChanged()), SIGNAL(audioModeChanged()));
-    QObject::connect(d->manager, SIGNAL(audioRoutedChanged()), SIGNAL(audioRoutedChanged()));
-    QObject::connect(d->manager, SIGNAL(microphoneMutedChanged()), SIGNAL(microphoneMutedChanged()));
-    QObject::connect(d->manager, SIGNAL(speakerMutedChanged()), SIGNAL(speakerMutedChanged()));
-    QObject::connect(d->manager, SIGNAL(totalOutgoingCallDurationChanged()), SIGNAL(totalOutgoingCallDurationChanged()));
-    QObject::connect(d->manager, SIGNAL(totalIncomingCallDurationChanged()), SIGNAL(totalIncomingCallDurationChanged()));
+    d->calls = calls;
+    d->generation = qulonglong(manager->handleEpoch()) << 32;
+    QObject::connect(d->manager, SIGNAL(error(QString)), SLOT(onManagerError(QString)));
+    QObject::connect(d->manager, SIGNAL(providersChanged()), SLOT(onManagerChanged()));
+    QObject::connect(d->manager, SIGNAL(voiceCallsChanged()), SLOT(onManagerChanged()));
+    QObject::connect(d->manager, SIGNAL(activeVoiceCallChanged()), SLOT(onManagerChanged()));
+    QObject::connect(d->manager, SIGNAL(audioModeChanged()), SLOT(onManagerChanged()));
+    QObject::connect(d->manager, SIGNAL(audioRoutedChanged()), SLOT(onManagerChanged()));
+    QObject::connect(d->manager, SIGNAL(microphoneMutedChanged()), SLOT(onManagerChanged()));
+    QObject::connect(d->manager, SIGNAL(speakerMutedChanged()), SLOT(onManagerChanged()));
+    QObject::connect(d->manager, SIGNAL(totalOutgoingCallDurationChanged()), SLOT(onManagerChanged()));
+    QObject::connect(d->manager, SIGNAL(totalIncomingCallDurationChanged()), SLOT(onManagerChanged()));
+
+    QObject::connect(d->manager, SIGNAL(voiceCallAdded(AbstractVoiceCallHandler*)), SLOT(onVoiceCallAdded(AbstractVoiceCallHandler*)));
+    QObject::connect(d->manager, SIGNAL(voiceCallRemoved(QString)), SLOT(onVoiceCallRemoved(QString)));
+
+    d->notifier = new VoiceCallPropertiesNotifier(this, "/");
+}
+
+/*!
+  Returns the PropertiesChanged notifier of the manager object.
+*/
+VoiceCallPropertiesNotifier* VoiceCallManagerDBusAdapter::notifier() const
+{
+    Q_D(const VoiceCallManagerDBusAdapter);
+    return d->notifier;
+}
+
+/*!
+  Sets the address of the daemon's private peer to peer socket, returned by
+  GetPeerAddress().
+*/
+void VoiceCallManagerDBusAdapter::setPeerAddress(const QString &address)
+{
+    TRACE
+    Q_D(VoiceCallManagerDBusAdapter);
+    d->peerAddress = address;
+}
+
+/*!
+  Returns the address a client can connect to with a direct D-Bus peer
+  connection, which exports the same objects as the session bus, or an empty
+  string if there is none.
+*/
+QString VoiceCallManagerDBusAdapter::GetPeerAddress()
+{
+    TRACE
+    Q_D(const VoiceCallManagerDBusAdapter);
+    return d->peerAddress;
+}
+
+/*!
+  Sets the read-only descriptor of the shared call state table returned by
+  GetStateTable(). The descriptor is duplicated.
+*/
+void VoiceCallManagerDBusAdapter::setStateTable(int fd)
+{
+    TRACE
+    Q_D(VoiceCallManagerDBusAdapter);
+    d->stateTable.setFileDescriptor(fd);
+}
+
+/*!
+  Returns a read-only descriptor of the shared call state table, to be mapped
+  with VoiceCallStateTable, or an invalid descriptor if there is none.
+*/
+QDBusUnixFileDescriptor VoiceCallManagerDBusAdapter::GetStateTable()
+{
+    TRACE
+    Q_D(const VoiceCallManagerDBusAdapter);
+    return d->stateTable;
 }
 
 /*!
@@ -110,6 +210,51 @@ QStringList VoiceCallManagerDBusAdapter::voiceCalls() const
     return results;
 }
 
+/*!
+  Returns the properties of all current voice calls keyed by handler id, so
+  that a client can sync in a single call. \a generation is set to the
+  sequence number of the last CallAdded or CallRemoved signal; later signals
+  continue from it, so a client can tell when it has missed one. Its upper
+  32 bits identify the daemon instance, they differ after a restart.
+
+  \sa VoiceCallHandlerDBusObject::callProperties()
+*/
+VoiceCallPropertiesMap VoiceCallManagerDBusAdapter::GetCalls(qulonglong &generation)
+{
+    TRACE
+    Q_D(VoiceCallManagerDBusAdapter);
+    VoiceCallPropertiesMap results;
+
+    foreach(AbstractVoiceCallHandler *handler, d->manager->voiceCalls())
+    {
+        results.insert(handler->handlerId(), d->calls->callProperties(handler));
+    }
+
+    generation = d->generation;
+    return results;
+}
+
+/*!
+  Like GetCalls(), but returns the calls as a list of typed structs, which
+  is cheaper to marshal and read than the nested maps.
+
+  \sa VoiceCallHandlerDBusObject::properties()
+*/
+VoiceCallPropertiesList VoiceCallManagerDBusAdapter::GetCallList(qulonglong &generation)
+{
+    TRACE
+    Q_D(VoiceCallManagerDBusAdapter);
+    VoiceCallPropertiesList results;
+
+    foreach(AbstractVoiceCallHandler *handler, d->manager->voiceCalls())
+    {
+        results.append(d->calls->properties(handler));
+    }
+
+    generation = d->generation;
+    return results;
+}
+
 /*!
   Returns the currently active voice call handler id.
 */
@@ -248,15 +393,21 @@ bool VoiceCallManagerDBusAdapter::setMuteSpeaker(bool on)
 
 /*!
   Initiates dialing a number using the provided providerId, and msisdn (phone number)
+
+  The D-Bus reply is only sent once the provider's backend has accepted the
+  request. A rejected request is answered with an error carrying the reason,
+  instead of being reported through the error() signal.
 */
 bool VoiceCallManagerDBusAdapter::dial(const QString &provider, const QString &msisdn)
 {
     TRACE
     Q_D(VoiceCallManagerDBusAdapter);
-    if(!d->manager->dial(provider, msisdn))
+    VoiceCallPendingOperation *operation = d->manager->requestDial(provider, msisdn);
+
+    if(calledFromDBus())
     {
-        emit this->error(d->manager->errorString());
-        return false;
+        setDelayedReply(true);
+        VoiceCallDelayedReply::send(operation, message(), connection(), VOICECALL_DIAL_REPLY_TIMEOUT);
     }
 
     return true;
@@ -293,3 +444,57 @@ bool VoiceCallManagerDBusAdapter::stopDtmfTone()
     d->manager->stopDtmfTone();
     return true;
 }
+
+/*!
+  Sends CallAdded with the next sequence number and the properties of \a handler.
+*/
+void VoiceCallManagerDBusAdapter::onVoiceCallAdded(AbstractVoiceCallHandler *handler)
+{
+    TRACE
+    Q_D(VoiceCallManagerDBusAdapter);
+    d->sendSignal("CallAdded", QVariantList() << ++d->generation << handler->handlerId()
+                                              << d->calls->callProperties(handler));
+}
+
+/*!
+  Sends CallRemoved with the next sequence number.
+*/
+void VoiceCallManagerDBusAdapter::onVoiceCallRemoved(const QString &handlerId)
+{
+    TRACE
+    Q_D(VoiceCallManagerDBusAdapter);
+    d->sendSignal("CallRemoved", QVariantList() << ++d->generation << handlerId);
+}
+
+/*!
+  Sends the change signal of the same name as the manager signal that invoked
+  this slot, and marks the properties it notifies as changed.
+*/
+void VoiceCallManagerDBusAdapter::onManagerChanged()
+{
+    TRACE
+    Q_D(VoiceCallManagerDBusAdapter);
+    QByteArray name = sender()->metaObject()->method(senderSignalIndex()).name();
+    const QMetaObject *mo = metaObject();
+
+    for(int i = mo->propertyOffset(); i < mo->propertyCount(); ++i)
+    {
+        QMetaProperty property = mo->property(i);
+        if(property.hasNotifySignal() && property.notifySignal().name() == name)
+        {
+            d->notifier->propertyChanged(QString::fromLatin1(property.name()));
+        }
+    }
+
+    d->sendSignal(QString::fromLatin1(name));
+}
+
+/*!
+  Sends the error signal with \a message.
+*/
+void VoiceCallManagerDBusAdapter::onManagerError(const QString &message)
+{
+    TRACE
+    Q_D(VoiceCallManagerDBusAdapter);
+    d->sendSignal("error", QVariantList() << message);
+}
@@ -23,13 +23,19 @@
 
 #include <QStringList>
 #include <QDBusAbstractAdaptor>
+#include <QDBusContext>
+#include <QDBusUnixFileDescriptor>
 
 #include "abstractvoicecallhandler.h"
 #include "voicecallmanagerinterface.h"
+#include "voicecalldbustypes.h"
+#include "voicecallproperties.h"
 
 class VoiceCallManager;
+class VoiceCallPropertiesNotifier;
+class VoiceCallHandlerDBusObject;
 
-class VoiceCallManagerDBusAdapter : public QDBusAbstractAdaptor
+class VoiceCallManagerDBusAdapter : public QDBusAbstractAdaptor, protected QDBusContext
 {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.nemomobile.voicecall.VoiceCallManager")
@@ -50,7 +56,12 @@ public:
     explicit VoiceCallManagerDBusAdapter(QObject *parent = 0);
             ~VoiceCallManagerDBusAdapter();
 
-    void configure(VoiceCallManagerInterface *manager);
+    void configure(VoiceCallManagerInterface *manager, VoiceCallHandlerDBusObject *calls);
+
+    VoiceCallPropertiesNotifier* notifier() const;
+
+    void setPeerAddress(const QString &address);
+    void setStateTable(int fd);
 
     QStringList providers() const;
     QStringList voiceCalls() const;
@@ -65,6 +76,8 @@ public:
     int totalOutgoingCallDuration() const;
     int totalIncomingCallDuration() const;
 
+    // Never emitted, declared for introspection only. The adapter sends them
+    // through VoiceCallSignalScheduler.
 Q_SIGNALS:
     void error(const QString &message);
     void providersChanged();
@@ -80,6 +93,9 @@ Q_SIGNALS:
     void totalOutgoingCallDurationChanged();
     void totalIncomingCallDurationChanged();
 
+    void CallAdded(qulonglong sequence, const QString &handlerId, const QVariantMap &properties);
+    void CallRemoved(qulonglong sequence, const QString &handlerId);
+
 public Q_SLOTS:
     bool dial(const QString &provider, const QString &msisdn);
 
@@ -96,6 +112,18 @@ public Q_SLOTS:
 
     void resetCallDurationCounters();
 
+    VoiceCallPropertiesMap GetCalls(qulonglong &generation);
+    VoiceCallPropertiesList GetCallList(qulonglong &generation);
+    QString GetPeerAddress();
+    QDBusUnixFileDescriptor GetStateTable();
+
+private Q_SLOTS:
+    void onVoiceCallAdded(AbstractVoiceCallHandler *handler);
+    void onVoiceCallRemoved(const QString &handlerId);
+
+    void onManagerChanged();
+    void onManagerError(const QString &message);
+
 private:
     class VoiceCallManagerDBusAdapterPrivate *d_ptr;
 
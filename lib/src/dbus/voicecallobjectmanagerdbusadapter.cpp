@@ -0,0 +1,139 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "common.h"
+#include "voicecallobjectmanagerdbusadapter.h"
+#include "voicecallhandlerdbusobject.h"
+#include "voicecallpropertiesnotifier.h"
+#include "voicecallsignalscheduler.h"
+
+#include "voicecallmanagerinterface.h"
+
+#include <QDBusMetaType>
+
+#define VOICECALL_INTERFACE "org.nemomobile.voicecall.VoiceCall"
+#define OBJECT_MANAGER_INTERFACE "org.freedesktop.DBus.ObjectManager"
+
+/*!
+  \class VoiceCallObjectManagerDBusAdapter
+  \brief Implements org.freedesktop.DBus.ObjectManager on the manager root object.
+
+  Lets generic D-Bus clients discover the call objects under /calls, with all
+  their properties, from a single GetManagedObjects() call and then follow
+  InterfacesAdded and InterfacesRemoved. The /calls/active alias is not
+  reported, it is the same object as one of the calls.
+*/
+class VoiceCallObjectManagerDBusAdapterPrivate
+{
+    Q_DECLARE_PUBLIC(VoiceCallObjectManagerDBusAdapter)
+
+public:
+    VoiceCallObjectManagerDBusAdapterPrivate(VoiceCallObjectManagerDBusAdapter *q)
+        : q_ptr(q), manager(NULL), calls(NULL)
+    {/*...*/}
+
+    VoiceCallObjectManagerDBusAdapter *q_ptr;
+    VoiceCallManagerInterface *manager;
+    VoiceCallHandlerDBusObject *calls;
+
+    VoiceCallPropertiesMap interfaces(AbstractVoiceCallHandler *handler) const
+    {
+        VoiceCallPropertiesMap results;
+        results.insert(VOICECALL_INTERFACE, calls->interfaceProperties(handler));
+        return results;
+    }
+
+    // Sent through the scheduler rather than relayed by QtDBus, so that peer
+    // connections get them in order with the call's own signals.
+    void sendSignal(const QString &name, const QVariantList &arguments)
+    {
+        foreach(const QString &connectionName, VoiceCallPropertiesNotifier::connections())
+        {
+            QDBusMessage message = QDBusMessage::createSignal("/", OBJECT_MANAGER_INTERFACE, name);
+            message.setArguments(arguments);
+            VoiceCallSignalScheduler::instance()->send(connectionName, message);
+        }
+    }
+};
+
+/*!
+  Constructs a new object manager adapter, to be attached to the manager root object.
+*/
+VoiceCallObjectManagerDBusAdapter::VoiceCallObjectManagerDBusAdapter(QObject *parent)
+    : QDBusAbstractAdaptor(parent), d_ptr(new VoiceCallObjectManagerDBusAdapterPrivate(this))
+{
+    TRACE
+    qDBusRegisterMetaType<VoiceCallPropertiesMap>();
+    qDBusRegisterMetaType<VoiceCallManagedObjects>();
+}
+
+VoiceCallObjectManagerDBusAdapter::~VoiceCallObjectManagerDBusAdapter()
+{
+    TRACE
+    Q_D(VoiceCallObjectManagerDBusAdapter);
+    delete d;
+}
+
+/*!
+  Configures the adapter to report the calls of \a manager, as exported by \a calls.
+*/
+void VoiceCallObjectManagerDBusAdapter::configure(VoiceCallManagerInterface *manager, VoiceCallHandlerDBusObject *calls)
+{
+    TRACE
+    Q_D(VoiceCallObjectManagerDBusAdapter);
+    d->manager = manager;
+    d->calls = calls;
+
+    QObject::connect(d->manager, SIGNAL(voiceCallAdded(AbstractVoiceCallHandler*)), SLOT(onVoiceCallAdded(AbstractVoiceCallHandler*)));
+    QObject::connect(d->manager, SIGNAL(voiceCallRemoved(QString)), SLOT(onVoiceCallRemoved(QString)));
+}
+
+/*!
+  Returns every call object with the properties of its interfaces.
+*/
+VoiceCallManagedObjects VoiceCallObjectManagerDBusAdapter::GetManagedObjects()
+{
+    TRACE
+    Q_D(VoiceCallObjectManagerDBusAdapter);
+    VoiceCallManagedObjects results;
+
+    foreach(AbstractVoiceCallHandler *handler, d->manager->voiceCalls())
+    {
+        results.insert(QDBusObjectPath(handler->handle().path()), d->interfaces(handler));
+    }
+
+    return results;
+}
+
+void VoiceCallObjectManagerDBusAdapter::onVoiceCallAdded(AbstractVoiceCallHandler *handler)
+{
+    TRACE
+    Q_D(VoiceCallObjectManagerDBusAdapter);
+    d->sendSignal("InterfacesAdded", QVariantList() << QVariant::fromValue(QDBusObjectPath(handler->handle().path()))
+                                                    << QVariant::fromValue(d->interfaces(handler)));
+}
+
+void VoiceCallObjectManagerDBusAdapter::onVoiceCallRemoved(const QString &handlerId)
+{
+    TRACE
+    Q_D(VoiceCallObjectManagerDBusAdapter);
+    d->sendSignal("InterfacesRemoved", QVariantList() << QVariant::fromValue(QDBusObjectPath(VoiceCallHandle::fromString(handlerId).path()))
+                                                      << QVariant(QStringList() << VOICECALL_INTERFACE));
+}
@@ -0,0 +1,63 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLOBJECTMANAGERDBUSADAPTER_H
+#define VOICECALLOBJECTMANAGERDBUSADAPTER_H
+
+#include <QDBusAbstractAdaptor>
+#include <QDBusObjectPath>
+#include <QStringList>
+
+#include "abstractvoicecallhandler.h"
+#include "voicecalldbustypes.h"
+
+class VoiceCallManagerInterface;
+class VoiceCallHandlerDBusObject;
+
+class VoiceCallObjectManagerDBusAdapter : public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.DBus.ObjectManager")
+
+public:
+    explicit VoiceCallObjectManagerDBusAdapter(QObject *parent = 0);
+            ~VoiceCallObjectManagerDBusAdapter();
+
+    void configure(VoiceCallManagerInterface *manager, VoiceCallHandlerDBusObject *calls);
+
+    // Never emitted, declared for introspection only.
+Q_SIGNALS:
+    void InterfacesAdded(const QDBusObjectPath &path, const VoiceCallPropertiesMap &interfaces);
+    void InterfacesRemoved(const QDBusObjectPath &path, const QStringList &interfaces);
+
+public Q_SLOTS:
+    VoiceCallManagedObjects GetManagedObjects();
+
+private Q_SLOTS:
+    void onVoiceCallAdded(AbstractVoiceCallHandler *handler);
+    void onVoiceCallRemoved(const QString &handlerId);
+
+private:
+    class VoiceCallObjectManagerDBusAdapterPrivate *d_ptr;
+
+    Q_DECLARE_PRIVATE(VoiceCallObjectManagerDBusAdapter)
+};
+
+#endif // VOICECALLOBJECTMANAGERDBUSADAPTER_H
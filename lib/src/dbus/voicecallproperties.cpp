@@ -0,0 +1,144 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "voicecallproperties.h"
+
+VoiceCallProperties::VoiceCallProperties()
+    : version(Version), status(0), startedAt(0), duration(0), connectedAt(0), heldTime(0),
+      isIncoming(false), isEmergency(false), isMultiparty(false), isForwarded(false),
+      isRemoteHeld(false)
+{/*...*/}
+
+/*!
+  Returns the properties as the a{sv} map of getProperties().
+*/
+QVariantMap VoiceCallProperties::toMap() const
+{
+    QVariantMap props;
+
+    props.insert("handlerId", QVariant(handlerId));
+    props.insert("providerId", QVariant(providerId));
+    props.insert("status", QVariant(status));
+    props.insert("statusText", QVariant(statusText));
+    props.insert("lineId", QVariant(lineId));
+    props.insert("startedAt", QVariant(startedAt));
+    props.insert("duration", QVariant(duration));
+    props.insert("connectedAt", QVariant(connectedAt));
+    props.insert("heldTime", QVariant(heldTime));
+    props.insert("isIncoming", QVariant(isIncoming));
+    props.insert("isEmergency", QVariant(isEmergency));
+    props.insert("isMultiparty", QVariant(isMultiparty));
+    props.insert("isForwarded", QVariant(isForwarded));
+    props.insert("isRemoteHeld", QVariant(isRemoteHeld));
+    props.insert("parentHandlerId", QVariant(parentHandlerId));
+    props.insert("childCalls", QVariant(childCalls));
+
+    return props;
+}
+
+/*!
+  Reads the properties from an a{sv} \a map, as sent with CallAdded.
+*/
+VoiceCallProperties VoiceCallProperties::fromMap(const QVariantMap &map)
+{
+    VoiceCallProperties properties;
+
+    properties.handlerId = map.value("handlerId").toString();
+    properties.providerId = map.value("providerId").toString();
+    properties.status = map.value("status").toInt();
+    properties.statusText = map.value("statusText").toString();
+    properties.lineId = map.value("lineId").toString();
+    properties.startedAt = map.value("startedAt").toLongLong();
+    properties.duration = map.value("duration").toInt();
+    properties.connectedAt = map.value("connectedAt").toLongLong();
+    properties.heldTime = map.value("heldTime").toLongLong();
+    properties.isIncoming = map.value("isIncoming").toBool();
+    properties.isEmergency = map.value("isEmergency").toBool();
+    properties.isMultiparty = map.value("isMultiparty").toBool();
+    properties.isForwarded = map.value("isForwarded").toBool();
+    properties.isRemoteHeld = map.value("isRemoteHeld").toBool();
+    properties.parentHandlerId = map.value("parentHandlerId").toString();
+    properties.childCalls = map.value("childCalls").toStringList();
+
+    return properties;
+}
+
+QDBusArgument &operator<<(QDBusArgument &argument, const VoiceCallProperties &properties)
+{
+    argument.beginStructure();
+    argument << properties.version
+             << properties.handlerId
+             << properties.providerId
+             << properties.status
+             << properties.statusText
+             << properties.lineId
+             << properties.startedAt
+             << properties.duration
+             << properties.connectedAt
+             << properties.heldTime
+             << properties.isIncoming
+             << properties.isEmergency
+             << properties.isMultiparty
+             << properties.isForwarded
+             << properties.isRemoteHeld
+             << properties.parentHandlerId
+             << properties.childCalls;
+    argument.endStructure();
+    return argument;
+}
+
+/*!
+  Reads a struct of the current version. Of any other version only the
+  version is read, the remaining fields keep their defaults and isValid()
+  returns false, so that the caller can fall back to the a{sv} form.
+*/
+const QDBusArgument &operator>>(const QDBusArgument &argument, VoiceCallProperties &properties)
+{
+    argument.beginStructure();
+    argument >> properties.version;
+
+    if(properties.version != uint(VoiceCallProperties::Version))
+    {
+        uint version = properties.version;
+        properties = VoiceCallProperties();
+        properties.version = version;
+        argument.endStructure();
+        return argument;
+    }
+
+    argument >> properties.handlerId
+             >> properties.providerId
+             >> properties.status
+             >> properties.statusText
+             >> properties.lineId
+             >> properties.startedAt
+             >> properties.duration
+             >> properties.connectedAt
+             >> properties.heldTime
+             >> properties.isIncoming
+             >> properties.isEmergency
+             >> properties.isMultiparty
+             >> properties.isForwarded
+             >> properties.isRemoteHeld
+             >> properties.parentHandlerId
+             >> properties.childCalls;
+    argument.endStructure();
+    return argument;
+}
@@ -0,0 +1,84 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLPROPERTIES_H
+#define VOICECALLPROPERTIES_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <QMetaType>
+#include <QDBusArgument>
+
+// D-Bus signature of VoiceCallProperties, fixed for each version.
+#define VOICECALL_PROPERTIES_SIGNATURE "(ussissxixxbbbbbsas)"
+
+/*
+ * The properties of one call, marshalled as a D-Bus struct.
+ *
+ * This carries the same values as the a{sv} map of getProperties(), without
+ * a key and a variant per property, so that neither side boxes or looks up
+ * fields by name. The struct layout never changes within a version; a new
+ * version adds its fields at the end and is served by new methods, so that
+ * older clients keep getting the layout they know.
+ *
+ * Shared by the daemon and the QML plugin, which compiles voicecallproperties.cpp
+ * itself.
+ */
+struct VoiceCallProperties
+{
+    enum { Version = 1 };
+
+    VoiceCallProperties();
+
+    // A struct of an unknown version is read as its version only.
+    bool isValid() const { return version == Version && !handlerId.isEmpty(); }
+
+    QVariantMap toMap() const;
+    static VoiceCallProperties fromMap(const QVariantMap &map);
+
+    uint version;
+    QString handlerId;
+    QString providerId;
+    int status;
+    QString statusText;
+    QString lineId;
+    qlonglong startedAt;    // milliseconds since the epoch
+    int duration;           // seconds
+    qlonglong connectedAt;  // CLOCK_BOOTTIME milliseconds, 0 if never connected
+    qlonglong heldTime;     // milliseconds
+    bool isIncoming;
+    bool isEmergency;
+    bool isMultiparty;
+    bool isForwarded;
+    bool isRemoteHeld;
+    QString parentHandlerId;
+    QStringList childCalls;
+};
+
+typedef QList<VoiceCallProperties> VoiceCallPropertiesList;
+
+QDBusArgument &operator<<(QDBusArgument &argument, const VoiceCallProperties &properties);
+const QDBusArgument &operator>>(const QDBusArgument &argument, VoiceCallProperties &properties);
+
+Q_DECLARE_METATYPE(VoiceCallProperties)
+Q_DECLARE_METATYPE(VoiceCallPropertiesList)
+
+#endif // VOICECALLPROPERTIES_H
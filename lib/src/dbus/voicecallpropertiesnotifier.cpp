@@ -0,0 +1,254 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "common.h"
+#include "voicecallpropertiesnotifier.h"
+#include "voicecallsignalscheduler.h"
+
+#include <QTimer>
+#include <QHash>
+#include <QMetaProperty>
+#include <QDBusMessage>
+#include <QDBusAbstractAdaptor>
+
+/*!
+  \class VoiceCallPropertiesNotifier
+  \brief Emits org.freedesktop.DBus.Properties.PropertiesChanged for a D-Bus adaptor.
+
+  The notifier watches the NOTIFY signals of the adaptor's properties and
+  collects the names of the properties that changed. Once per event loop
+  iteration it reads their current values and sends a single PropertiesChanged
+  signal carrying them, so that a client can keep a local copy of the object
+  without issuing a Get for every change.
+*/
+class VoiceCallPropertiesNotifierPrivate
+{
+    Q_DECLARE_PUBLIC(VoiceCallPropertiesNotifier)
+
+public:
+    VoiceCallPropertiesNotifierPrivate(VoiceCallPropertiesNotifier *q, QDBusAbstractAdaptor *pAdaptor)
+        : q_ptr(q), adaptor(pAdaptor)
+    {/*...*/}
+
+    VoiceCallPropertiesNotifier *q_ptr;
+
+    QDBusAbstractAdaptor *adaptor;
+
+    QString interfaceName;
+    QStringList paths;
+
+    // Notify signal index -> names of the properties it notifies.
+    QHash<int, QStringList> notifyProperties;
+
+    QStringList changed;
+    QStringList invalidated;
+
+    QTimer flushTimer;
+
+    void schedule()
+    {
+        if(!flushTimer.isActive()) flushTimer.start();
+    }
+};
+
+// Names of the connections every notifier sends on: the session bus, plus
+// any peer connections of the daemon.
+Q_GLOBAL_STATIC_WITH_ARGS(QStringList, notifierConnections, (QStringList() << QDBusConnection::sessionBus().name()))
+
+/*!
+  Constructs a notifier for the properties of \a adaptor, which is exported at
+  \a path. The notifier is owned by the adaptor.
+*/
+VoiceCallPropertiesNotifier::VoiceCallPropertiesNotifier(QDBusAbstractAdaptor *adaptor, const QString &path)
+    : QObject(adaptor), d_ptr(new VoiceCallPropertiesNotifierPrivate(this, adaptor))
+{
+    TRACE
+    Q_D(VoiceCallPropertiesNotifier);
+    const QMetaObject *mo = adaptor->metaObject();
+
+    d->interfaceName = QString::fromLatin1(mo->classInfo(mo->indexOfClassInfo("D-Bus Interface")).value());
+    d->paths.append(path);
+
+    d->flushTimer.setSingleShot(true);
+    d->flushTimer.setInterval(0);
+    QObject::connect(&d->flushTimer, SIGNAL(timeout()), SLOT(flush()));
+
+    QMetaMethod slot = staticMetaObject.method(staticMetaObject.indexOfSlot("onNotifySignal()"));
+
+    for(int i = mo->propertyOffset(); i < mo->propertyCount(); ++i)
+    {
+        QMetaProperty property = mo->property(i);
+        if(!property.hasNotifySignal()) continue;
+
+        int index = property.notifySignalIndex();
+        if(!d->notifyProperties.contains(index))
+        {
+            QObject::connect(adaptor, property.notifySignal(), this, slot);
+        }
+        d->notifyProperties[index].append(QString::fromLatin1(property.name()));
+    }
+}
+
+VoiceCallPropertiesNotifier::~VoiceCallPropertiesNotifier()
+{
+    TRACE
+    Q_D(VoiceCallPropertiesNotifier);
+    delete d;
+}
+
+/*!
+  Also sends the signals of all notifiers on \a connection, where the objects
+  have to be registered at the same paths.
+*/
+void VoiceCallPropertiesNotifier::addConnection(const QDBusConnection &connection)
+{
+    TRACE_STATIC
+    if(!notifierConnections->contains(connection.name())) notifierConnections->append(connection.name());
+}
+
+/*!
+  Stops sending on the connection named \a name.
+*/
+void VoiceCallPropertiesNotifier::removeConnection(const QString &name)
+{
+    TRACE_STATIC
+    notifierConnections->removeAll(name);
+    VoiceCallSignalScheduler::instance()->removeConnection(name);
+}
+
+/*!
+  Returns the names of the connections the notifiers send on.
+*/
+QStringList VoiceCallPropertiesNotifier::connections()
+{
+    return *notifierConnections;
+}
+
+/*!
+  Returns the D-Bus interface name the properties belong to.
+*/
+QString VoiceCallPropertiesNotifier::interfaceName() const
+{
+    Q_D(const VoiceCallPropertiesNotifier);
+    return d->interfaceName;
+}
+
+/*!
+  Returns the object paths the signal is emitted on.
+*/
+QStringList VoiceCallPropertiesNotifier::paths() const
+{
+    Q_D(const VoiceCallPropertiesNotifier);
+    return d->paths;
+}
+
+/*!
+  Also emits the signal on \a path, for objects exported under an alias.
+*/
+void VoiceCallPropertiesNotifier::addPath(const QString &path)
+{
+    TRACE
+    Q_D(VoiceCallPropertiesNotifier);
+    if(!d->paths.contains(path)) d->paths.append(path);
+}
+
+/*!
+  Stops emitting the signal on \a path.
+*/
+void VoiceCallPropertiesNotifier::removePath(const QString &path)
+{
+    TRACE
+    Q_D(VoiceCallPropertiesNotifier);
+    d->paths.removeAll(path);
+}
+
+/*!
+  Marks the property \a name as changed, for properties without a NOTIFY signal.
+*/
+void VoiceCallPropertiesNotifier::propertyChanged(const QString &name)
+{
+    Q_D(VoiceCallPropertiesNotifier);
+    d->invalidated.removeAll(name);
+    if(!d->changed.contains(name)) d->changed.append(name);
+    d->schedule();
+}
+
+/*!
+  Marks the property \a name as changed without sending its value, clients
+  have to Get it if they are interested.
+*/
+void VoiceCallPropertiesNotifier::propertyInvalidated(const QString &name)
+{
+    Q_D(VoiceCallPropertiesNotifier);
+    d->changed.removeAll(name);
+    if(!d->invalidated.contains(name)) d->invalidated.append(name);
+    d->schedule();
+}
+
+/*!
+  Sends the pending changes now, with the current property values.
+*/
+void VoiceCallPropertiesNotifier::flush()
+{
+    TRACE
+    Q_D(VoiceCallPropertiesNotifier);
+    d->flushTimer.stop();
+
+    if(d->changed.isEmpty() && d->invalidated.isEmpty()) return;
+
+    QVariantMap changed;
+    QStringList invalidated = d->invalidated;
+
+    foreach(const QString &name, d->changed)
+    {
+        QVariant value = d->adaptor->property(name.toLatin1().constData());
+        if(value.isValid())
+        {
+            changed.insert(name, value);
+        }
+        else if(!invalidated.contains(name))
+        {
+            invalidated.append(name);
+        }
+    }
+
+    d->changed.clear();
+    d->invalidated.clear();
+
+    foreach(const QString &name, *notifierConnections)
+    {
+        foreach(const QString &path, d->paths)
+        {
+            QDBusMessage message = QDBusMessage::createSignal(path, "org.freedesktop.DBus.Properties", "PropertiesChanged");
+            message << d->interfaceName << changed << invalidated;
+
+            VoiceCallSignalScheduler::instance()->send(name, message);
+        }
+    }
+}
+
+void VoiceCallPropertiesNotifier::onNotifySignal()
+{
+    Q_D(VoiceCallPropertiesNotifier);
+    foreach(const QString &name, d->notifyProperties.value(senderSignalIndex()))
+    {
+        propertyChanged(name);
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLPROPERTIESNOTIFIER_H
+#define VOICECALLPROPERTIESNOTIFIER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QDBusConnection>
+
+class QDBusAbstractAdaptor;
+
+class VoiceCallPropertiesNotifier : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit VoiceCallPropertiesNotifier(QDBusAbstractAdaptor *adaptor, const QString &path);
+            ~VoiceCallPropertiesNotifier();
+
+    QString interfaceName() const;
+    QStringList paths() const;
+
+    void addPath(const QString &path);
+    void removePath(const QString &path);
+
+    void propertyChanged(const QString &name);
+    void propertyInvalidated(const QString &name);
+
+    static void addConnection(const QDBusConnection &connection);
+    static void removeConnection(const QString &name);
+    static QStringList connections();
+
+public Q_SLOTS:
+    void flush();
+
+protected Q_SLOTS:
+    void onNotifySignal();
+
+private:
+    class VoiceCallPropertiesNotifierPrivate *d_ptr;
+
+    Q_DISABLE_COPY(VoiceCallPropertiesNotifier)
+    Q_DECLARE_PRIVATE(VoiceCallPropertiesNotifier)
+};
+
+#endif // VOICECALLPROPERTIESNOTIFIER_H
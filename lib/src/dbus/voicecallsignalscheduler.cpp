@@ -0,0 +1,347 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "common.h"
+#include "voicecallsignalscheduler.h"
+
+#include <QHash>
+#include <QTimer>
+#include <QStringList>
+#include <QDBusConnection>
+#include <QDBusPendingCall>
+#include <QDBusPendingCallWatcher>
+
+// How long a peer has to answer a Ping before it is considered stalled, and
+// the longest interval the Ping is repeated in while it stays that way.
+#define VOICECALL_PEER_PING_TIMEOUT 5000
+#define VOICECALL_PEER_PING_MAX_TIMEOUT 60000
+
+// The most signals held back for a peer. Events can not be coalesced, a peer
+// that lets more of them pile up is disconnected and has to resync.
+#define VOICECALL_PEER_MAX_QUEUE 512
+
+/*!
+  \class VoiceCallSignalScheduler
+  \brief Paces the signals sent to each peer connection.
+*/
+class VoiceCallSignalSchedulerPrivate
+{
+    Q_DECLARE_PUBLIC(VoiceCallSignalScheduler)
+
+public:
+    struct Entry
+    {
+        QString key;
+        QDBusMessage signal;
+    };
+
+    struct Peer
+    {
+        Peer()
+            : waiting(false), pingTimeout(VOICECALL_PEER_PING_TIMEOUT),
+              maxDepth(0), sent(0), coalesced(0)
+        {/*...*/}
+
+        QList<Entry> queue;
+
+        // Set from sending a batch until the peer answered the Ping after it.
+        bool waiting;
+        int pingTimeout;
+
+        int maxDepth;
+        quint64 sent;
+        quint64 coalesced;
+    };
+
+    VoiceCallSignalSchedulerPrivate(VoiceCallSignalScheduler *q)
+        : q_ptr(q)
+    {/*...*/}
+
+    VoiceCallSignalScheduler *q_ptr;
+
+    QHash<QString, Peer> peers;
+    QTimer dispatchTimer;
+
+    void ping(const QString &connectionName, Peer &peer);
+    void onPingFinished(const QString &connectionName, bool ok);
+};
+
+// Signals reporting something that happened rather than a state, every one
+// of them has to be delivered, in order.
+static bool isEvent(const QDBusMessage &signal)
+{
+    static const QStringList events = QStringList()
+            << "CallAdded" << "CallRemoved" << "error"
+            << "InterfacesAdded" << "InterfacesRemoved";
+    return events.contains(signal.member());
+}
+
+// Signals with the same key carry the same property or state, so only the
+// latest of them has to be delivered. Events have no key.
+static QString signalKey(const QDBusMessage &signal)
+{
+    if(isEvent(signal)) return QString();
+
+    QString key = signal.service() + QLatin1Char(' ') + signal.path() + QLatin1Char(' ')
+                + signal.interface() + QLatin1Char('.') + signal.member();
+
+    // PropertiesChanged is kept per interface, and merged rather than replaced.
+    if(signal.member() == QLatin1String("PropertiesChanged") && !signal.arguments().isEmpty())
+    {
+        key += QLatin1Char(' ') + signal.arguments().at(0).toString();
+    }
+    return key;
+}
+
+static QDBusMessage mergePropertiesChanged(const QDBusMessage &older, const QDBusMessage &newer)
+{
+    QVariantList olderArguments = older.arguments();
+    QVariantList newerArguments = newer.arguments();
+    if(olderArguments.count() != 3 || newerArguments.count() != 3) return newer;
+
+    QVariantMap changed = olderArguments.at(1).toMap();
+    QStringList invalidated = olderArguments.at(2).toStringList();
+
+    QVariantMap newerChanged = newerArguments.at(1).toMap();
+    for(QVariantMap::const_iterator it = newerChanged.constBegin(); it != newerChanged.constEnd(); ++it)
+    {
+        changed.insert(it.key(), it.value());
+        invalidated.removeAll(it.key());
+    }
+
+    foreach(const QString &name, newerArguments.at(2).toStringList())
+    {
+        changed.remove(name);
+        if(!invalidated.contains(name)) invalidated.append(name);
+    }
+
+    QDBusMessage merged = newer;
+    merged.setArguments(QVariantList() << newerArguments.at(0) << changed << invalidated);
+    return merged;
+}
+
+class VoiceCallSignalSchedulerHolder
+{
+public:
+    VoiceCallSignalScheduler scheduler;
+};
+
+Q_GLOBAL_STATIC(VoiceCallSignalSchedulerHolder, schedulerHolder)
+
+VoiceCallSignalScheduler* VoiceCallSignalScheduler::instance()
+{
+    return &schedulerHolder()->scheduler;
+}
+
+VoiceCallSignalScheduler::VoiceCallSignalScheduler(QObject *parent)
+    : QObject(parent), d_ptr(new VoiceCallSignalSchedulerPrivate(this))
+{
+    TRACE
+    Q_D(VoiceCallSignalScheduler);
+    d->dispatchTimer.setSingleShot(true);
+    d->dispatchTimer.setInterval(0);
+    QObject::connect(&d->dispatchTimer, SIGNAL(timeout()), SLOT(dispatch()));
+}
+
+VoiceCallSignalScheduler::~VoiceCallSignalScheduler()
+{
+    TRACE
+    Q_D(VoiceCallSignalScheduler);
+    delete d;
+}
+
+/*!
+  Sends \a signal on the connection named \a connectionName. On a peer
+  connection the signal is queued until the peer has caught up, replacing a
+  queued signal of the same member on the same object and destination.
+  Events are never replaced. A peer with more than VOICECALL_PEER_MAX_QUEUE
+  signals held back is disconnected.
+*/
+void VoiceCallSignalScheduler::send(const QString &connectionName, const QDBusMessage &signal)
+{
+    Q_D(VoiceCallSignalScheduler);
+    QDBusConnection connection(connectionName);
+    if(!connection.isConnected())
+    {
+        d->peers.remove(connectionName);
+        return;
+    }
+
+    // Only peer connections lack a unique name.
+    if(!connection.baseService().isEmpty())
+    {
+        connection.send(signal);
+        return;
+    }
+
+    VoiceCallSignalSchedulerPrivate::Peer &peer = d->peers[connectionName];
+    VoiceCallSignalSchedulerPrivate::Entry entry;
+    entry.key = signalKey(signal);
+    entry.signal = signal;
+
+    for(int i = 0; !entry.key.isEmpty() && i < peer.queue.count(); ++i)
+    {
+        if(peer.queue.at(i).key != entry.key) continue;
+
+        if(signal.member() == QLatin1String("PropertiesChanged"))
+        {
+            entry.signal = mergePropertiesChanged(peer.queue.at(i).signal, signal);
+        }
+
+        // Moved to the back, so that it still follows the signals it came after.
+        peer.queue.removeAt(i);
+        ++peer.coalesced;
+        break;
+    }
+
+    if(peer.queue.count() >= VOICECALL_PEER_MAX_QUEUE)
+    {
+        // Dropping signals would leave the peer with a wrong picture, make it
+        // reconnect and fetch the current state instead.
+        WARNING_T("Peer connection %s has %d signals held back, disconnecting it",
+                  qPrintable(connectionName), peer.queue.count());
+        d->peers.remove(connectionName);
+        QDBusConnection::disconnectFromPeer(connectionName);
+        return;
+    }
+
+    peer.queue.append(entry);
+    peer.maxDepth = qMax(peer.maxDepth, peer.queue.count());
+
+    if(!peer.waiting && !d->dispatchTimer.isActive()) d->dispatchTimer.start();
+}
+
+/*!
+  Drops the queue of the connection named \a connectionName.
+*/
+void VoiceCallSignalScheduler::removeConnection(const QString &connectionName)
+{
+    TRACE
+    Q_D(VoiceCallSignalScheduler);
+    d->peers.remove(connectionName);
+}
+
+/*!
+  Returns the queue of each peer connection as connection name ->
+  {depth, maxDepth, sent, coalesced, stalled}.
+*/
+QVariantMap VoiceCallSignalScheduler::queues() const
+{
+    TRACE
+    Q_D(const VoiceCallSignalScheduler);
+    QVariantMap results;
+
+    for(QHash<QString, VoiceCallSignalSchedulerPrivate::Peer>::const_iterator it = d->peers.constBegin();
+        it != d->peers.constEnd(); ++it)
+    {
+        const VoiceCallSignalSchedulerPrivate::Peer &peer = it.value();
+        QVariantMap queue;
+
+        queue.insert("depth", peer.queue.count());
+        queue.insert("maxDepth", peer.maxDepth);
+        queue.insert("sent", peer.sent);
+        queue.insert("coalesced", peer.coalesced);
+        queue.insert("stalled", peer.pingTimeout > VOICECALL_PEER_PING_TIMEOUT);
+
+        results.insert(it.key(), queue);
+    }
+
+    return results;
+}
+
+/*!
+  Sends the queued signals of every peer that has caught up.
+*/
+void VoiceCallSignalScheduler::dispatch()
+{
+    Q_D(VoiceCallSignalScheduler);
+    d->dispatchTimer.stop();
+
+    QHash<QString, VoiceCallSignalSchedulerPrivate::Peer>::iterator it = d->peers.begin();
+    while(it != d->peers.end())
+    {
+        VoiceCallSignalSchedulerPrivate::Peer &peer = it.value();
+        if(peer.waiting || peer.queue.isEmpty())
+        {
+            ++it;
+            continue;
+        }
+
+        QDBusConnection connection(it.key());
+        if(!connection.isConnected())
+        {
+            it = d->peers.erase(it);
+            continue;
+        }
+
+        foreach(const VoiceCallSignalSchedulerPrivate::Entry &entry, peer.queue)
+        {
+            connection.send(entry.signal);
+        }
+        peer.sent += peer.queue.count();
+        peer.queue.clear();
+
+        d->ping(it.key(), peer);
+        ++it;
+    }
+}
+
+void VoiceCallSignalSchedulerPrivate::ping(const QString &connectionName, Peer &peer)
+{
+    Q_Q(VoiceCallSignalScheduler);
+    peer.waiting = true;
+
+    // Answered by the peer's D-Bus library once it has read all that was sent before.
+    QDBusMessage message = QDBusMessage::createMethodCall(QString(), "/", "org.freedesktop.DBus.Peer", "Ping");
+    QDBusPendingCall call = QDBusConnection(connectionName).asyncCall(message, peer.pingTimeout);
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, q);
+    QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
+                     q, [this, connectionName](QDBusPendingCallWatcher *watcher) {
+        onPingFinished(connectionName, !watcher->isError());
+        watcher->deleteLater();
+    });
+}
+
+void VoiceCallSignalSchedulerPrivate::onPingFinished(const QString &connectionName, bool ok)
+{
+    if(!peers.contains(connectionName)) return;
+    Peer &peer = peers[connectionName];
+
+    if(!QDBusConnection(connectionName).isConnected())
+    {
+        peers.remove(connectionName);
+        return;
+    }
+
+    if(!ok)
+    {
+        // Still not reading, keep coalescing and check back less often.
+        WARNING_T("Peer connection %s is not reading, %d signals held back",
+                  qPrintable(connectionName), peer.queue.count());
+        peer.pingTimeout = qMin(peer.pingTimeout * 2, VOICECALL_PEER_PING_MAX_TIMEOUT);
+        ping(connectionName, peer);
+        return;
+    }
+
+    peer.waiting = false;
+    peer.pingTimeout = VOICECALL_PEER_PING_TIMEOUT;
+    if(!peer.queue.isEmpty() && !dispatchTimer.isActive()) dispatchTimer.start();
+}
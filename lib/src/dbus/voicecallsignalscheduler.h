@@ -0,0 +1,68 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLSIGNALSCHEDULER_H
+#define VOICECALLSIGNALSCHEDULER_H
+
+#include <QObject>
+#include <QVariantMap>
+#include <QDBusMessage>
+
+/*
+ * Process wide outbound queue for the signals sent to peer connections.
+ *
+ * A peer gets one batch of signals at a time; the next batch is only sent
+ * once the peer has answered a Ping sent after the previous one, i.e. once it
+ * has read everything before it. Signals queued in the meantime replace the
+ * queued ones they supersede, so that a peer which stops reading costs at
+ * most one message per property and object, and never delays the others.
+ * Events, such as CallAdded, are kept in order and never replaced; a peer
+ * that lets too many of them pile up is disconnected.
+ * Signals on bus connections are sent right away, the bus daemon queues
+ * them for each of its clients.
+ */
+class VoiceCallSignalScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    static VoiceCallSignalScheduler* instance();
+
+    void send(const QString &connectionName, const QDBusMessage &signal);
+    void removeConnection(const QString &connectionName);
+
+    QVariantMap queues() const;
+
+protected Q_SLOTS:
+    void dispatch();
+
+private:
+    explicit VoiceCallSignalScheduler(QObject *parent = 0);
+            ~VoiceCallSignalScheduler();
+
+    friend class VoiceCallSignalSchedulerHolder;
+
+    class VoiceCallSignalSchedulerPrivate *d_ptr;
+
+    Q_DISABLE_COPY(VoiceCallSignalScheduler)
+    Q_DECLARE_PRIVATE(VoiceCallSignalScheduler)
+};
+
+#endif // VOICECALLSIGNALSCHEDULER_H
@@ -0,0 +1,100 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "common.h"
+#include "voicecallstatsdbusadapter.h"
+
+#include "voicecallhandle.h"
+#include "voicecallstats.h"
+#include "voicecallsignalscheduler.h"
+
+#include <QDBusMetaType>
+
+/*!
+  \class VoiceCallStatsDBusAdapter
+  \brief The D-Bus adapter exposing the daemon latency statistics.
+*/
+
+/*!
+  Constructs a new stats adapter, to be attached to the manager root object.
+*/
+VoiceCallStatsDBusAdapter::VoiceCallStatsDBusAdapter(QObject *parent)
+    : QDBusAbstractAdaptor(parent)
+{
+    TRACE
+    qDBusRegisterMetaType<QList<uint> >();
+}
+
+VoiceCallStatsDBusAdapter::~VoiceCallStatsDBusAdapter()
+{
+    TRACE
+}
+
+/*!
+  Returns the upper bounds, in microseconds, of the histogram buckets. The last
+  bucket of every histogram is unbounded.
+*/
+QList<uint> VoiceCallStatsDBusAdapter::bucketBounds() const
+{
+    TRACE
+    return VoiceCallStats::bucketBounds();
+}
+
+/*!
+  Returns the histograms as source -> series -> {buckets, count, sum, min, max}.
+*/
+QVariantMap VoiceCallStatsDBusAdapter::GetHistograms()
+{
+    TRACE
+    return VoiceCallStats::instance()->histograms();
+}
+
+/*!
+  Returns the outgoing signal queue of each peer connection as connection
+  name -> {depth, maxDepth, sent, coalesced, stalled}.
+*/
+QVariantMap VoiceCallStatsDBusAdapter::GetPeerQueues()
+{
+    TRACE
+    return VoiceCallSignalScheduler::instance()->queues();
+}
+
+/*!
+  Clears all collected histograms.
+*/
+void VoiceCallStatsDBusAdapter::Reset()
+{
+    TRACE
+    VoiceCallStats::instance()->reset();
+}
+
+/*!
+  Records that a client showed the call \a handlerId to the user at the
+  monotonic \a timestamp (microseconds), completing the call setup stages.
+*/
+void VoiceCallStatsDBusAdapter::ReportCallPresented(const QString &handlerId, qlonglong timestamp)
+{
+    TRACE
+    qint64 now = voicecallMonotonicTimestamp();
+    if (timestamp <= 0 || timestamp > now) timestamp = now;
+
+    VoiceCallStats::instance()->markStage(VoiceCallHandle::valueOf(handlerId),
+                                          VoiceCallStats::STAGE_UI_PRESENTED, timestamp);
+}
@@ -0,0 +1,48 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLSTATSDBUSADAPTER_H
+#define VOICECALLSTATSDBUSADAPTER_H
+
+#include <QDBusAbstractAdaptor>
+#include <QVariantMap>
+
+class VoiceCallStatsDBusAdapter : public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.nemomobile.voicecall.Stats")
+
+    Q_PROPERTY(QList<uint> bucketBounds READ bucketBounds)
+
+public:
+    explicit VoiceCallStatsDBusAdapter(QObject *parent = 0);
+            ~VoiceCallStatsDBusAdapter();
+
+    QList<uint> bucketBounds() const;
+
+public Q_SLOTS:
+    QVariantMap GetHistograms();
+    QVariantMap GetPeerQueues();
+    void Reset();
+
+    void ReportCallPresented(const QString &handlerId, qlonglong timestamp);
+};
+
+#endif // VOICECALLSTATSDBUSADAPTER_H
@@ -11,18 +11,43 @@ enable-debug {
 
 HEADERS += \
     common.h \
+    voicecallhandle.h \
+    voicecallchangeset.h \
+    voicecallstats.h \
+    voicecalldurationtracker.h \
+    voicecallstatemachine.h \
+    voicecallstatetable.h \
+    voicecallpendingoperation.h \
     voicecallmanagerinterface.h \
     abstractnotificationprovider.h \
     abstractvoicecallhandler.h \
     abstractvoicecallprovider.h \
     abstractvoicecallmanagerplugin.h \
     dbus/voicecallmanagerdbusadapter.h \
-    dbus/voicecallhandlerdbusadapter.h
+    dbus/voicecallhandlerdbusobject.h \
+    dbus/voicecallobjectmanagerdbusadapter.h \
+    dbus/voicecallstatsdbusadapter.h \
+    dbus/voicecallpropertiesnotifier.h \
+    dbus/voicecalldelayedreply.h \
+    dbus/voicecallsignalscheduler.h \
+    dbus/voicecallproperties.h \
+    dbus/voicecalldbustypes.h
 
 SOURCES += \
     dbus/voicecallmanagerdbusadapter.cpp \
-    dbus/voicecallhandlerdbusadapter.cpp \
+    dbus/voicecallhandlerdbusobject.cpp \
+    dbus/voicecallobjectmanagerdbusadapter.cpp \
+    dbus/voicecallstatsdbusadapter.cpp \
+    dbus/voicecallpropertiesnotifier.cpp \
+    dbus/voicecalldelayedreply.cpp \
+    dbus/voicecallsignalscheduler.cpp \
+    dbus/voicecallproperties.cpp \
     abstractvoicecallhandler.cpp \
+    voicecallstats.cpp \
+    voicecalldurationtracker.cpp \
+    voicecallstatemachine.cpp \
+    voicecallstatetable.cpp \
+    voicecallpendingoperation.cpp \
     common.cpp
 
 target.path = $$[QT_INSTALL_LIBS]
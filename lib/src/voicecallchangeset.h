@@ -0,0 +1,130 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLCHANGESET_H
+#define VOICECALLCHANGESET_H
+
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+
+#include "abstractvoicecallhandler.h"
+
+/*
+ * Net delta of the manager state collected during one event loop iteration.
+ *
+ * Calls added and removed within the same iteration cancel out. Removed
+ * calls are reported by handle, as their handlers are already on their way
+ * to deletion.
+ */
+class VoiceCallChangeSet
+{
+public:
+    enum CallProperty {
+        StatusProperty          = 0x0001,
+        LineIdProperty          = 0x0002,
+        StartedAtProperty       = 0x0004,
+        DurationProperty        = 0x0008,
+        EmergencyProperty       = 0x0010,
+        MultipartyProperty      = 0x0020,
+        ForwardedProperty       = 0x0040,
+        RemoteHeldProperty      = 0x0080,
+        ParentHandlerIdProperty = 0x0100,
+        ChildCallsProperty      = 0x0200
+    };
+    Q_DECLARE_FLAGS(CallProperties, CallProperty)
+
+    enum ManagerProperty {
+        ProvidersProperty       = 0x0001,
+        VoiceCallsProperty      = 0x0002,
+        ActiveVoiceCallProperty = 0x0004,
+        AudioModeProperty       = 0x0008,
+        AudioRoutedProperty     = 0x0010,
+        MicrophoneMutedProperty = 0x0020,
+        SpeakerMutedProperty    = 0x0040
+    };
+    Q_DECLARE_FLAGS(ManagerProperties, ManagerProperty)
+
+    bool isEmpty() const
+    {
+        return m_added.isEmpty() && m_removed.isEmpty() && m_changed.isEmpty() && !m_managerProperties;
+    }
+
+    const QList<AbstractVoiceCallHandler*>& addedCalls() const { return m_added; }
+    const QList<VoiceCallHandle>& removedCalls() const { return m_removed; }
+    const QHash<AbstractVoiceCallHandler*, CallProperties>& changedCalls() const { return m_changed; }
+    ManagerProperties managerProperties() const { return m_managerProperties; }
+
+    CallProperties callProperties(AbstractVoiceCallHandler *handler) const { return m_changed.value(handler); }
+
+    // Union of the property bits of every changed call.
+    CallProperties changedCallProperties() const
+    {
+        CallProperties result;
+        foreach (CallProperties properties, m_changed) result |= properties;
+        return result;
+    }
+
+    void addCall(AbstractVoiceCallHandler *handler)
+    {
+        m_added.append(handler);
+        m_managerProperties |= VoiceCallsProperty;
+    }
+
+    void removeCall(AbstractVoiceCallHandler *handler)
+    {
+        m_changed.remove(handler);
+        if (!m_added.removeOne(handler)) m_removed.append(handler->handle());
+        m_managerProperties |= VoiceCallsProperty;
+    }
+
+    void changeCall(AbstractVoiceCallHandler *handler, CallProperties properties)
+    {
+        // Properties of a call added in this iteration are part of the addition.
+        if (m_added.contains(handler)) return;
+        m_changed[handler] |= properties;
+    }
+
+    void changeManager(ManagerProperties properties)
+    {
+        m_managerProperties |= properties;
+    }
+
+    void clear()
+    {
+        m_added.clear();
+        m_removed.clear();
+        m_changed.clear();
+        m_managerProperties = ManagerProperties();
+    }
+
+private:
+    QList<AbstractVoiceCallHandler*> m_added;
+    QList<VoiceCallHandle> m_removed;
+    QHash<AbstractVoiceCallHandler*, CallProperties> m_changed;
+    ManagerProperties m_managerProperties;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(VoiceCallChangeSet::CallProperties)
+Q_DECLARE_OPERATORS_FOR_FLAGS(VoiceCallChangeSet::ManagerProperties)
+
+Q_DECLARE_METATYPE(VoiceCallChangeSet)
+
+#endif // VOICECALLCHANGESET_H
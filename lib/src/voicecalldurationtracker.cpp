@@ -0,0 +1,238 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "common.h"
+#include "voicecalldurationtracker.h"
+#include "dbus/voicecalldbustypes.h"
+
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTimer>
+#include <QCoreApplication>
+
+class VoiceCallDurationTrackerPrivate
+{
+public:
+    struct Call
+    {
+        Call() : accumulated(0), since(0) {/*...*/}
+
+        qint64 accumulated; // ms ongoing before the current period
+        qint64 since;       // ms timestamp the current period began, 0 if stopped
+    };
+
+    VoiceCallDurationTrackerPrivate()
+        : running(0), timer(NULL)
+    {/*...*/}
+
+    mutable QMutex mutex;
+
+    QHash<quint64, Call> calls;
+    int running;
+
+    QSet<QObject*> consumers;
+
+    QTimer *timer;
+
+    static qint64 now()
+    {
+        return voicecallBootTimestamp();
+    }
+
+    bool isTicking() const
+    {
+        return running > 0 && !consumers.isEmpty();
+    }
+};
+
+class VoiceCallDurationTrackerHolder
+{
+public:
+    VoiceCallDurationTracker tracker;
+};
+
+Q_GLOBAL_STATIC(VoiceCallDurationTrackerHolder, trackerHolder)
+
+VoiceCallDurationTracker* VoiceCallDurationTracker::instance()
+{
+    return &trackerHolder()->tracker;
+}
+
+VoiceCallDurationTracker::VoiceCallDurationTracker(QObject *parent)
+    : QObject(parent), d_ptr(new VoiceCallDurationTrackerPrivate)
+{
+    TRACE
+    Q_D(VoiceCallDurationTracker);
+    d->timer = new QTimer(this);
+    d->timer->setSingleShot(true);
+    d->timer->setTimerType(Qt::CoarseTimer);
+    QObject::connect(d->timer, SIGNAL(timeout()), SLOT(onTimeout()));
+
+    // Whichever thread first asks for the tracker, it ticks in the main thread.
+    if(QCoreApplication::instance()) moveToThread(QCoreApplication::instance()->thread());
+}
+
+VoiceCallDurationTracker::~VoiceCallDurationTracker()
+{
+    TRACE
+    Q_D(VoiceCallDurationTracker);
+    delete d;
+}
+
+/*!
+  Starts counting the duration of the call \a handle, continuing from what it
+  was counted so far.
+*/
+void VoiceCallDurationTracker::start(quint64 handle)
+{
+    TRACE
+    Q_D(VoiceCallDurationTracker);
+    QMutexLocker locker(&d->mutex);
+
+    VoiceCallDurationTrackerPrivate::Call &call = d->calls[handle];
+    if(call.since) return;
+
+    call.since = d->now();
+    if(++d->running == 1) scheduleUpdate();
+}
+
+/*!
+  Stops counting the duration of the call \a handle, which keeps its value.
+*/
+void VoiceCallDurationTracker::stop(quint64 handle)
+{
+    TRACE
+    Q_D(VoiceCallDurationTracker);
+    QMutexLocker locker(&d->mutex);
+
+    QHash<quint64, VoiceCallDurationTrackerPrivate::Call>::iterator it = d->calls.find(handle);
+    if(it == d->calls.end() || !it->since) return;
+
+    it->accumulated += d->now() - it->since;
+    it->since = 0;
+    if(--d->running == 0) scheduleUpdate();
+}
+
+/*!
+  Drops the call \a handle, once its handler goes away.
+*/
+void VoiceCallDurationTracker::forget(quint64 handle)
+{
+    TRACE
+    Q_D(VoiceCallDurationTracker);
+    QMutexLocker locker(&d->mutex);
+
+    VoiceCallDurationTrackerPrivate::Call call = d->calls.take(handle);
+    if(call.since && --d->running == 0) scheduleUpdate();
+}
+
+/*!
+  Returns the time the call \a handle has been ongoing, in milliseconds, or
+  -1 if it is not tracked.
+*/
+qint64 VoiceCallDurationTracker::duration(quint64 handle) const
+{
+    Q_D(const VoiceCallDurationTracker);
+    QMutexLocker locker(&d->mutex);
+
+    QHash<quint64, VoiceCallDurationTrackerPrivate::Call>::const_iterator it = d->calls.constFind(handle);
+    if(it == d->calls.constEnd()) return -1;
+
+    return it->accumulated + (it->since ? d->now() - it->since : 0);
+}
+
+/*!
+  Returns the duration of the call \a handle rounded to seconds, 0 if it is
+  not tracked.
+*/
+int VoiceCallDurationTracker::seconds(quint64 handle) const
+{
+    qint64 msecs = duration(handle);
+    return msecs > 0 ? int((msecs + 500) / 1000) : 0;
+}
+
+/*!
+  Has tick() emitted every second while a call is ongoing, until \a consumer
+  unsubscribes or is destroyed.
+*/
+void VoiceCallDurationTracker::subscribe(QObject *consumer)
+{
+    TRACE
+    Q_D(VoiceCallDurationTracker);
+    QMutexLocker locker(&d->mutex);
+
+    if(d->consumers.contains(consumer)) return;
+
+    d->consumers.insert(consumer);
+    QObject::connect(consumer, &QObject::destroyed, this, [this, consumer]() {
+        unsubscribe(consumer);
+    });
+    if(d->consumers.count() == 1) scheduleUpdate();
+}
+
+void VoiceCallDurationTracker::unsubscribe(QObject *consumer)
+{
+    TRACE
+    Q_D(VoiceCallDurationTracker);
+    QMutexLocker locker(&d->mutex);
+
+    if(!d->consumers.remove(consumer)) return;
+
+    QObject::disconnect(consumer, SIGNAL(destroyed(QObject*)), this, 0);
+    if(d->consumers.isEmpty()) scheduleUpdate();
+}
+
+void VoiceCallDurationTracker::scheduleUpdate()
+{
+    // Queued, since the caller holds the lock and the timer belongs to the
+    // tracker's thread, which the handlers may not run in.
+    QMetaObject::invokeMethod(this, "updateTimer", Qt::QueuedConnection);
+}
+
+void VoiceCallDurationTracker::updateTimer()
+{
+    Q_D(VoiceCallDurationTracker);
+    QMutexLocker locker(&d->mutex);
+
+    if(!d->isTicking())
+    {
+        d->timer->stop();
+    }
+    else if(!d->timer->isActive())
+    {
+        // Wake up on the next whole second, shared by all calls.
+        d->timer->start(int(1000 - d->now() % 1000));
+    }
+}
+
+void VoiceCallDurationTracker::onTimeout()
+{
+    Q_D(VoiceCallDurationTracker);
+    {
+        QMutexLocker locker(&d->mutex);
+        if(!d->isTicking()) return;
+
+        d->timer->start(int(1000 - d->now() % 1000));
+    }
+
+    emit tick();
+}
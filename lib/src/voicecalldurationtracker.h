@@ -0,0 +1,77 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLDURATIONTRACKER_H
+#define VOICECALLDURATIONTRACKER_H
+
+#include <QObject>
+
+/*
+ * Process wide call duration bookkeeping.
+ *
+ * Handlers report when a call starts and stops being ongoing, normally from
+ * the duration hooks of their VoiceCallStateMachine, and read the duration
+ * back from here; it is computed from the monotonic clock when asked, so no
+ * timer is needed to keep it right. For those that want to see it change,
+ * a single timer aligned to whole seconds emits tick() for all calls at
+ * once, and only while a call is ongoing and something subscribed to it.
+ *
+ * Calls are keyed by handle value. The methods may be called from any
+ * thread; tick() is emitted in the main thread.
+ */
+class VoiceCallDurationTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    static VoiceCallDurationTracker* instance();
+
+    void start(quint64 handle);
+    void stop(quint64 handle);
+    void forget(quint64 handle);
+
+    qint64 duration(quint64 handle) const;
+    int seconds(quint64 handle) const;
+
+    void subscribe(QObject *consumer);
+    void unsubscribe(QObject *consumer);
+
+Q_SIGNALS:
+    void tick();
+
+protected Q_SLOTS:
+    void updateTimer();
+    void onTimeout();
+
+private:
+    explicit VoiceCallDurationTracker(QObject *parent = 0);
+            ~VoiceCallDurationTracker();
+
+    friend class VoiceCallDurationTrackerHolder;
+
+    void scheduleUpdate();
+
+    class VoiceCallDurationTrackerPrivate *d_ptr;
+
+    Q_DISABLE_COPY(VoiceCallDurationTracker)
+    Q_DECLARE_PRIVATE(VoiceCallDurationTracker)
+};
+
+#endif // VOICECALLDURATIONTRACKER_H
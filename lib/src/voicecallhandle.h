@@ -0,0 +1,99 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLHANDLE_H
+#define VOICECALLHANDLE_H
+
+#include <QHash>
+#include <QMetaType>
+#include <QString>
+
+/*
+ * Compact identifier of a voice call.
+ *
+ * A handle is a 64 bit value generated by the manager: the upper half holds
+ * the daemon start time so identifiers stay unique across restarts, the lower
+ * half a monotonic counter. The textual form (16 hex digits, usable as a
+ * D-Bus path element) and the D-Bus object path are computed once when the
+ * handle is created and shared by all copies.
+ */
+class VoiceCallHandle
+{
+public:
+    VoiceCallHandle() : m_value(0) {/* ... */}
+
+    explicit VoiceCallHandle(quint64 value)
+        : m_value(value)
+    {
+        if (m_value)
+        {
+            m_id = QString::number(m_value, 16).rightJustified(16, QLatin1Char('0'));
+            m_path = QLatin1String("/calls/") + m_id;
+        }
+    }
+
+    bool isNull() const { return m_value == 0; }
+    bool isValid() const { return m_value != 0; }
+    quint64 value() const { return m_value; }
+
+    const QString& toString() const { return m_id; }
+    const QString& path() const { return m_path; }
+
+    bool operator==(const VoiceCallHandle &other) const { return m_value == other.m_value; }
+    bool operator!=(const VoiceCallHandle &other) const { return m_value != other.m_value; }
+    bool operator<(const VoiceCallHandle &other) const { return m_value < other.m_value; }
+
+    // Parses the textual form without allocating, returns 0 if invalid. All
+    // invalid ids share that value, check isValid() before using it as a key.
+    static quint64 valueOf(const QString &handlerId)
+    {
+        if (handlerId.length() != 16) return 0;
+
+        quint64 value = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            ushort c = handlerId.at(i).unicode();
+            if (c >= '0' && c <= '9') value = (value << 4) | (c - '0');
+            else if (c >= 'a' && c <= 'f') value = (value << 4) | (c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') value = (value << 4) | (c - 'A' + 10);
+            else return 0;
+        }
+        return value;
+    }
+
+    static VoiceCallHandle fromString(const QString &handlerId)
+    {
+        return VoiceCallHandle(valueOf(handlerId));
+    }
+
+private:
+    quint64 m_value;
+    QString m_id;
+    QString m_path;
+};
+
+inline uint qHash(const VoiceCallHandle &handle, uint seed = 0)
+{
+    return qHash(handle.value(), seed);
+}
+
+Q_DECLARE_METATYPE(VoiceCallHandle)
+
+#endif // VOICECALLHANDLE_H
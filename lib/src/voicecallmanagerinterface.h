@@ -23,6 +23,7 @@
 
 #include <QObject>
 #include "abstractvoicecallprovider.h"
+#include "voicecallchangeset.h"
 
 class VoiceCallManagerInterface : public QObject
 {
@@ -43,6 +44,8 @@ class VoiceCallManagerInterface : public QObject
     Q_PROPERTY(int totalOutgoingCallDuration READ totalOutgoingCallDuration NOTIFY totalOutgoingCallDurationChanged)
     Q_PROPERTY(int totalIncomingCallDuration READ totalIncomingCallDuration NOTIFY totalIncomingCallDurationChanged)
 
+    Q_PROPERTY(bool isIdle READ isIdle NOTIFY idleChanged)
+
 public:
     typedef enum {
         TONE_DIAL,
@@ -60,11 +63,17 @@ public:
 
     virtual QList<AbstractVoiceCallProvider*> providers() const = 0;
 
+    virtual VoiceCallHandle generateHandle() = 0;
+    // Upper half of the generated handles, unique to this daemon instance.
+    virtual quint32 handleEpoch() const = 0;
     virtual QString generateHandlerId() = 0;
 
     virtual int voiceCallCount() const = 0;
     virtual QList<AbstractVoiceCallHandler*> voiceCalls() const = 0;
 
+    virtual int voiceCallCount(AbstractVoiceCallHandler::VoiceCallStatus status) const = 0;
+    virtual QList<AbstractVoiceCallHandler*> voiceCalls(AbstractVoiceCallHandler::VoiceCallStatus status) const = 0;
+
     virtual AbstractVoiceCallHandler* activeVoiceCall() const = 0;
 
     virtual QString audioMode() const = 0;
@@ -78,6 +87,12 @@ public:
     virtual int totalIncomingCallDuration() const = 0;
     virtual void resetCallDurationCounters() = 0;
 
+    virtual bool isIdle() const = 0;
+
+    // Like dial(), but reports when the provider's backend has accepted or
+    // rejected the request.
+    virtual VoiceCallPendingOperation* requestDial(const QString &providerId, const QString &msisdn) = 0;
+
 Q_SIGNALS:
     void error(const QString &errorString);
 
@@ -85,6 +100,8 @@ Q_SIGNALS:
     void providerRemoved(const QString &providerId);
     void providersChanged();
 
+    // Emitted when the change set the call was added or removed in is
+    // committed, just before voiceCallsChanged().
     void voiceCallAdded(AbstractVoiceCallHandler *handler);
     void voiceCallRemoved(const QString &handlerId);
     void voiceCallsChanged();
@@ -114,9 +131,18 @@ Q_SIGNALS:
     void totalOutgoingCallDurationChanged();
     void totalIncomingCallDurationChanged();
 
+    // Emitted when there have been no calls for a while, and again, before
+    // anything else is signalled, on the next incoming call or dial request.
+    void idleChanged(bool idle);
+
+    // Emitted once per event loop iteration with the net changes made in it.
+    void changesCommitted(const VoiceCallChangeSet &changes);
+
 public Q_SLOTS:
     virtual void setError(const QString &errorString) = 0;
 
+    virtual void commitChanges() = 0;
+
     virtual void appendProvider(AbstractVoiceCallProvider *provider) = 0;
     virtual void removeProvider(AbstractVoiceCallProvider *provider) = 0;
 
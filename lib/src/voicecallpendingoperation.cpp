@@ -0,0 +1,128 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "common.h"
+#include "voicecallpendingoperation.h"
+
+class VoiceCallPendingOperationPrivate
+{
+    Q_DECLARE_PUBLIC(VoiceCallPendingOperation)
+
+public:
+    VoiceCallPendingOperationPrivate(VoiceCallPendingOperation *q)
+        : q_ptr(q), isFinished(false), isError(false)
+    {/*...*/}
+
+    VoiceCallPendingOperation *q_ptr;
+
+    bool isFinished;
+    bool isError;
+    QString errorMessage;
+
+    void finish()
+    {
+        Q_Q(VoiceCallPendingOperation);
+        isFinished = true;
+        QMetaObject::invokeMethod(q, "emitFinished", Qt::QueuedConnection);
+    }
+};
+
+VoiceCallPendingOperation::VoiceCallPendingOperation(QObject *parent)
+    : QObject(parent), d_ptr(new VoiceCallPendingOperationPrivate(this))
+{
+    TRACE
+}
+
+VoiceCallPendingOperation::~VoiceCallPendingOperation()
+{
+    TRACE
+    Q_D(VoiceCallPendingOperation);
+    delete d;
+}
+
+/*!
+  Returns an operation already finished, successfully if \a ok is true and
+  otherwise with \a errorMessage. For requests that are complete, or rejected,
+  as soon as they are made.
+*/
+VoiceCallPendingOperation* VoiceCallPendingOperation::completed(bool ok, const QString &errorMessage, QObject *parent)
+{
+    VoiceCallPendingOperation *operation = new VoiceCallPendingOperation(parent);
+
+    if(ok)
+    {
+        operation->setFinished();
+    }
+    else
+    {
+        operation->setFinishedWithError(errorMessage);
+    }
+
+    return operation;
+}
+
+bool VoiceCallPendingOperation::isFinished() const
+{
+    Q_D(const VoiceCallPendingOperation);
+    return d->isFinished;
+}
+
+bool VoiceCallPendingOperation::isError() const
+{
+    Q_D(const VoiceCallPendingOperation);
+    return d->isError;
+}
+
+QString VoiceCallPendingOperation::errorMessage() const
+{
+    Q_D(const VoiceCallPendingOperation);
+    return d->errorMessage;
+}
+
+/*!
+  Marks the request as confirmed by the backend.
+*/
+void VoiceCallPendingOperation::setFinished()
+{
+    TRACE
+    Q_D(VoiceCallPendingOperation);
+    if(d->isFinished) return;
+    d->finish();
+}
+
+/*!
+  Marks the request as rejected by the backend, with \a errorMessage.
+*/
+void VoiceCallPendingOperation::setFinishedWithError(const QString &errorMessage)
+{
+    TRACE
+    Q_D(VoiceCallPendingOperation);
+    if(d->isFinished) return;
+    d->isError = true;
+    d->errorMessage = errorMessage;
+    d->finish();
+}
+
+void VoiceCallPendingOperation::emitFinished()
+{
+    TRACE
+    emit finished(this);
+    deleteLater();
+}
@@ -0,0 +1,65 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLPENDINGOPERATION_H
+#define VOICECALLPENDINGOPERATION_H
+
+#include <QObject>
+#include <QString>
+
+/*
+ * Completion of a request handed to a provider, such as dialing or answering.
+ *
+ * The provider finishes the operation once the backend has confirmed or
+ * rejected the request. finished() is always emitted from the event loop,
+ * even for operations finished before they are returned, so the caller can
+ * connect to it first. The operation deletes itself after emitting it.
+ */
+class VoiceCallPendingOperation : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit VoiceCallPendingOperation(QObject *parent = 0);
+            ~VoiceCallPendingOperation();
+
+    bool isFinished() const;
+    bool isError() const;
+    QString errorMessage() const;
+
+    void setFinished();
+    void setFinishedWithError(const QString &errorMessage);
+
+    static VoiceCallPendingOperation* completed(bool ok, const QString &errorMessage, QObject *parent = 0);
+
+Q_SIGNALS:
+    void finished(VoiceCallPendingOperation *operation);
+
+protected Q_SLOTS:
+    void emitFinished();
+
+private:
+    class VoiceCallPendingOperationPrivate *d_ptr;
+
+    Q_DISABLE_COPY(VoiceCallPendingOperation)
+    Q_DECLARE_PRIVATE(VoiceCallPendingOperation)
+};
+
+#endif // VOICECALLPENDINGOPERATION_H
@@ -0,0 +1,137 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "common.h"
+#include "voicecallstatemachine.h"
+
+namespace {
+
+const int StatusCount = AbstractVoiceCallHandler::STATUS_DISCONNECTED + 1;
+
+const VoiceCallStateMachine::Transition A = VoiceCallStateMachine::TRANSITION_ALLOWED;
+const VoiceCallStateMachine::Transition U = VoiceCallStateMachine::TRANSITION_UNEXPECTED;
+const VoiceCallStateMachine::Transition F = VoiceCallStateMachine::TRANSITION_FORBIDDEN;
+
+// Rows are the current status, columns the new one, both in enum order:
+// null, active, held, dialing, alerting, incoming, waiting, disconnected.
+// Falling back to null is always allowed, it is how handlers are torn down.
+const VoiceCallStateMachine::Transition TransitionTable[StatusCount][StatusCount] = {
+    /* null         */ { A, A, A, A, A, A, A, A },
+    /* active       */ { A, A, A, U, U, U, U, A },
+    /* held         */ { A, A, A, U, U, U, U, A },
+    /* dialing      */ { A, A, U, A, A, U, U, A },
+    /* alerting     */ { A, A, U, U, A, U, U, A },
+    /* incoming     */ { A, A, U, U, U, A, A, A },
+    /* waiting      */ { A, A, U, U, U, A, A, A },
+    /* disconnected */ { A, F, F, F, F, F, F, A }
+};
+
+} // namespace
+
+VoiceCallStateMachine::VoiceCallStateMachine()
+    : m_status(AbstractVoiceCallHandler::STATUS_NULL)
+{
+}
+
+void VoiceCallStateMachine::setHook(Hook hook, const HookFunction &function)
+{
+    m_hooks[hook] = function;
+}
+
+bool VoiceCallStateMachine::setStatus(Status status)
+{
+    const Status from = m_status;
+    if (status == from)
+        return false;
+
+    switch (transition(from, status))
+    {
+    case TRANSITION_FORBIDDEN:
+        WARNING_T("Rejected call status transition %s -> %s",
+                  qPrintable(statusText(from)), qPrintable(statusText(status)));
+        return false;
+
+    case TRANSITION_UNEXPECTED:
+        WARNING_T("Unexpected call status transition %s -> %s",
+                  qPrintable(statusText(from)), qPrintable(statusText(status)));
+        break;
+
+    default:
+        break;
+    }
+
+    m_status = status;
+
+    if (isRinging(from) && !isRinging(status))
+        runHook(HOOK_RINGING_STOP, from, status);
+    if (isOngoing(from) && !isOngoing(status))
+        runHook(HOOK_DURATION_STOP, from, status);
+    if (!isOngoing(from) && isOngoing(status))
+        runHook(HOOK_DURATION_START, from, status);
+    if (!isRinging(from) && isRinging(status))
+        runHook(HOOK_RINGING_START, from, status);
+
+    return true;
+}
+
+void VoiceCallStateMachine::runHook(Hook hook, Status from, Status to) const
+{
+    if (m_hooks[hook])
+        m_hooks[hook](from, to);
+}
+
+VoiceCallStateMachine::Transition VoiceCallStateMachine::transition(Status from, Status to)
+{
+    if (from < 0 || from >= StatusCount || to < 0 || to >= StatusCount)
+        return TRANSITION_FORBIDDEN;
+
+    return TransitionTable[from][to];
+}
+
+const QString& VoiceCallStateMachine::statusText(Status status)
+{
+    static const QString texts[StatusCount] = {
+        QStringLiteral("null"),
+        QStringLiteral("active"),
+        QStringLiteral("held"),
+        QStringLiteral("dialing"),
+        QStringLiteral("alerting"),
+        QStringLiteral("incoming"),
+        QStringLiteral("waiting"),
+        QStringLiteral("disconnected")
+    };
+
+    if (status < 0 || status >= StatusCount)
+        return texts[AbstractVoiceCallHandler::STATUS_NULL];
+
+    return texts[status];
+}
+
+VoiceCallStateMachine::Status VoiceCallStateMachine::statusFromText(const QString &text)
+{
+    for (int i = AbstractVoiceCallHandler::STATUS_ACTIVE; i < StatusCount; ++i)
+    {
+        if (text == statusText(Status(i)))
+            return Status(i);
+    }
+
+    return AbstractVoiceCallHandler::STATUS_NULL;
+}
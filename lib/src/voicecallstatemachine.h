@@ -0,0 +1,96 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLSTATEMACHINE_H
+#define VOICECALLSTATEMACHINE_H
+
+#include "abstractvoicecallhandler.h"
+
+#include <functional>
+
+/*
+ * Call status shared by the provider handlers.
+ *
+ * The status is stored as an enum when a transition is applied, so reading it
+ * is a plain load. Transitions are validated against a single table: allowed
+ * transitions are applied silently, unexpected ones are applied with a warning
+ * and forbidden ones (a disconnected call coming back to life) are rejected.
+ * Hooks run after the status has changed, on entering or leaving the ongoing
+ * (active/held) and ringing (incoming/waiting) groups of states.
+ */
+class VoiceCallStateMachine
+{
+public:
+    typedef AbstractVoiceCallHandler::VoiceCallStatus Status;
+
+    enum Transition {
+        TRANSITION_ALLOWED,
+        TRANSITION_UNEXPECTED,
+        TRANSITION_FORBIDDEN
+    };
+
+    enum Hook {
+        HOOK_DURATION_START,
+        HOOK_DURATION_STOP,
+        HOOK_RINGING_START,
+        HOOK_RINGING_STOP,
+        HOOK_COUNT
+    };
+
+    typedef std::function<void (Status from, Status to)> HookFunction;
+
+    VoiceCallStateMachine();
+
+    Status status() const { return m_status; }
+    const QString& statusText() const { return statusText(m_status); }
+
+    bool isOngoing() const { return isOngoing(m_status); }
+    bool isRinging() const { return isRinging(m_status); }
+
+    void setHook(Hook hook, const HookFunction &function);
+
+    // Returns true if the status changed.
+    bool setStatus(Status status);
+
+    static Transition transition(Status from, Status to);
+
+    static const QString& statusText(Status status);
+    static Status statusFromText(const QString &text);
+
+    static bool isOngoing(Status status)
+    {
+        return status == AbstractVoiceCallHandler::STATUS_ACTIVE
+            || status == AbstractVoiceCallHandler::STATUS_HELD;
+    }
+
+    static bool isRinging(Status status)
+    {
+        return status == AbstractVoiceCallHandler::STATUS_INCOMING
+            || status == AbstractVoiceCallHandler::STATUS_WAITING;
+    }
+
+private:
+    void runHook(Hook hook, Status from, Status to) const;
+
+    Status m_status;
+    HookFunction m_hooks[HOOK_COUNT];
+};
+
+#endif // VOICECALLSTATEMACHINE_H
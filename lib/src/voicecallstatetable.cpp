@@ -0,0 +1,226 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "common.h"
+#include "voicecallstatetable.h"
+
+#include <QDBusMessage>
+#include <QDBusReply>
+#include <QDBusUnixFileDescriptor>
+#include <QThread>
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*!
+  \class VoiceCallStateTable
+  \brief Client side reader of the daemon's shared call state table.
+
+  Attach once, then generation() tells cheaply whether anything changed and
+  calls() returns a consistent copy of every call, without any IPC. When reads
+  keep failing, isWriterAlive() tells whether the daemon is gone.
+*/
+
+namespace {
+
+// Attempts before giving up on a sequence, spinning for the first few.
+const int READ_SPIN_ATTEMPTS = 64;
+const int READ_MAX_ATTEMPTS = 1024;
+
+// Runs read() until it saw a stable, even sequence. The writer only holds a
+// record odd for a few stores, but it may be preempted meanwhile, or have
+// died in between, so this gives up eventually.
+template <typename Read>
+bool readConsistent(const std::atomic<quint32> &sequence, Read read)
+{
+    for(int attempt = 0; attempt < READ_MAX_ATTEMPTS; ++attempt)
+    {
+        quint32 begin = sequence.load(std::memory_order_acquire);
+        if(!(begin & 1))
+        {
+            read();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(sequence.load(std::memory_order_relaxed) == begin) return true;
+        }
+        if(attempt > READ_SPIN_ATTEMPTS) QThread::yieldCurrentThread();
+    }
+
+    WARNING_T("Call state table stayed inconsistent, is the daemon gone?");
+    return false;
+}
+
+}
+
+VoiceCallStateTable::VoiceCallStateTable()
+    : m_table(0)
+{
+}
+
+VoiceCallStateTable::~VoiceCallStateTable()
+{
+    detach();
+}
+
+/*!
+  Maps the table from \a fd, which the caller keeps ownership of.
+*/
+bool VoiceCallStateTable::attach(int fd)
+{
+    detach();
+
+    struct stat st;
+    if(fstat(fd, &st) < 0 || st.st_size < qint64(sizeof(VoiceCallStateTableLayout)))
+    {
+        WARNING_T("Call state table has an unexpected size.");
+        return false;
+    }
+
+    void *mapping = mmap(NULL, sizeof(VoiceCallStateTableLayout), PROT_READ, MAP_SHARED, fd, 0);
+    if(mapping == MAP_FAILED)
+    {
+        WARNING_T("Failed to map the call state table: %s", strerror(errno));
+        return false;
+    }
+
+    const VoiceCallStateTableLayout *table = static_cast<const VoiceCallStateTableLayout*>(mapping);
+    if(table->header.magic != VOICECALL_STATE_TABLE_MAGIC
+            || table->header.version != VOICECALL_STATE_TABLE_VERSION
+            || table->header.recordSize != sizeof(VoiceCallStateRecord)
+            || table->header.recordCount != VOICECALL_STATE_TABLE_RECORDS)
+    {
+        WARNING_T("Call state table layout is not supported.");
+        munmap(mapping, sizeof(VoiceCallStateTableLayout));
+        return false;
+    }
+
+    m_table = table;
+    return true;
+}
+
+/*!
+  Asks the daemon for the table over \a connection and maps it.
+*/
+bool VoiceCallStateTable::attach(const QDBusConnection &connection, const QString &service)
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(service, "/",
+                                                          "org.nemomobile.voicecall.VoiceCallManager",
+                                                          "GetStateTable");
+    QDBusReply<QDBusUnixFileDescriptor> reply = QDBusConnection(connection).call(message);
+
+    if(!reply.isValid() || !reply.value().isValid())
+    {
+        WARNING_T("Failed to get the call state table: %s", qPrintable(reply.error().message()));
+        return false;
+    }
+
+    return attach(reply.value().fileDescriptor());
+}
+
+void VoiceCallStateTable::detach()
+{
+    if(!m_table) return;
+
+    munmap(const_cast<VoiceCallStateTableLayout*>(m_table), sizeof(VoiceCallStateTableLayout));
+    m_table = 0;
+}
+
+/*!
+  Returns a counter that changes on every update of the table.
+*/
+quint64 VoiceCallStateTable::generation() const
+{
+    if(!m_table) return 0;
+
+    quint64 generation = 0;
+    if(!readConsistent(m_table->header.sequence, [&]() { generation = m_table->header.generation; })) return 0;
+    return generation;
+}
+
+/*!
+  Returns the handle of the active call, or 0.
+*/
+quint64 VoiceCallStateTable::activeHandle() const
+{
+    if(!m_table) return 0;
+
+    quint64 handle = 0;
+    if(!readConsistent(m_table->header.sequence, [&]() { handle = m_table->header.activeHandle; })) return 0;
+    return handle;
+}
+
+/*!
+  Returns false once the daemon closed the table, or its process is gone.
+*/
+bool VoiceCallStateTable::isWriterAlive() const
+{
+    if(!m_table) return false;
+
+    quint32 pid = 0;
+    if(!readConsistent(m_table->header.sequence, [&]() { pid = m_table->header.writerPid; })) return false;
+    if(!pid) return false;
+
+    // EPERM still means the process exists.
+    return kill(pid_t(pid), 0) == 0 || errno == EPERM;
+}
+
+/*!
+  Returns a copy of every call in the table. Records that could not be read
+  consistently are left out, and \a ok is set to false then.
+*/
+QList<VoiceCallStateTable::Call> VoiceCallStateTable::calls(bool *ok) const
+{
+    QList<Call> results;
+    if(ok) *ok = m_table != 0;
+    if(!m_table) return results;
+
+    for(int i = 0; i < VOICECALL_STATE_TABLE_RECORDS; ++i)
+    {
+        const VoiceCallStateRecord &record = m_table->records[i];
+        Call call;
+        char lineId[VOICECALL_STATE_LINE_ID_SIZE];
+
+        bool consistent = readConsistent(record.sequence, [&]() {
+            call.handle = record.handle;
+            call.status = record.status;
+            call.flags = record.flags;
+            call.startedAt = record.startedAt;
+            call.connectedAt = record.connectedAt;
+            call.heldTime = record.heldTime;
+            memcpy(lineId, record.lineId, sizeof(lineId));
+        });
+
+        if(!consistent)
+        {
+            if(ok) *ok = false;
+            continue;
+        }
+
+        if(!(call.flags & VoiceCallStateRecord::FLAG_IN_USE)) continue;
+
+        lineId[sizeof(lineId) - 1] = '\0';
+        call.lineId = QString::fromUtf8(lineId);
+        results.append(call);
+    }
+
+    return results;
+}
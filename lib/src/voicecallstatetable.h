@@ -0,0 +1,124 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLSTATETABLE_H
+#define VOICECALLSTATETABLE_H
+
+#include <QDBusConnection>
+#include <QList>
+#include <QString>
+
+#include <atomic>
+
+/*
+ * Read-only call state table shared by the daemon through a memfd.
+ *
+ * The table is a header followed by a fixed number of fixed size records.
+ * Every record, and the header, is guarded by a seqlock: the writer makes the
+ * sequence odd, updates the fields and makes it even again, and a reader that
+ * saw an odd sequence, or a different sequence after copying, copies again,
+ * up to a limit: a daemon that died mid update leaves a sequence odd for good.
+ * Readers only load from the mapping, so they never block the daemon and need
+ * no system calls once attached.
+ */
+
+#define VOICECALL_STATE_TABLE_MAGIC     0x54534356 // "VCST"
+#define VOICECALL_STATE_TABLE_VERSION   2
+#define VOICECALL_STATE_TABLE_RECORDS   16
+#define VOICECALL_STATE_LINE_ID_SIZE    64
+
+struct VoiceCallStateRecord
+{
+    enum Flag {
+        FLAG_IN_USE      = 0x01,
+        FLAG_INCOMING    = 0x02,
+        FLAG_EMERGENCY   = 0x04,
+        FLAG_MULTIPARTY  = 0x08,
+        FLAG_FORWARDED   = 0x10,
+        FLAG_REMOTE_HELD = 0x20
+    };
+
+    std::atomic<quint32> sequence;
+    quint32 status;
+    quint32 flags;
+    quint32 reserved;
+    quint64 handle;
+    qint64 startedAt;   // Milliseconds since the epoch.
+    qint64 connectedAt; // CLOCK_BOOTTIME milliseconds, 0 until connected.
+    qint64 heldTime;    // Milliseconds, up to the last status change.
+    char lineId[VOICECALL_STATE_LINE_ID_SIZE]; // UTF-8, NUL terminated.
+};
+
+struct VoiceCallStateTableHeader
+{
+    quint32 magic;
+    quint32 version;
+    quint32 recordSize;
+    quint32 recordCount;
+    std::atomic<quint32> sequence;
+    quint32 writerPid;    // 0 once the daemon closed the table.
+    quint64 generation;   // Bumped by every update of the table.
+    quint64 activeHandle; // 0 if there is no active call.
+};
+
+struct VoiceCallStateTableLayout
+{
+    VoiceCallStateTableHeader header;
+    VoiceCallStateRecord records[VOICECALL_STATE_TABLE_RECORDS];
+};
+
+class VoiceCallStateTable
+{
+public:
+    struct Call
+    {
+        quint64 handle;
+        int status;
+        quint32 flags;
+        QString lineId;
+        qint64 startedAt;
+        qint64 connectedAt;
+        qint64 heldTime;
+    };
+
+    VoiceCallStateTable();
+    ~VoiceCallStateTable();
+
+    bool attach(int fd);
+    bool attach(const QDBusConnection &connection = QDBusConnection::sessionBus(),
+                const QString &service = QLatin1String("org.nemomobile.voicecall"));
+    void detach();
+
+    bool isAttached() const { return m_table != 0; }
+
+    // These return 0, or set ok to false, if no consistent copy could be made.
+    quint64 generation() const;
+    quint64 activeHandle() const;
+    QList<Call> calls(bool *ok = 0) const;
+
+    bool isWriterAlive() const;
+
+private:
+    Q_DISABLE_COPY(VoiceCallStateTable)
+
+    const VoiceCallStateTableLayout *m_table;
+};
+
+#endif // VOICECALLSTATETABLE_H
@@ -0,0 +1,250 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "common.h"
+#include "voicecallstats.h"
+#include "abstractvoicecallhandler.h"
+#include "abstractvoicecallprovider.h"
+
+#include <QHash>
+#include <QMutex>
+
+namespace {
+
+// Upper bounds of the histogram buckets in microseconds, the last bucket is open.
+const uint BUCKET_BOUNDS[] = {
+    500, 1000, 2000, 5000, 10000, 20000, 50000,
+    100000, 200000, 500000, 1000000, 2000000, 5000000
+};
+const int BUCKET_COUNT = sizeof(BUCKET_BOUNDS) / sizeof(BUCKET_BOUNDS[0]) + 1;
+
+const char * const STAGE_NAMES[VoiceCallStats::STAGE_COUNT] = {
+    "call-added", "handler-ready", "manager-added", "dbus-registered", "ui-presented"
+};
+
+struct Histogram
+{
+    Histogram() : count(0), sum(0), min(0), max(0)
+    {
+        for (int i = 0; i < BUCKET_COUNT; ++i) buckets[i] = 0;
+    }
+
+    void add(qint64 usecs)
+    {
+        int i = 0;
+        while (i < BUCKET_COUNT - 1 && usecs > BUCKET_BOUNDS[i]) ++i;
+        ++buckets[i];
+
+        if (count == 0 || usecs < min) min = usecs;
+        if (count == 0 || usecs > max) max = usecs;
+        ++count;
+        sum += usecs;
+    }
+
+    uint buckets[BUCKET_COUNT];
+    quint64 count;
+    qint64 sum;
+    qint64 min;
+    qint64 max;
+};
+
+struct CallStages
+{
+    CallStages() : last(-1)
+    {
+        for (int i = 0; i < VoiceCallStats::STAGE_COUNT; ++i) stamps[i] = 0;
+    }
+
+    QString source;
+    qint64 stamps[VoiceCallStats::STAGE_COUNT];
+    int last;
+};
+
+}
+
+class VoiceCallStatsPrivate
+{
+public:
+    mutable QMutex lock;
+
+    QHash<quint64, CallStages> calls;
+    QHash<QString, QHash<QString, Histogram> > histograms;
+
+    void record(const QString &source, const QString &series, qint64 usecs)
+    {
+        if (usecs < 0) return;
+        histograms[source][series].add(usecs);
+    }
+
+    void markStage(CallStages &call, VoiceCallStats::Stage stage, qint64 timestamp);
+};
+
+void VoiceCallStatsPrivate::markStage(CallStages &call, VoiceCallStats::Stage stage, qint64 timestamp)
+{
+    // Each stage is recorded once and in order, e.g. only the first client
+    // presenting a call counts.
+    if (call.stamps[stage] || int(stage) <= call.last) return;
+
+    call.stamps[stage] = timestamp;
+
+    if (call.last >= 0)
+    {
+        QString name = QLatin1String(STAGE_NAMES[stage]);
+        record(call.source, name, timestamp - call.stamps[call.last]);
+
+        if (call.stamps[VoiceCallStats::STAGE_CALL_ADDED] && call.last != VoiceCallStats::STAGE_CALL_ADDED)
+            record(call.source, name + QLatin1String("-total"), timestamp - call.stamps[VoiceCallStats::STAGE_CALL_ADDED]);
+    }
+
+    call.last = stage;
+}
+
+class VoiceCallStatsHolder
+{
+public:
+    VoiceCallStats stats;
+};
+
+Q_GLOBAL_STATIC(VoiceCallStatsHolder, statsHolder)
+
+VoiceCallStats* VoiceCallStats::instance()
+{
+    return &statsHolder()->stats;
+}
+
+VoiceCallStats::VoiceCallStats(QObject *parent)
+    : QObject(parent), d_ptr(new VoiceCallStatsPrivate)
+{
+    TRACE
+}
+
+VoiceCallStats::~VoiceCallStats()
+{
+    TRACE
+    delete d_ptr;
+}
+
+QString VoiceCallStats::stageName(Stage stage)
+{
+    return QLatin1String(STAGE_NAMES[stage]);
+}
+
+QList<uint> VoiceCallStats::bucketBounds()
+{
+    QList<uint> results;
+    for (int i = 0; i < BUCKET_COUNT - 1; ++i) results.append(BUCKET_BOUNDS[i]);
+    return results;
+}
+
+void VoiceCallStats::markStage(AbstractVoiceCallHandler *handler, Stage stage, qint64 timestamp)
+{
+    Q_D(VoiceCallStats);
+    if (!timestamp) timestamp = voicecallMonotonicTimestamp();
+    quint64 handle = handler->handle().value();
+
+    // Only incoming calls are timed up to ringing. The direction may not be
+    // known when the call is first seen, but it is from the next stage on.
+    if (stage != STAGE_CALL_ADDED && !handler->isIncoming())
+    {
+        forgetCall(handle);
+        return;
+    }
+
+    QMutexLocker locker(&d->lock);
+    bool tracked = d->calls.contains(handle);
+    CallStages &call = d->calls[handle];
+    if (call.source.isEmpty() && handler->provider()) call.source = handler->provider()->providerId();
+
+    d->markStage(call, stage, timestamp);
+    locker.unlock();
+
+    // Calls torn down with their provider are never removed from the manager.
+    if (!tracked)
+    {
+        QObject::connect(handler, &QObject::destroyed, this, [this, handle]() { forgetCall(handle); });
+    }
+}
+
+void VoiceCallStats::markStage(quint64 handle, Stage stage, qint64 timestamp)
+{
+    Q_D(VoiceCallStats);
+    if (!timestamp) timestamp = voicecallMonotonicTimestamp();
+
+    QMutexLocker locker(&d->lock);
+    QHash<quint64, CallStages>::iterator i = d->calls.find(handle);
+    if (i == d->calls.end()) return;
+
+    d->markStage(i.value(), stage, timestamp);
+}
+
+void VoiceCallStats::forgetCall(quint64 handle)
+{
+    Q_D(VoiceCallStats);
+    QMutexLocker locker(&d->lock);
+    d->calls.remove(handle);
+}
+
+void VoiceCallStats::record(const QString &source, const QString &series, qint64 usecs)
+{
+    Q_D(VoiceCallStats);
+    QMutexLocker locker(&d->lock);
+    d->record(source, series, usecs);
+}
+
+QVariantMap VoiceCallStats::histograms() const
+{
+    Q_D(const VoiceCallStats);
+    QMutexLocker locker(&d->lock);
+    QVariantMap results;
+
+    QHash<QString, QHash<QString, Histogram> >::const_iterator source = d->histograms.constBegin();
+    for (; source != d->histograms.constEnd(); ++source)
+    {
+        QVariantMap series;
+
+        QHash<QString, Histogram>::const_iterator i = source.value().constBegin();
+        for (; i != source.value().constEnd(); ++i)
+        {
+            const Histogram &histogram = i.value();
+            QList<uint> buckets;
+            for (int b = 0; b < BUCKET_COUNT; ++b) buckets.append(histogram.buckets[b]);
+
+            QVariantMap entry;
+            entry.insert(QLatin1String("buckets"), QVariant::fromValue(buckets));
+            entry.insert(QLatin1String("count"), histogram.count);
+            entry.insert(QLatin1String("sum"), histogram.sum);
+            entry.insert(QLatin1String("min"), histogram.min);
+            entry.insert(QLatin1String("max"), histogram.max);
+            series.insert(i.key(), entry);
+        }
+
+        results.insert(source.key(), series);
+    }
+
+    return results;
+}
+
+void VoiceCallStats::reset()
+{
+    TRACE
+    Q_D(VoiceCallStats);
+    QMutexLocker locker(&d->lock);
+    d->histograms.clear();
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLSTATS_H
+#define VOICECALLSTATS_H
+
+#include <QObject>
+#include <QVariantMap>
+
+#include <time.h>
+
+class AbstractVoiceCallHandler;
+
+// Monotonic clock shared by the daemon and its clients, in microseconds.
+inline qint64 voicecallMonotonicTimestamp()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * Process wide latency statistics.
+ *
+ * Samples are aggregated into fixed bucket histograms, keyed by source (the
+ * provider or plugin id) and series name. Setup of incoming calls is tracked
+ * per call: each stage records the time since the previous stage under its
+ * own name, and the time since the call was first seen under "<stage>-total".
+ * Providers record their own series with record(), e.g. dial timings.
+ */
+class VoiceCallStats : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Stage {
+        STAGE_CALL_ADDED,       // provider learned about the call
+        STAGE_HANDLER_READY,    // handler properties are available
+        STAGE_MANAGER_ADDED,    // manager registered the call
+        STAGE_DBUS_REGISTERED,  // call object exported on D-Bus
+        STAGE_UI_PRESENTED,     // a client reported the call as shown
+        STAGE_COUNT
+    };
+
+    static VoiceCallStats* instance();
+
+    static QString stageName(Stage stage);
+    static QList<uint> bucketBounds();
+
+    void markStage(AbstractVoiceCallHandler *handler, Stage stage, qint64 timestamp = 0);
+    void markStage(quint64 handle, Stage stage, qint64 timestamp = 0);
+    void forgetCall(quint64 handle);
+
+    void record(const QString &source, const QString &series, qint64 usecs);
+
+    QVariantMap histograms() const;
+
+public Q_SLOTS:
+    void reset();
+
+private:
+    explicit VoiceCallStats(QObject *parent = 0);
+            ~VoiceCallStats();
+
+    class VoiceCallStatsPrivate *d_ptr;
+
+    Q_DISABLE_COPY(VoiceCallStats)
+    Q_DECLARE_PRIVATE(VoiceCallStats)
+
+    friend class VoiceCallStatsHolder;
+};
+
+#endif // VOICECALLSTATS_H
@@ -5,10 +5,6 @@ QT = core dbus qml multimedia
 TARGET = voicecall
 uri = org.nemomobile.voicecall
 
-enable-debug {
-    DEFINES += WANT_TRACE
-}
-
 enable-ngf {
     PKGCONFIG += ngf-qt5
     DEFINES += WITH_NGF
@@ -20,7 +16,8 @@ HEADERS += \
     voicecallmanager.h \
     voicecallmodel.h \
     voicecallprovidermodel.h \
-    voicecallplugin.h
+    voicecallplugin.h \
+    voicecallsequence.h
 
 SOURCES += \
     voicecallaudiorecorder.cpp \
@@ -29,7 +26,8 @@ SOURCES += \
     voicecallmodel.cpp \
     voicecallprovidermodel.cpp \
     voicecallplugin.cpp \
-    ../../../lib/src/common.cpp
+    ../../../lib/src/common.cpp \
+    ../../../lib/src/dbus/voicecallproperties.cpp
 
 OTHER_FILES += qmldir
 
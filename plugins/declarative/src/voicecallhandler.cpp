@@ -2,11 +2,15 @@
 #include "voicecallhandler.h"
 #include "voicecallmanager.h"
 #include "voicecallmodel.h"
+#include "dbus/voicecalldbustypes.h"
 
 #include <QTimer>
 #include <QDBusInterface>
 #include <QDBusPendingReply>
 #include <QDBusReply>
+#include <QDBusArgument>
+#include <QDBusMetaType>
+#include <QMetaMethod>
 #include <QVariantMap>
 #include <QSharedPointer>
 
@@ -25,7 +29,8 @@ public:
         : q_ptr(q), handlerId(pHandlerId), interface(NULL)
         , childCalls(0), parentCall(0), connected(false)
         , duration(0), status(0), emergency(false), multiparty(false)
-        , forwarded(false), remoteHeld(false)
+        , incoming(false), forwarded(false), remoteHeld(false)
+        , connectedAt(0), durationReceivers(0)
     { /* ... */ }
 
     VoiceCallHandler *q_ptr;
@@ -47,26 +52,84 @@ public:
     QDateTime startedAt;
     bool emergency;
     bool multiparty;
+    bool incoming;
     bool forwarded;
     bool remoteHeld;
+    QStringList childCallIds;
+
+    // Properties received from the manager before initialization, if any.
+    VoiceCallProperties seed;
+
+    // The duration of an ongoing call is computed locally from connectedAt,
+    // ticking only while something is connected to durationChanged().
+    qint64 connectedAt;
+    int durationReceivers;
+    QTimer durationTimer;
+
+    bool isOngoing() const
+    {
+        return status == VoiceCallHandler::STATUS_ACTIVE || status == VoiceCallHandler::STATUS_HELD;
+    }
+
+    void updateDurationTimer()
+    {
+        if (durationReceivers > 0 && connectedAt > 0 && isOngoing()) {
+            if (!durationTimer.isActive())
+                durationTimer.start();
+        } else {
+            durationTimer.stop();
+        }
+    }
 };
 
 /*!
   Constructs a new proxy interface for the provided voice call handlerId.
+  If \a properties is valid the proxy is initialized from it instead of
+  fetching the properties from the call object.
 */
-VoiceCallHandler::VoiceCallHandler(const QString &handlerId, QObject *parent)
+VoiceCallHandler::VoiceCallHandler(const QString &handlerId, const VoiceCallProperties &properties, QObject *parent)
     : QObject(parent), d_ptr(new VoiceCallHandlerPrivate(this, handlerId))
 {
     TRACE
     Q_D(VoiceCallHandler);
-    DEBUG_T("Creating D-Bus interface to: %s", qPrintable(handlerId));
-    d->interface = new QDBusInterface("org.nemomobile.voicecall",
-                                      "/calls/" + handlerId,
+    qDBusRegisterMetaType<VoiceCallProperties>();
+    d->seed = properties;
+
+    d->durationTimer.setInterval(1000);
+    QObject::connect(&d->durationTimer, SIGNAL(timeout()), SIGNAL(durationChanged()));
+    createInterface();
+
+    QTimer::singleShot(0, this, SLOT(initialize()));
+}
+
+void VoiceCallHandler::createInterface()
+{
+    Q_D(VoiceCallHandler);
+    DEBUG_T("Creating D-Bus interface to: %s", qPrintable(d->handlerId));
+    QDBusConnection connection = VoiceCallManager::dbusConnection();
+    d->interface = new QDBusInterface(VoiceCallManager::dbusService(),
+                                      "/calls/" + d->handlerId,
                                       "org.nemomobile.voicecall.VoiceCall",
-                                      QDBusConnection::sessionBus(),
+                                      connection,
                                       this);
+}
 
-    QTimer::singleShot(0, this, SLOT(initialize()));
+/*!
+  Moves this proxy to the current connection to the daemon, after the one it
+  was created on went away, and fetches the call properties again.
+*/
+void VoiceCallHandler::reconnect()
+{
+    TRACE
+    Q_D(VoiceCallHandler);
+    d->interface->connection().disconnect(d->interface->service(), d->interface->path(),
+                                          "org.freedesktop.DBus.Properties", "PropertiesChanged",
+                                          this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
+    d->interface->deleteLater();
+
+    createInterface();
+    d->connected = false;
+    initialize();
 }
 
 VoiceCallHandler::~VoiceCallHandler()
@@ -89,20 +152,16 @@ void VoiceCallHandler::initialize(bool notifyError)
     Q_D(VoiceCallHandler);
     bool success = false;
 
+    // A retry scheduled before a reconnect() may come in after it succeeded.
+    if(d->connected) return;
+
     if(d->interface->isValid())
     {
         success = true;
         success &= (bool)QObject::connect(d->interface, SIGNAL(error(QString)), SIGNAL(error(QString)));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(statusChanged(int,QString)), SLOT(onStatusChanged(int,QString)));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(lineIdChanged(QString)), SLOT(onLineIdChanged(QString)));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(durationChanged(int)), SLOT(onDurationChanged(int)));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(startedAtChanged(QDateTime)), SLOT(onStartedAtChanged(QDateTime)));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(emergencyChanged(bool)), SLOT(onEmergencyChanged(bool)));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(multipartyChanged(bool)), SLOT(onMultipartyChanged(bool)));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(forwardedChanged(bool)), SLOT(onForwardedChanged(bool)));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(remoteHeldChanged(bool)), SLOT(onRemoteHeldChanged(bool)));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(parentHandlerIdChanged(QString)), SLOT(onMultipartyHandlerIdChanged(QString)));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(childCallsChanged(QStringList)), SLOT(onChildCallsChanged(QStringList)));
+        success &= d->interface->connection().connect(d->interface->service(), d->interface->path(),
+                                                      "org.freedesktop.DBus.Properties", "PropertiesChanged",
+                                                      this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
     }
 
     if(!(d->connected = success))
@@ -110,46 +169,108 @@ void VoiceCallHandler::initialize(bool notifyError)
         QTimer::singleShot(2000, this, SLOT(initialize()));
         if(notifyError) emit this->error("Failed to connect to VCM D-Bus service.");
     } else {
-        QDBusReply<QVariantMap> reply = d->interface->call("getProperties");
-        if (reply.isValid()) {
-            QVariantMap props = reply.value();
-            d->providerId = props["providerId"].toString();
-            d->duration = props["duration"].toInt();
-            d->status = props["status"].toInt();
-            d->statusText = props["statusText"].toString();
-            d->lineId = props["lineId"].toString();
-            d->startedAt = QDateTime::fromMSecsSinceEpoch(props["startedAt"].toULongLong());
-            d->multiparty = props["isMultiparty"].toBool();
-            d->emergency = props["isEmergency"].toBool();
-            d->forwarded = props["isForwarded"].toBool();
-            d->remoteHeld = props["isRemoteHeld"].toBool();
-            d->parentHandlerId = props["parentHandlerId"].toString();
-            emit durationChanged();
-            emit statusChanged();
-            emit lineIdChanged();
-            emit startedAtChanged();
-            if (d->multiparty)
-                emit multipartyChanged();
-            if (d->emergency)
-                emit emergencyChanged();
-            if (d->forwarded)
-                emit forwardedChanged();
-            if (d->remoteHeld)
-                emit isRemoteHeld();
-            if (!d->parentHandlerId.isEmpty()) {
-                d->parentCall = VoiceCallManager::getCallHandler(d->parentHandlerId);
-                emit parentCallChanged();
-            }
-            if (d->multiparty) {
-                d->childCalls = new VoiceCallModel(this);
-                emit childCallsListChanged();
-                emit childCallsChanged();
+        if (d->seed.isValid()) {
+            setProperties(d->seed);
+            d->seed = VoiceCallProperties();
+        } else {
+            QDBusReply<VoiceCallProperties> reply = d->interface->call("getCallProperties");
+            if (reply.isValid() && reply.value().isValid()) {
+                setProperties(reply.value());
+            } else {
+                // A daemon with another struct version still serves the a{sv} form.
+                QDBusReply<QVariantMap> fallback = d->interface->call("getProperties");
+                if (fallback.isValid())
+                    setProperties(VoiceCallProperties::fromMap(fallback.value()));
+                else if (notifyError)
+                    emit this->error("Failed to getCallProperties() from VCM D-Bus service.");
             }
+        }
+    }
+}
 
-        } else if (notifyError) {
-            emit this->error("Failed to getProperties() from VCM D-Bus service.");
+/*!
+  Updates this proxy from a full set of properties, as returned by getCallProperties().
+*/
+void VoiceCallHandler::setProperties(const VoiceCallProperties &props)
+{
+    TRACE
+    Q_D(VoiceCallHandler);
+    d->providerId = props.providerId;
+    d->duration = props.duration;
+    d->connectedAt = props.connectedAt;
+    d->status = props.status;
+    d->statusText = props.statusText;
+    d->lineId = props.lineId;
+    d->startedAt = QDateTime::fromMSecsSinceEpoch(props.startedAt);
+    d->multiparty = props.isMultiparty;
+    d->emergency = props.isEmergency;
+    d->forwarded = props.isForwarded;
+    d->remoteHeld = props.isRemoteHeld;
+    d->incoming = props.isIncoming;
+    d->parentHandlerId = props.parentHandlerId;
+    d->childCallIds = props.childCalls;
+    d->updateDurationTimer();
+    emit durationChanged();
+    emit statusChanged();
+    emit lineIdChanged();
+    emit startedAtChanged();
+    if (d->multiparty)
+        emit multipartyChanged();
+    if (d->emergency)
+        emit emergencyChanged();
+    if (d->forwarded)
+        emit forwardedChanged();
+    if (d->remoteHeld)
+        emit remoteHeldChanged();
+    if (!d->parentHandlerId.isEmpty()) {
+        d->parentCall = VoiceCallManager::getCallHandler(d->parentHandlerId);
+        emit parentCallChanged();
+    }
+    if (d->multiparty && !d->childCalls) {
+        d->childCalls = new VoiceCallModel(this);
+        emit childCallsListChanged();
+        emit childCallsChanged();
+    }
+}
+
+void VoiceCallHandler::onPropertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated)
+{
+    TRACE
+    Q_D(VoiceCallHandler);
+    if(interface != d->interface->interface()) return;
+
+    QVariantMap values = changed;
+    foreach(const QString &name, invalidated)
+    {
+        values.insert(name, d->interface->property(name.toLatin1().constData()));
+    }
+
+    if(values.contains("connectedAt")) d->connectedAt = values.value("connectedAt").toLongLong();
+    if(values.contains("status") || values.contains("statusText"))
+    {
+        onStatusChanged(values.value("status", d->status).toInt(),
+                        values.value("statusText", d->statusText).toString());
+    }
+    if(values.contains("lineId")) onLineIdChanged(values.value("lineId").toString());
+    if(values.contains("duration")) onDurationChanged(values.value("duration").toInt());
+    if(values.contains("startedAt"))
+    {
+        QVariant startedAt = values.value("startedAt");
+        if(startedAt.userType() == qMetaTypeId<QDBusArgument>())
+        {
+            onStartedAtChanged(qdbus_cast<QDateTime>(startedAt.value<QDBusArgument>()));
+        }
+        else
+        {
+            onStartedAtChanged(startedAt.toDateTime());
         }
     }
+    if(values.contains("isEmergency")) onEmergencyChanged(values.value("isEmergency").toBool());
+    if(values.contains("isMultiparty")) onMultipartyChanged(values.value("isMultiparty").toBool());
+    if(values.contains("isForwarded")) onForwardedChanged(values.value("isForwarded").toBool());
+    if(values.contains("isRemoteHeld")) onRemoteHeldChanged(values.value("isRemoteHeld").toBool());
+    if(values.contains("parentHandlerId")) onMultipartyHandlerIdChanged(values.value("parentHandlerId").toString());
+    if(values.contains("childCalls")) onChildCallsChanged(values.value("childCalls").toStringList());
 }
 
 void VoiceCallHandler::onDurationChanged(int duration)
@@ -165,6 +286,7 @@ void VoiceCallHandler::onStatusChanged(int status, const QString &statusText)
     Q_D(VoiceCallHandler);
     d->status = status;
     d->statusText = statusText;
+    d->updateDurationTimer();
     emit statusChanged();
 }
 
@@ -231,8 +353,9 @@ void VoiceCallHandler::onMultipartyHandlerIdChanged(QString handlerId)
 
 void VoiceCallHandler::onChildCallsChanged(const QStringList &calls)
 {
-    Q_UNUSED(calls);
     TRACE
+    Q_D(VoiceCallHandler);
+    d->childCallIds = calls;
     emit childCallsListChanged();
 }
 
@@ -291,11 +414,13 @@ QDateTime VoiceCallHandler::startedAt() const
 }
 
 /*!
-  Returns this voice calls' duration property.
+  Returns this voice calls' duration property, in seconds.
  */
 int VoiceCallHandler::duration() const
 {
     Q_D(const VoiceCallHandler);
+    if (d->connectedAt > 0 && d->isOngoing())
+        return int(qRound((voicecallBootTimestamp() - d->connectedAt) / 1000.0));
     return d->duration;
 }
 
@@ -305,7 +430,7 @@ int VoiceCallHandler::duration() const
 bool VoiceCallHandler::isIncoming() const
 {
     Q_D(const VoiceCallHandler);
-    return d->interface->property("isIncoming").toBool();
+    return d->incoming;
 }
 
 /*!
@@ -341,6 +466,15 @@ VoiceCallModel* VoiceCallHandler::childCalls() const
     return d->childCalls;
 }
 
+/*!
+  Returns the handler ids of the calls in this conference call.
+ */
+QStringList VoiceCallHandler::childCallIds() const
+{
+    Q_D(const VoiceCallHandler);
+    return d->childCallIds;
+}
+
 VoiceCallHandler* VoiceCallHandler::parentCall() const
 {
     Q_D(const VoiceCallHandler);
@@ -439,6 +573,24 @@ void VoiceCallHandler::split()
     QObject::connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)), SLOT(onPendingCallFinished(QDBusPendingCallWatcher*)));
 }
 
+void VoiceCallHandler::connectNotify(const QMetaMethod &signal)
+{
+    Q_D(VoiceCallHandler);
+    if (signal == QMetaMethod::fromSignal(&VoiceCallHandler::durationChanged)) {
+        d->durationReceivers++;
+        d->updateDurationTimer();
+    }
+}
+
+void VoiceCallHandler::disconnectNotify(const QMetaMethod &signal)
+{
+    Q_D(VoiceCallHandler);
+    if (signal == QMetaMethod::fromSignal(&VoiceCallHandler::durationChanged)) {
+        d->durationReceivers--;
+        d->updateDurationTimer();
+    }
+}
+
 void VoiceCallHandler::onPendingCallFinished(QDBusPendingCallWatcher *watcher)
 {
     TRACE
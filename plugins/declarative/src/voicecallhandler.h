@@ -7,6 +7,8 @@
 #include <QDBusInterface>
 #include <QDBusPendingCallWatcher>
 
+#include "dbus/voicecallproperties.h"
+
 class VoiceCallModel;
 
 class VoiceCallHandler : public QObject
@@ -42,10 +44,11 @@ public:
         STATUS_DISCONNECTED
     };
 
-    explicit VoiceCallHandler(const QString &handlerId, QObject *parent = 0);
+    explicit VoiceCallHandler(const QString &handlerId, const VoiceCallProperties &properties = VoiceCallProperties(), QObject *parent = 0);
             ~VoiceCallHandler();
 
     QDBusInterface* interface() const;
+    void reconnect();
 
     QString handlerId() const;
     QString providerId() const;
@@ -60,6 +63,7 @@ public:
     bool isForwarded() const;
     bool isRemoteHeld() const;
     VoiceCallModel* childCalls() const;
+    QStringList childCallIds() const;
     VoiceCallHandler* parentCall() const;
 
 Q_SIGNALS:
@@ -89,6 +93,8 @@ protected Q_SLOTS:
     void initialize(bool notifyError = false);
 
     void onPendingCallFinished(QDBusPendingCallWatcher *watcher);
+    void onPropertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated);
+    void setProperties(const VoiceCallProperties &props);
     void onDurationChanged(int duration);
     void onStatusChanged(int status, const QString &statusText);
     void onLineIdChanged(const QString &lineId);
@@ -100,7 +106,13 @@ protected Q_SLOTS:
     void onMultipartyHandlerIdChanged(QString handlerId);
     void onChildCallsChanged(const QStringList &);
 
+protected:
+    void connectNotify(const QMetaMethod &signal);
+    void disconnectNotify(const QMetaMethod &signal);
+
 private:
+    void createInterface();
+
     class VoiceCallHandlerPrivate *d_ptr;
 
     Q_DISABLE_COPY(VoiceCallHandler)
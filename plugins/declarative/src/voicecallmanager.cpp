@@ -1,5 +1,9 @@
 #include "common.h"
 #include "voicecallmanager.h"
+#include "voicecallhandle.h"
+#include "voicecallsequence.h"
+#include "dbus/voicecalldbustypes.h"
+#include "dbus/voicecallproperties.h"
 
 #ifdef WITH_NGF
 #include <NgfClient>
@@ -10,6 +14,10 @@
 #include <QTimer>
 #include <QDBusInterface>
 #include <QDBusPendingReply>
+#include <QDBusReply>
+#include <QDBusMetaType>
+#include <QDBusServiceWatcher>
+#include <QDBusConnectionInterface>
 #include <QSharedPointer>
 #include <QGlobalStatic>
 
@@ -28,7 +36,8 @@ public:
           ngf(0),
 #endif
           eventId(0),
-          connected(false)
+          connected(false),
+          serviceWatcher(NULL)
     { /*...*/ }
 
     VoiceCallManager *q_ptr;
@@ -49,18 +58,276 @@ public:
     bool connected;
 
     QString modemPath;
+
+    // Local copy of the manager properties, kept up to date from PropertiesChanged.
+    QVariantMap properties;
+
+    // Sequence number of the last call change applied, from GetCalls or a CallAdded/CallRemoved signal.
+    VoiceCallSequence sequence;
+    QStringList callIds;
+
+    // Sequence numbers start over with a new daemon, whose calls are fetched again.
+    QDBusServiceWatcher *serviceWatcher;
+
+    bool fetchCalls();
+    bool fetchProperties();
+
+    void createInterface();
+    bool watchSignals(bool on);
+    void reconnect();
+    void reconnectCalls();
 };
 
+typedef QHash<quint64, QWeakPointer<VoiceCallHandler>> VoiceCallHandlerMap;
+Q_GLOBAL_STATIC(VoiceCallHandlerMap, callHandlers);
+
+// Properties of calls from the last snapshot which have no handler yet.
+typedef QHash<QString, VoiceCallProperties> VoiceCallSnapshots;
+Q_GLOBAL_STATIC(VoiceCallSnapshots, callSnapshots);
+
+/*
+  Connection to the daemon shared by all managers and call handlers in the
+  process: a direct peer connection when the daemon offers one, otherwise
+  the session bus. Peer connections carry no bus names, so the service is
+  empty then.
+*/
+class VoiceCallConnection
+{
+public:
+    VoiceCallConnection()
+        : connection(QDBusConnection::sessionBus())
+    {
+        QDBusConnectionInterface *bus = connection.interface();
+        if (bus)
+            owner = bus->serviceOwner(serviceName());
+        attach();
+    }
+
+    // Follows the daemon's bus name, a new daemon has a new peer socket and
+    // without one the session bus is used until it is back.
+    void setOwner(const QString &newOwner)
+    {
+        if (owner == newOwner && connection.isConnected())
+            return;
+
+        owner = newOwner;
+        if (owner.isEmpty()) {
+            QDBusConnection::disconnectFromPeer(peerName());
+            connection = QDBusConnection::sessionBus();
+            service = serviceName();
+        } else {
+            attach();
+        }
+    }
+
+    void attach()
+    {
+        TRACE
+        connection = QDBusConnection::sessionBus();
+        service = serviceName();
+
+        QDBusMessage message = QDBusMessage::createMethodCall(service, "/",
+                                                              "org.nemomobile.voicecall.VoiceCallManager",
+                                                              "GetPeerAddress");
+        QDBusReply<QString> reply = connection.call(message);
+        if (!reply.isValid() || reply.value().isEmpty())
+            return;
+
+        QDBusConnection::disconnectFromPeer(peerName());
+        QDBusConnection peer = QDBusConnection::connectToPeer(reply.value(), peerName());
+        if (peer.isConnected()) {
+            DEBUG_T("Attached to voicecall-manager at %s", qPrintable(reply.value()));
+            connection = peer;
+            service.clear();
+        } else {
+            WARNING_T("Failed to attach to %s, using the session bus: %s", qPrintable(reply.value()),
+                      qPrintable(peer.lastError().message()));
+            QDBusConnection::disconnectFromPeer(peerName());
+        }
+    }
+
+    static QString peerName() { return QLatin1String("voicecall-manager-peer"); }
+    static QString serviceName() { return QLatin1String("org.nemomobile.voicecall"); }
+
+    QDBusConnection connection;
+    QString service;
+    QString owner;
+};
+
+Q_GLOBAL_STATIC(VoiceCallConnection, voicecallConnection);
+
+bool VoiceCallManagerPrivate::fetchCalls()
+{
+    TRACE
+    QDBusMessage message = QDBusMessage::createMethodCall(interface->service(), interface->path(),
+                                                          interface->interface(), "GetCallList");
+    QDBusMessage reply = interface->connection().call(message);
+
+    if(reply.type() != QDBusMessage::ReplyMessage || reply.arguments().count() != 2)
+    {
+        WARNING_T("Failed to get voice calls: %s", qPrintable(reply.errorMessage()));
+        return false;
+    }
+
+    VoiceCallPropertiesList calls = qdbus_cast<VoiceCallPropertiesList>(reply.arguments().at(0));
+    foreach(const VoiceCallProperties &call, calls)
+    {
+        if(call.isValid()) continue;
+
+        // A daemon with another struct version still serves the a{sv} form.
+        DEBUG_T("Unknown call properties version %u, falling back to GetCalls", call.version);
+        reply = interface->connection().call(QDBusMessage::createMethodCall(interface->service(), interface->path(),
+                                                                            interface->interface(), "GetCalls"));
+        if(reply.type() != QDBusMessage::ReplyMessage || reply.arguments().count() != 2)
+        {
+            WARNING_T("Failed to get voice calls: %s", qPrintable(reply.errorMessage()));
+            return false;
+        }
+
+        calls.clear();
+        VoiceCallPropertiesMap map = qdbus_cast<VoiceCallPropertiesMap>(reply.arguments().at(0));
+        for(VoiceCallPropertiesMap::const_iterator it = map.constBegin(); it != map.constEnd(); ++it)
+        {
+            calls.append(VoiceCallProperties::fromMap(it.value()));
+        }
+        break;
+    }
+
+    sequence.reset(reply.arguments().at(1).toULongLong());
+    callIds.clear();
+
+    callSnapshots->clear();
+    foreach(const VoiceCallProperties &call, calls)
+    {
+        callIds.append(call.handlerId);
+        quint64 handle = VoiceCallHandle::valueOf(call.handlerId);
+        if(handle && callHandlers->value(handle).isNull())
+        {
+            callSnapshots->insert(call.handlerId, call);
+        }
+    }
+
+    return true;
+}
+
+bool VoiceCallManagerPrivate::fetchProperties()
+{
+    TRACE
+    Q_Q(VoiceCallManager);
+    QDBusMessage message = QDBusMessage::createMethodCall(interface->service(), interface->path(),
+                                                          "org.freedesktop.DBus.Properties", "GetAll");
+    message << interface->interface();
+
+    QDBusReply<QVariantMap> reply = interface->connection().call(message);
+    if(!reply.isValid())
+    {
+        WARNING_T("Failed to get manager properties: %s", qPrintable(reply.error().message()));
+        return false;
+    }
+
+    q->onPropertiesChanged(interface->interface(), reply.value(), QStringList());
+    return true;
+}
+
+void VoiceCallManagerPrivate::createInterface()
+{
+    Q_Q(VoiceCallManager);
+    interface = new QDBusInterface(VoiceCallManager::dbusService(),
+                                   "/",
+                                   "org.nemomobile.voicecall.VoiceCallManager",
+                                   VoiceCallManager::dbusConnection(),
+                                   q);
+}
+
+bool VoiceCallManagerPrivate::watchSignals(bool on)
+{
+    Q_Q(VoiceCallManager);
+    QDBusConnection connection = interface->connection();
+    const QString service = interface->service();
+    const QString path = interface->path();
+    bool success = true;
+
+    if(on)
+    {
+        success &= connection.connect(service, path, "org.freedesktop.DBus.Properties", "PropertiesChanged",
+                                      q, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
+        success &= connection.connect(service, path, interface->interface(), "CallAdded",
+                                      q, SLOT(onCallAdded(qulonglong,QString,QVariantMap)));
+        success &= connection.connect(service, path, interface->interface(), "CallRemoved",
+                                      q, SLOT(onCallRemoved(qulonglong,QString)));
+
+        // Qt may consume this itself, the service watcher covers daemon exits either way.
+        if(service.isEmpty())
+            connection.connect(QString(), "/org/freedesktop/DBus/Local", "org.freedesktop.DBus.Local", "Disconnected",
+                               q, SLOT(onConnectionLost()));
+    }
+    else
+    {
+        connection.disconnect(service, path, "org.freedesktop.DBus.Properties", "PropertiesChanged",
+                              q, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
+        connection.disconnect(service, path, interface->interface(), "CallAdded",
+                              q, SLOT(onCallAdded(qulonglong,QString,QVariantMap)));
+        connection.disconnect(service, path, interface->interface(), "CallRemoved",
+                              q, SLOT(onCallRemoved(qulonglong,QString)));
+        if(service.isEmpty())
+            connection.disconnect(QString(), "/org/freedesktop/DBus/Local", "org.freedesktop.DBus.Local", "Disconnected",
+                                  q, SLOT(onConnectionLost()));
+    }
+
+    return success;
+}
+
+/*!
+  Replaces the manager interface with one on the current connection to the
+  daemon, and syncs with the daemon again.
+*/
+void VoiceCallManagerPrivate::reconnect()
+{
+    Q_Q(VoiceCallManager);
+    if(interface)
+    {
+        watchSignals(false);
+        interface->deleteLater();
+    }
+
+    createInterface();
+    connected = false;
+    sequence.reset();
+    q->initialize();
+}
+
+/*!
+  Rebinds the live call objects still on a previous connection.
+*/
+void VoiceCallManagerPrivate::reconnectCalls()
+{
+    const QString connectionName = interface->connection().name();
+    foreach(const QString &handlerId, callIds)
+    {
+        quint64 handle = VoiceCallHandle::valueOf(handlerId);
+        if(!handle) continue;
+
+        QSharedPointer<VoiceCallHandler> handler = callHandlers->value(handle).toStrongRef();
+        if(handler && handler->interface()->connection().name() != connectionName)
+            handler->reconnect();
+    }
+}
+
 VoiceCallManager::VoiceCallManager(QObject *parent)
     : QObject(parent), d_ptr(new VoiceCallManagerPrivate(this))
 {
     TRACE
     Q_D(VoiceCallManager);
-    d->interface = new QDBusInterface("org.nemomobile.voicecall",
-                                      "/",
-                                      "org.nemomobile.voicecall.VoiceCallManager",
-                                      QDBusConnection::sessionBus(),
-                                      this);
+    qDBusRegisterMetaType<VoiceCallPropertiesMap>();
+    qDBusRegisterMetaType<VoiceCallProperties>();
+    qDBusRegisterMetaType<VoiceCallPropertiesList>();
+
+    d->createInterface();
+
+    d->serviceWatcher = new QDBusServiceWatcher(VoiceCallConnection::serviceName(), QDBusConnection::sessionBus(),
+                                                QDBusServiceWatcher::WatchForOwnerChange, this);
+    QObject::connect(d->serviceWatcher, SIGNAL(serviceOwnerChanged(QString,QString,QString)),
+                     SLOT(onServiceOwnerChanged(QString,QString,QString)));
 
     d->voicecalls = new VoiceCallModel(this);
     d->providers = new VoiceCallProviderModel(this);
@@ -81,25 +348,33 @@ void VoiceCallManager::initialize(bool notifyError)
     Q_D(VoiceCallManager);
     bool success = false;
 
+    // A retry scheduled before a reconnect() may come in after it succeeded.
+    if(d->connected) return;
+
 #ifdef WITH_NGF
-    d->ngf = new Ngf::Client(this);
-    d->ngf->connect();
+    if(!d->ngf)
+    {
+        d->ngf = new Ngf::Client(this);
+        d->ngf->connect();
+    }
 #endif
 
     if(d->interface->isValid())
     {
         success = true;
         success &= (bool)QObject::connect(d->interface, SIGNAL(error(QString)), SIGNAL(error(QString)));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(voiceCallsChanged()), SLOT(onVoiceCallsChanged()));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(providersChanged()), SLOT(onProvidersChanged()));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(activeVoiceCallChanged()), SLOT(onActiveVoiceCallChanged()));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(audioModeChanged()), SIGNAL(audioModeChanged()));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(audioRoutedChanged()), SIGNAL(audioRoutedChanged()));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(microphoneMutedChanged()), SIGNAL(microphoneMutedChanged()));
-        success &= (bool)QObject::connect(d->interface, SIGNAL(speakerMutedChanged()), SIGNAL(speakerMutedChanged()));
-
-        onActiveVoiceCallChanged();
-        onVoiceCallsChanged();
+        success &= d->watchSignals(true);
+
+        if(success)
+        {
+            // Snapshot the calls first, so their handlers need no round trips when the models pick them up.
+            if(d->fetchCalls())
+            {
+                d->reconnectCalls();
+                emit voiceCallsReset();
+            }
+            d->fetchProperties();
+        }
     }
 
     if(!(d->connected = success))
@@ -109,6 +384,26 @@ void VoiceCallManager::initialize(bool notifyError)
     }
 }
 
+/*!
+  Returns the connection to the daemon, a direct peer connection if the daemon
+  offers one and it is still open, otherwise the session bus.
+*/
+QDBusConnection VoiceCallManager::dbusConnection()
+{
+    // Reattach after the daemon went away, its peer socket died with it.
+    if (!voicecallConnection->connection.isConnected())
+        voicecallConnection->attach();
+    return voicecallConnection->connection;
+}
+
+/*!
+  Returns the service name to use on dbusConnection(), empty on a peer connection.
+*/
+QString VoiceCallManager::dbusService()
+{
+    return voicecallConnection->service;
+}
+
 QDBusInterface* VoiceCallManager::interface() const
 {
     Q_D(const VoiceCallManager);
@@ -158,6 +453,24 @@ VoiceCallHandler* VoiceCallManager::activeVoiceCall() const
     return d->activeVoiceCall;
 }
 
+/*!
+  Returns the handler ids of the current voice calls.
+*/
+QStringList VoiceCallManager::voiceCallIds() const
+{
+    Q_D(const VoiceCallManager);
+    return d->callIds;
+}
+
+/*!
+  Returns the registered providers, as "id:type" strings.
+*/
+QStringList VoiceCallManager::providerIds() const
+{
+    Q_D(const VoiceCallManager);
+    return d->properties.value("providers").toStringList();
+}
+
 QString VoiceCallManager::modemPath() const
 {
     Q_D(const VoiceCallManager);
@@ -177,26 +490,26 @@ void VoiceCallManager::setModemPath(const QString &modemPath)
 QString VoiceCallManager::audioMode() const
 {
     Q_D(const VoiceCallManager);
-    return d->interface->property("audioMode").toString();
+    return d->properties.value("audioMode").toString();
 }
 
 bool VoiceCallManager::isAudioRouted() const
 {
     TRACE
     Q_D(const VoiceCallManager);
-    return d->interface->property("isAudioRouted").toBool();
+    return d->properties.value("isAudioRouted").toBool();
 }
 
 bool VoiceCallManager::isMicrophoneMuted() const
 {
     Q_D(const VoiceCallManager);
-    return d->interface->property("isMicrophoneMuted").toBool();
+    return d->properties.value("isMicrophoneMuted").toBool();
 }
 
 bool VoiceCallManager::isSpeakerMuted() const
 {
     Q_D(const VoiceCallManager);
-    return d->interface->property("isSpeakerMuted").toBool();
+    return d->properties.value("isSpeakerMuted").toBool();
 }
 
 bool VoiceCallManager::isDebugEnabled() const
@@ -340,7 +653,7 @@ void VoiceCallManager::onActiveVoiceCallChanged()
 {
     TRACE
     Q_D(VoiceCallManager);
-    QString voiceCallId = d->interface->property("activeVoiceCall").toString();
+    QString voiceCallId = d->properties.value("activeVoiceCall").toString();
 
     if(d->voicecalls->rowCount(QModelIndex()) == 0 || voiceCallId.isNull() || voiceCallId.isEmpty())
     {
@@ -354,6 +667,130 @@ void VoiceCallManager::onActiveVoiceCallChanged()
     emit this->activeVoiceCallChanged();
 }
 
+void VoiceCallManager::onPropertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated)
+{
+    TRACE
+    Q_D(VoiceCallManager);
+    if(interface != d->interface->interface()) return;
+
+    QStringList names = changed.keys() + invalidated;
+
+    for(QVariantMap::const_iterator it = changed.constBegin(); it != changed.constEnd(); ++it)
+    {
+        d->properties.insert(it.key(), it.value());
+    }
+
+    // Only fetch what the daemon did not send along.
+    foreach(const QString &name, invalidated)
+    {
+        d->properties.insert(name, d->interface->property(name.toLatin1().constData()));
+    }
+
+    // Update the models first, the active call is looked up in them.
+    if(names.contains("providers")) onProvidersChanged();
+    if(names.contains("voiceCalls")) onVoiceCallsChanged();
+    if(names.contains("activeVoiceCall")) onActiveVoiceCallChanged();
+
+    if(names.contains("audioMode")) emit audioModeChanged();
+    if(names.contains("isAudioRouted")) emit audioRoutedChanged();
+    if(names.contains("isMicrophoneMuted")) emit microphoneMutedChanged();
+    if(names.contains("isSpeakerMuted")) emit speakerMutedChanged();
+}
+
+void VoiceCallManager::onCallAdded(qulonglong sequence, const QString &handlerId, const QVariantMap &properties)
+{
+    TRACE
+    Q_D(VoiceCallManager);
+    switch(d->sequence.check(sequence))
+    {
+    case VoiceCallSequence::Ignore: return; // Already part of the last snapshot.
+    case VoiceCallSequence::Resync: resyncVoiceCalls(); return;
+    case VoiceCallSequence::Apply: break;
+    }
+
+    if(!d->callIds.contains(handlerId)) d->callIds.append(handlerId);
+    quint64 handle = VoiceCallHandle::valueOf(handlerId);
+    if(handle && callHandlers->value(handle).isNull())
+    {
+        callSnapshots->insert(handlerId, VoiceCallProperties::fromMap(properties));
+    }
+
+    emit voiceCallAdded(handlerId);
+}
+
+void VoiceCallManager::onCallRemoved(qulonglong sequence, const QString &handlerId)
+{
+    TRACE
+    Q_D(VoiceCallManager);
+    switch(d->sequence.check(sequence))
+    {
+    case VoiceCallSequence::Ignore: return;
+    case VoiceCallSequence::Resync: resyncVoiceCalls(); return;
+    case VoiceCallSequence::Apply: break;
+    }
+
+    d->callIds.removeAll(handlerId);
+    callSnapshots->remove(handlerId);
+
+    emit voiceCallRemoved(handlerId);
+}
+
+/*!
+  Drops the local call list and fetches a fresh snapshot, after a missed
+  CallAdded or CallRemoved signal.
+*/
+void VoiceCallManager::resyncVoiceCalls()
+{
+    TRACE
+    Q_D(VoiceCallManager);
+    WARNING_T("Missed a voice call change after %llu, resyncing.", d->sequence.generation());
+    if(d->fetchCalls())
+    {
+        emit voiceCallsReset();
+        onActiveVoiceCallChanged();
+    }
+}
+
+/*!
+  Drops the calls of a daemon that went away, and fetches those of the one
+  that replaced it, whose sequence numbers start over.
+*/
+void VoiceCallManager::onServiceOwnerChanged(const QString &service, const QString &oldOwner, const QString &newOwner)
+{
+    TRACE
+    Q_D(VoiceCallManager);
+    Q_UNUSED(service)
+    DEBUG_T("voicecall-manager owner changed from '%s' to '%s'", qPrintable(oldOwner), qPrintable(newOwner));
+
+    d->sequence.reset();
+    voicecallConnection->setOwner(newOwner);
+
+    if(newOwner.isEmpty())
+    {
+        d->callIds.clear();
+        callSnapshots->clear();
+        d->properties.remove("activeVoiceCall");
+        emit voiceCallsReset();
+        onActiveVoiceCallChanged();
+    }
+
+    // Until a new daemon shows up this keeps retrying on the session bus.
+    d->reconnect();
+    onActiveVoiceCallChanged();
+}
+
+/*!
+  Moves to a new connection after the peer connection to the daemon closed.
+*/
+void VoiceCallManager::onConnectionLost()
+{
+    TRACE
+    Q_D(VoiceCallManager);
+    WARNING_T("Lost the peer connection to voicecall-manager, reconnecting.");
+    d->reconnect();
+    onActiveVoiceCallChanged();
+}
+
 void VoiceCallManager::onPendingCallFinished(QDBusPendingCallWatcher *watcher)
 {
     TRACE
@@ -382,16 +819,21 @@ void VoiceCallManager::onPendingSilenceFinished(QDBusPendingCallWatcher *watcher
     watcher->deleteLater();
 }
 
-typedef QMap<QString, QWeakPointer<VoiceCallHandler>> VoiceCallHandlerMap;
-Q_GLOBAL_STATIC(VoiceCallHandlerMap, callHandlers);
-
 QSharedPointer<VoiceCallHandler> VoiceCallManager::getCallHandler(const QString &handlerId)
 {
-    QSharedPointer<VoiceCallHandler> handler = callHandlers->value(handlerId);
+    quint64 handle = VoiceCallHandle::valueOf(handlerId);
+    QSharedPointer<VoiceCallHandler> handler;
+    if (handle)
+        handler = callHandlers->value(handle);
     if (handler.isNull()) {
-        handler.reset(new VoiceCallHandler(handlerId), &QObject::deleteLater);
+        handler.reset(new VoiceCallHandler(handlerId, callSnapshots->take(handlerId)), &QObject::deleteLater);
         QQmlEngine::setObjectOwnership(handler.data(), QQmlEngine::CppOwnership);
-        callHandlers->insert(handlerId, handler);
+
+        // Invalid ids would all share one key, such handlers are not shared.
+        if (handle)
+            callHandlers->insert(handle, handler);
+        else
+            WARNING_T("Invalid voice call id: %s", qPrintable(handlerId));
     }
 
     // Cleanup any destroyed handlers
@@ -43,6 +43,9 @@ public:
 
     VoiceCallHandler* activeVoiceCall() const;
 
+    QStringList voiceCallIds() const;
+    QStringList providerIds() const;
+
     QString modemPath() const;
     void setModemPath(const QString &modemPath);
 
@@ -56,12 +59,19 @@ public:
 
     static QSharedPointer<VoiceCallHandler> getCallHandler(const QString &handlerId);
 
+    static QDBusConnection dbusConnection();
+    static QString dbusService();
+
 Q_SIGNALS:
     void error(const QString &message);
 
     void providersChanged();
     void voiceCallsChanged();
 
+    void voiceCallAdded(const QString &handlerId);
+    void voiceCallRemoved(const QString &handlerId);
+    void voiceCallsReset();
+
     void defaultProviderChanged();
 
     void activeVoiceCallChanged();
@@ -93,6 +103,13 @@ protected Q_SLOTS:
     void onVoiceCallsChanged();
     void onActiveVoiceCallChanged();
 
+    void onPropertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated);
+    void onCallAdded(qulonglong sequence, const QString &handlerId, const QVariantMap &properties);
+    void onCallRemoved(qulonglong sequence, const QString &handlerId);
+    void resyncVoiceCalls();
+    void onServiceOwnerChanged(const QString &service, const QString &oldOwner, const QString &newOwner);
+    void onConnectionLost();
+
     void onPendingCallFinished(QDBusPendingCallWatcher *watcher);
     void onPendingSilenceFinished(QDBusPendingCallWatcher *watcher);
 
@@ -40,8 +40,13 @@
 #include "voicecallmodel.h"
 
 #include "voicecallmanager.h"
+#include "voicecallstats.h"
 
+#include <QDBusConnection>
+#include <QDBusInterface>
+#include <QDBusMessage>
 #include <QSharedPointer>
+#include <QSet>
 
 class VoiceCallModelPrivate
 {
@@ -64,8 +69,52 @@ public:
     QList<QSharedPointer<VoiceCallHandler>> handlers;
 
     QHash<int, QByteArray> headerData;
+
+    int indexOf(const QString &handlerId) const
+    {
+        for (int i = 0; i < handlers.count(); ++i) {
+            if (handlers.at(i)->handlerId() == handlerId)
+                return i;
+        }
+        return -1;
+    }
+
+    void appendHandler(const QString &handlerId);
+    void reportPresented(const QStringList &handlerIds);
 };
 
+void VoiceCallModelPrivate::appendHandler(const QString &handlerId)
+{
+    Q_Q(VoiceCallModel);
+    QSharedPointer<VoiceCallHandler> handler = VoiceCallManager::getCallHandler(handlerId);
+    QObject::connect(handler.data(), SIGNAL(emergencyChanged()), q, SLOT(propertyChanged()));
+    QObject::connect(handler.data(), SIGNAL(lineIdChanged()), q, SLOT(propertyChanged()));
+    QObject::connect(handler.data(), SIGNAL(multipartyChanged()), q, SLOT(propertyChanged()));
+    QObject::connect(handler.data(), SIGNAL(startedAtChanged()), q, SLOT(propertyChanged()));
+    QObject::connect(handler.data(), SIGNAL(statusChanged()), q, SLOT(propertyChanged()));
+    QObject::connect(handler.data(), SIGNAL(parentCallChanged()), q, SLOT(propertyChanged()));
+    handlers.append(handler);
+}
+
+void VoiceCallModelPrivate::reportPresented(const QStringList &handlerIds)
+{
+    if (!manager)
+        return;
+
+    // Let the daemon close its call setup latency measurement.
+    qint64 presentedAt = voicecallMonotonicTimestamp();
+    QDBusInterface *interface = manager->interface();
+
+    foreach(QString handlerId, handlerIds)
+    {
+        QDBusMessage message = QDBusMessage::createMethodCall(interface->service(), interface->path(),
+                                                              "org.nemomobile.voicecall.Stats",
+                                                              "ReportCallPresented");
+        message << handlerId << presentedAt;
+        interface->connection().send(message);
+    }
+}
+
 VoiceCallModel::VoiceCallModel(VoiceCallManager *manager)
     : QAbstractListModel(manager), d_ptr(new VoiceCallModelPrivate(this, manager))
 {
@@ -73,7 +122,9 @@ VoiceCallModel::VoiceCallModel(VoiceCallManager *manager)
     Q_D(VoiceCallModel);
     init();
     // Need to listen for signal on the manager, because it handles connectivity to VCM.
-    QObject::connect(d->manager, SIGNAL(voiceCallsChanged()), SLOT(onVoiceCallsChanged()));
+    QObject::connect(d->manager, SIGNAL(voiceCallAdded(QString)), SLOT(onVoiceCallAdded(QString)));
+    QObject::connect(d->manager, SIGNAL(voiceCallRemoved(QString)), SLOT(onVoiceCallRemoved(QString)));
+    QObject::connect(d->manager, SIGNAL(voiceCallsReset()), SLOT(onVoiceCallsChanged()));
 }
 
 VoiceCallModel::VoiceCallModel(VoiceCallHandler *conf)
@@ -166,66 +217,76 @@ void VoiceCallModel::onVoiceCallsChanged()
     TRACE
     Q_D(VoiceCallModel);
     QStringList nIds;
-    QStringList oIds;
-
     QStringList added;
-    QStringList removed;
 
     if (d->manager)
-        nIds = d->manager->interface()->property("voiceCalls").toStringList();
+        nIds = d->manager->voiceCallIds();
     else
-        nIds = d->confHandler->interface()->property("childCalls").toStringList();
-
-    // Map current call handlers to handler ids for easy indexing.
-    foreach(QSharedPointer<VoiceCallHandler> handler, d->handlers)
-    {
-        oIds.append(handler->handlerId());
+        nIds = d->confHandler->childCallIds();
+
+    QSet<QString> nSet = nIds.toSet();
+    QSet<QString> oSet;
+
+    // Remove handlers that are gone, walking backwards so the rows stay valid.
+    for (int i = d->handlers.count() - 1; i >= 0; --i) {
+        VoiceCallHandler *handler = d->handlers.at(i).data();
+        if (!nSet.contains(handler->handlerId())) {
+            beginRemoveRows(QModelIndex(), i, i);
+            handler->disconnect(this);
+            d->handlers.removeAt(i);
+            endRemoveRows();
+        } else {
+            oSet.insert(handler->handlerId());
+        }
     }
 
-    // Index new handlers to be added.
     foreach(QString nId, nIds)
     {
-        if(!oIds.contains(nId)) added.append(nId);
-    }
-
-    // Index old handlers to be removed.
-    foreach(QString oId, oIds)
-    {
-        if(!nIds.contains(oId)) removed.append(oId);
+        if(!oSet.contains(nId)) added.append(nId);
     }
 
-    // Remove handlers that need to be removed.
-    foreach(QString removeId, removed)
-    {
-        for (int i = 0; i < d->handlers.count(); ++i) {
-            VoiceCallHandler *handler = d->handlers.at(i).data();
-            if(handler->handlerId() == removeId)
-            {
-                beginRemoveRows(QModelIndex(), i, i);
-                handler->disconnect(this);
-                d->handlers.removeAt(i);
-                endRemoveRows();
-                break;
-            }
+    if (added.count()) {
+        beginInsertRows(QModelIndex(), d->handlers.count(), d->handlers.count() + added.count() - 1);
+        foreach(QString addId, added)
+        {
+            d->appendHandler(addId);
         }
-    }
+        endInsertRows();
 
-    if (added.count())
-        beginInsertRows(QModelIndex(), d->handlers.count(), d->handlers.count() + added.count() - 1);
-    // Add handlers that need to be added.
-    foreach(QString addId, added)
-    {
-        QSharedPointer<VoiceCallHandler> handler = VoiceCallManager::getCallHandler(addId);
-        connect(handler.data(), SIGNAL(emergencyChanged()), this, SLOT(propertyChanged()));
-        connect(handler.data(), SIGNAL(lineIdChanged()), this, SLOT(propertyChanged()));
-        connect(handler.data(), SIGNAL(multipartyChanged()), this, SLOT(propertyChanged()));
-        connect(handler.data(), SIGNAL(startedAtChanged()), this, SLOT(propertyChanged()));
-        connect(handler.data(), SIGNAL(statusChanged()), this, SLOT(propertyChanged()));
-        connect(handler.data(), SIGNAL(parentCallChanged()), this, SLOT(propertyChanged()));
-        d->handlers.append(handler);
+        d->reportPresented(added);
     }
-    if (added.count())
-        endInsertRows();
+
+    emit this->countChanged();
+}
+
+void VoiceCallModel::onVoiceCallAdded(const QString &handlerId)
+{
+    TRACE
+    Q_D(VoiceCallModel);
+    if (d->indexOf(handlerId) >= 0)
+        return;
+
+    beginInsertRows(QModelIndex(), d->handlers.count(), d->handlers.count());
+    d->appendHandler(handlerId);
+    endInsertRows();
+
+    d->reportPresented(QStringList() << handlerId);
+
+    emit this->countChanged();
+}
+
+void VoiceCallModel::onVoiceCallRemoved(const QString &handlerId)
+{
+    TRACE
+    Q_D(VoiceCallModel);
+    int i = d->indexOf(handlerId);
+    if (i < 0)
+        return;
+
+    beginRemoveRows(QModelIndex(), i, i);
+    d->handlers.at(i)->disconnect(this);
+    d->handlers.removeAt(i);
+    endRemoveRows();
 
     emit this->countChanged();
 }
@@ -82,6 +82,8 @@ protected:
 
 protected Q_SLOTS:
     void onVoiceCallsChanged();
+    void onVoiceCallAdded(const QString &handlerId);
+    void onVoiceCallRemoved(const QString &handlerId);
     void propertyChanged();
 
 private:
@@ -1,3 +1,4 @@
+#include "common.h"
 #include "voicecallplugin.h"
 
 #include "voicecallhandler.h"
@@ -27,5 +28,11 @@ void VoiceCallPlugin::registerTypes(const char *uri)
     qmlRegisterSingletonType<VoiceCallAudioRecorder>(uri, 1, 0, "VoiceCallAudioRecorder", voice_call_audio_recorder_api_factory);
 
     qmlRegisterType<VoiceCallManager>(uri, 1, 0, "VoiceCallManager");
+
+#ifdef WANT_TRACE
+    // The plugin keeps its own trace buffers, dump them when the application exits.
+    if (QCoreApplication::instance())
+        QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, voicecallTraceDump);
+#endif
 }
 
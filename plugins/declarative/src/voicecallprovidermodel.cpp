@@ -147,7 +147,7 @@ void VoiceCallProviderModel::onProvidersChanged()
     this->beginResetModel();
 
     d->providers.clear();
-    foreach(QString provider, d->manager->interface()->property("providers").toStringList())
+    foreach(QString provider, d->manager->providerIds())
     {
         QStringList parts = provider.split(':');
         d->providers.insert(parts.first(), VoiceCallProviderData(parts.first(),
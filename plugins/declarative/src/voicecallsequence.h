@@ -0,0 +1,62 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef VOICECALLSEQUENCE_H
+#define VOICECALLSEQUENCE_H
+
+#include <QtGlobal>
+
+/*
+  Checks the sequence numbers of the manager's CallAdded and CallRemoved
+  signals against the generation of the last call snapshot. The upper 32
+  bits of a number identify the daemon instance, the lower ones count the
+  changes made by it. A generation of 0 means there is no valid snapshot.
+*/
+class VoiceCallSequence
+{
+public:
+    enum Action {
+        Apply,      // the next change, apply it
+        Ignore,     // already part of the snapshot
+        Resync      // changes were missed, or come from another daemon
+    };
+
+    VoiceCallSequence() : m_generation(0) {/*...*/}
+
+    qulonglong generation() const { return m_generation; }
+    void reset(qulonglong generation = 0) { m_generation = generation; }
+
+    static quint32 instanceOf(qulonglong sequence) { return quint32(sequence >> 32); }
+
+    Action check(qulonglong sequence)
+    {
+        if (!m_generation || instanceOf(sequence) != instanceOf(m_generation)) return Resync;
+        if (sequence <= m_generation) return Ignore;
+        if (sequence != m_generation + 1) return Resync;
+
+        m_generation = sequence;
+        return Apply;
+    }
+
+private:
+    qulonglong m_generation;
+};
+
+#endif // VOICECALLSEQUENCE_H
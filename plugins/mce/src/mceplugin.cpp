@@ -46,8 +46,6 @@ public:
     McePlugin *q_ptr;
 
     VoiceCallManagerInterface *manager;
-
-    QHash<QString, AbstractVoiceCallHandler*> calls;
 };
 
 McePlugin::McePlugin(QObject *parent)
@@ -89,7 +87,7 @@ bool McePlugin::start()
     TRACE
     Q_D(const McePlugin);
 
-    QObject::connect(d->manager, SIGNAL(voiceCallsChanged()), SLOT(onVoiceCallsChanged()));
+    QObject::connect(d->manager, SIGNAL(changesCommitted(VoiceCallChangeSet)), SLOT(onChangesCommitted(VoiceCallChangeSet)));
     this->onVoiceCallsChanged();
 
     return true;
@@ -112,6 +110,19 @@ void McePlugin::finalize()
     TRACE
 }
 
+void McePlugin::onChangesCommitted(const VoiceCallChangeSet &changes)
+{
+    TRACE
+    if(changes.addedCalls().isEmpty() && changes.removedCalls().isEmpty()
+            && !(changes.changedCallProperties() & (VoiceCallChangeSet::StatusProperty
+                                                   | VoiceCallChangeSet::EmergencyProperty)))
+    {
+        return;
+    }
+
+    this->onVoiceCallsChanged();
+}
+
 void McePlugin::onVoiceCallsChanged()
 {
     TRACE
@@ -122,64 +133,24 @@ void McePlugin::onVoiceCallsChanged()
 
     QDBusMessage message = QDBusMessage::createMethodCall(MCE_SERVICE, MCE_PATH, MCE_IFACE, "req_call_state_change");
 
-    if(d->manager->voiceCallCount() == 0)
+    foreach(AbstractVoiceCallHandler *call, d->manager->voiceCalls())
+    {
+        isEmergency |= call->isEmergency();
+    }
+
+    if(d->manager->voiceCallCount(AbstractVoiceCallHandler::STATUS_INCOMING) > 0)
     {
-        d->calls.clear();
+        DEBUG_T("RINGING");
+        state = "ringing";
     }
-    else
+    else if(d->manager->voiceCallCount(AbstractVoiceCallHandler::STATUS_DIALING) > 0
+            || d->manager->voiceCallCount(AbstractVoiceCallHandler::STATUS_ALERTING) > 0
+            || d->manager->voiceCallCount(AbstractVoiceCallHandler::STATUS_ACTIVE) > 0
+            || d->manager->voiceCallCount(AbstractVoiceCallHandler::STATUS_HELD) > 0
+            || d->manager->voiceCallCount(AbstractVoiceCallHandler::STATUS_WAITING) > 0)
     {
-        QStringList handlerIds;
-
-        // Go through call handlers and start processing status changes.
-        foreach(AbstractVoiceCallHandler *call, d->manager->voiceCalls())
-        {
-            handlerIds.append(call->handlerId());
-
-            if(!d->calls.contains(call->handlerId()))
-            {
-                DEBUG_T("Registering call handler from internal dictionary.");
-
-                QObject::connect(call, SIGNAL(statusChanged(VoiceCallStatus)), SLOT(onVoiceCallsChanged()));
-                d->calls.insert(call->handlerId(), call);
-            }
-
-            isEmergency |= call->isEmergency();
-
-            switch(call->status())
-            {
-            case AbstractVoiceCallHandler::STATUS_NULL:
-            case AbstractVoiceCallHandler::STATUS_DISCONNECTED:
-                continue;
-
-            case AbstractVoiceCallHandler::STATUS_INCOMING:
-                DEBUG_T("RINGING");
-                state = "ringing";
-                continue;
-
-            case AbstractVoiceCallHandler::STATUS_DIALING:
-            case AbstractVoiceCallHandler::STATUS_ALERTING:
-            case AbstractVoiceCallHandler::STATUS_ACTIVE:
-            case AbstractVoiceCallHandler::STATUS_HELD:
-            case AbstractVoiceCallHandler::STATUS_WAITING:
-                DEBUG_T("ACTIVE");
-                if(state != "ringing") state = "active";
-                continue;
-            }
-        }
-
-        // Check for, and remove, removed calls from our call dictionary.
-        foreach(QString callId, d->calls.keys())
-        {
-            if(handlerIds.contains(callId)) continue;
-
-            AbstractVoiceCallHandler *call = d->calls.value(callId);
-
-            DEBUG_T("Deregistering call handler from internal dictionary.");
-
-            QObject::disconnect(call, SIGNAL(statusChanged(VoiceCallStatus)), this, SLOT(onVoiceCallsChanged()));
-
-            d->calls.remove(callId);
-        }
+        DEBUG_T("ACTIVE");
+        state = "active";
     }
 
     DEBUG_T("STATE: %s", qPrintable(state));
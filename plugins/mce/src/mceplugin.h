@@ -26,11 +26,12 @@
 
 #include <abstractvoicecallmanagerplugin.h>
 #include <abstractvoicecallhandler.h>
+#include <voicecallchangeset.h>
 
 class McePlugin : public AbstractVoiceCallManagerPlugin {
     Q_OBJECT
 
-    Q_PLUGIN_METADATA(IID "org.nemomobile.voicecall.mce")
+    Q_PLUGIN_METADATA(IID "org.nemomobile.voicecall.mce" FILE "mceplugin.json")
     Q_INTERFACES(AbstractVoiceCallManagerPlugin)
 
 public:
@@ -48,6 +49,7 @@ public Q_SLOTS:
     void finalize();
 
 protected Q_SLOTS:
+    void onChangesCommitted(const VoiceCallChangeSet &changes);
     void onVoiceCallsChanged();
 
 private:
@@ -11,4 +11,4 @@ HEADERS += \
 SOURCES += \
     mceplugin.cpp
 
-
+OTHER_FILES += mceplugin.json
@@ -33,7 +33,8 @@ class NgfRingtonePluginPrivate
 
 public:
     NgfRingtonePluginPrivate(NgfRingtonePlugin *q)
-        : q_ptr(q), manager(NULL), currentCall(NULL), activeCallCount(0), ngf(NULL), ringtoneEventId(0)
+        : q_ptr(q), manager(NULL), currentCall(NULL), activeCallCount(0), ngf(NULL), ringtoneEventId(0),
+          ringtonePending(false)
     { /* ... */ }
 
     NgfRingtonePlugin *q_ptr;
@@ -44,6 +45,38 @@ public:
 
     Ngf::Client *ngf;
     quint32 ringtoneEventId;
+
+    // A ringtone requested while the client was still connecting.
+    bool ringtonePending;
+    QMap<QString, QVariant> pendingRingtoneProps;
+
+    void playRingtone(const QMap<QString, QVariant> &props)
+    {
+        // resume() only starts connecting, play once the client is connected.
+        if (!ngf->isConnected())
+        {
+            DEBUG_T("Ringtone requested before NGF connected, queuing it");
+            ringtonePending = true;
+            pendingRingtoneProps = props;
+            return;
+        }
+
+        ringtoneEventId = ngf->play("ringtone", props);
+        DEBUG_T("Playing ringtone, event id: %u", ringtoneEventId);
+    }
+
+    void stopRingtone()
+    {
+        ringtonePending = false;
+        pendingRingtoneProps.clear();
+
+        if (ringtoneEventId)
+        {
+            DEBUG_T("Stopping ringtone");
+            ngf->stop("ringtone");
+            ringtoneEventId = 0;
+        }
+    }
 };
 
 NgfRingtonePlugin::NgfRingtonePlugin(QObject *parent)
@@ -102,13 +135,21 @@ bool NgfRingtonePlugin::start()
 bool NgfRingtonePlugin::suspend()
 {
     TRACE
+    Q_D(NgfRingtonePlugin);
+    if (d->activeCallCount > 0) return false;
+
+    // No ringtone can be needed before the manager resumes us.
+    d->ngf->disconnect();
     return true;
 }
 
 bool NgfRingtonePlugin::resume()
 {
     TRACE
-    return true;
+    Q_D(NgfRingtonePlugin);
+    if (d->ngf->isConnected()) return true;
+
+    return d->ngf->connect();
 }
 
 void NgfRingtonePlugin::finalize()
@@ -148,13 +189,7 @@ void NgfRingtonePlugin::onVoiceCallStatusChanged(AbstractVoiceCallHandler *handl
     {
         if (d->currentCall == handler) {
             d->currentCall = NULL;
-
-            if (d->ringtoneEventId)
-            {
-                DEBUG_T("Stopping ringtone");
-                d->ngf->stop("ringtone");
-                d->ringtoneEventId = 0;
-            }
+            d->stopRingtone();
         }
     } else if (!d->ringtoneEventId && !d->currentCall) {
         d->currentCall = handler;
@@ -170,8 +205,7 @@ void NgfRingtonePlugin::onVoiceCallStatusChanged(AbstractVoiceCallHandler *handl
             props.insert("type", "voip");
         }
 
-        d->ringtoneEventId = d->ngf->play("ringtone", props);
-        DEBUG_T("Playing ringtone, event id: %u", d->ringtoneEventId);
+        d->playRingtone(props);
     }
 }
 
@@ -183,13 +217,7 @@ void NgfRingtonePlugin::onVoiceCallDestroyed()
     if (d->currentCall == sender())
     {
         d->currentCall = NULL;
-
-        if (d->ringtoneEventId)
-        {
-            DEBUG_T("Stopping ringtone");
-            d->ngf->stop("ringtone");
-            d->ringtoneEventId = 0;
-        }
+        d->stopRingtone();
     }
 
     --d->activeCallCount;
@@ -200,6 +228,7 @@ void NgfRingtonePlugin::onSilenceRingtoneRequested()
 {
     TRACE
     Q_D(NgfRingtonePlugin);
+    d->ringtonePending = false;
     if (d->ringtoneEventId)
     {
         DEBUG_T("Pausing ringtone due to silence");
@@ -209,9 +238,16 @@ void NgfRingtonePlugin::onSilenceRingtoneRequested()
 
 void NgfRingtonePlugin::onConnectionStatus(bool connected)
 {
-    Q_UNUSED(connected)
     TRACE
+    Q_D(NgfRingtonePlugin);
     DEBUG_T("Connection to NGF daemon changed to: %s", connected ? "connected" : "disconnected");
+
+    if (connected && d->ringtonePending && d->currentCall)
+    {
+        d->ringtonePending = false;
+        d->playRingtone(d->pendingRingtoneProps);
+        d->pendingRingtoneProps.clear();
+    }
 }
 
 void NgfRingtonePlugin::onEventFailed(quint32 eventId)
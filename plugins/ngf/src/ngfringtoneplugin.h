@@ -28,7 +28,7 @@ class NgfRingtonePlugin : public AbstractVoiceCallManagerPlugin
 {
     Q_OBJECT
 
-    Q_PLUGIN_METADATA(IID "org.nemomobile.voicecall.ngf")
+    Q_PLUGIN_METADATA(IID "org.nemomobile.voicecall.ngf" FILE "ngfringtoneplugin.json")
     Q_INTERFACES(AbstractVoiceCallManagerPlugin)
 
 public:
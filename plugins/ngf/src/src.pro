@@ -11,3 +11,4 @@ HEADERS += \
 SOURCES += \
     ngfringtoneplugin.cpp
 
+OTHER_FILES += ngfringtoneplugin.json
@@ -76,7 +76,7 @@ bool PlaybackManagerPlugin::configure(VoiceCallManagerInterface *manager)
     Q_D(PlaybackManagerPlugin);
     d->manager = manager;
 
-    QObject::connect(d->manager, SIGNAL(voiceCallsChanged()), SLOT(onVoiceCallsChanged()));
+    QObject::connect(d->manager, SIGNAL(changesCommitted(VoiceCallChangeSet)), SLOT(onChangesCommitted(VoiceCallChangeSet)));
 
     QObject::connect(d->manager, SIGNAL(setAudioModeRequested(QString)), SLOT(setMode(QString)));
     QObject::connect(d->manager, SIGNAL(setMuteMicrophoneRequested(bool)), SLOT(setMuteMicrophone(bool)));
@@ -176,12 +176,18 @@ void PlaybackManagerPlugin::setMuteSpeaker(bool on)
     d->manager->onMuteSpeakerChanged(on);
 }
 
+void PlaybackManagerPlugin::onChangesCommitted(const VoiceCallChangeSet &changes)
+{
+    TRACE
+    if(!changes.removedCalls().isEmpty()) this->onVoiceCallsChanged();
+}
+
 void PlaybackManagerPlugin::onVoiceCallsChanged()
 {
     TRACE
     Q_D(PlaybackManagerPlugin);
 
-    if(d->manager->voiceCalls().empty())
+    if(d->manager->voiceCallCount() == 0)
     {
         d->manager->onAudioModeChanged("earpiece");
         d->manager->onMuteMicrophoneChanged(false);
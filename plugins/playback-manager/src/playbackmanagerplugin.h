@@ -23,12 +23,13 @@
 
 #include <abstractvoicecallmanagerplugin.h>
 #include <abstractvoicecallhandler.h>
+#include <voicecallchangeset.h>
 
 class PlaybackManagerPlugin : public AbstractVoiceCallManagerPlugin
 {
     Q_OBJECT
 
-    Q_PLUGIN_METADATA(IID "org.nemomobile.voicecall.playbackmanager")
+    Q_PLUGIN_METADATA(IID "org.nemomobile.voicecall.playbackmanager" FILE "playbackmanagerplugin.json")
     Q_INTERFACES(AbstractVoiceCallManagerPlugin)
 
 public:
@@ -51,6 +52,7 @@ public Q_SLOTS:
     void setMuteSpeaker(bool on = true);
 
 protected Q_SLOTS:
+    void onChangesCommitted(const VoiceCallChangeSet &changes);
     void onVoiceCallsChanged();
 
 private:
@@ -12,6 +12,11 @@ INCLUDEPATH += $$PWD/../lib/src
     LIBS += -L$$PWD/../lib/src -lvoicecall
 }
 
+# Same switch as the library and the daemon, so one build traces everything.
+enable-debug {
+    DEFINES += WANT_TRACE
+}
+
 # used as e.g. the declarative plugin is a QML plugin, not a voicecall plugin
 !no_plugininstall {
     target.path = $$[QT_INSTALL_LIBS]/voicecall/plugins
@@ -22,51 +22,114 @@
 #include "ofonovoicecallhandler.h"
 #include "ofonovoicecallprovider.h"
 
+#include <voicecalldurationtracker.h>
+#include <voicecallpendingoperation.h>
+#include <voicecallstatemachine.h>
+
 #include <qofonovoicecall.h>
 #include <qofonovoicecallmanager.h>
 
-#include <QElapsedTimer>
-#include <QTimerEvent>
+#include <QPointer>
+
+typedef QList<QPointer<VoiceCallPendingOperation> > PendingOperations;
 
 class OfonoVoiceCallHandlerPrivate
 {
     Q_DECLARE_PUBLIC(OfonoVoiceCallHandler)
 
 public:
-    OfonoVoiceCallHandlerPrivate(OfonoVoiceCallHandler *q, const QString &pHandlerId, OfonoVoiceCallProvider *pProvider, QOfonoVoiceCallManager *manager)
-        : q_ptr(q), handlerId(pHandlerId), provider(pProvider), ofonoVoiceCallManager(manager), ofonoVoiceCall(NULL)
-        , duration(0), durationTimerId(-1), isIncoming(false)
+    OfonoVoiceCallHandlerPrivate(OfonoVoiceCallHandler *q, const VoiceCallHandle &pHandle, OfonoVoiceCallProvider *pProvider, QOfonoVoiceCallManager *manager)
+        : q_ptr(q), handle(pHandle), provider(pProvider), ofonoVoiceCallManager(manager), ofonoVoiceCall(NULL)
+        , isIncoming(false), ready(false)
     { /* ... */ }
 
     OfonoVoiceCallHandler *q_ptr;
 
-    QString handlerId;
+    VoiceCallHandle handle;
 
     OfonoVoiceCallProvider *provider;
 
     QOfonoVoiceCallManager *ofonoVoiceCallManager;
     QOfonoVoiceCall *ofonoVoiceCall;
 
-    quint64 duration;
-    int durationTimerId;
-    QElapsedTimer elapsedTimer;
+    VoiceCallStateMachine stateMachine;
+
+    QMetaObject::Connection durationTick;
     bool isIncoming;
+
+    // Set once the properties are known, from seed() or from QOfonoVoiceCall.
+    bool ready;
+
+    // Properties oFono sent with CallAdded, used until QOfonoVoiceCall has its own.
+    QVariantMap seed;
+
+    bool isSeeded() const
+    {
+        return !seed.isEmpty() && !ofonoVoiceCall->isValid();
+    }
+
+    // Requests waiting for their reply from oFono, oldest first.
+    PendingOperations pendingAnswers;
+    PendingOperations pendingHangups;
+    PendingOperations pendingHoldAndAnswers;
+    PendingOperations pendingSwaps;
+
+    VoiceCallPendingOperation* track(PendingOperations &queue)
+    {
+        VoiceCallPendingOperation *operation = new VoiceCallPendingOperation(q_ptr);
+        queue.append(operation);
+        return operation;
+    }
+
+    void finish(PendingOperations &queue, bool status, const QString &errorMessage)
+    {
+        while (!queue.isEmpty()) {
+            QPointer<VoiceCallPendingOperation> operation = queue.takeFirst();
+            if (!operation)
+                continue;
+
+            if (status)
+                operation->setFinished();
+            else
+                operation->setFinishedWithError(errorMessage);
+            return;
+        }
+    }
 };
 
-OfonoVoiceCallHandler::OfonoVoiceCallHandler(const QString &handlerId, const QString &path, OfonoVoiceCallProvider *provider, QOfonoVoiceCallManager *manager)
-    : AbstractVoiceCallHandler(provider), d_ptr(new OfonoVoiceCallHandlerPrivate(this, handlerId, provider, manager))
+OfonoVoiceCallHandler::OfonoVoiceCallHandler(const VoiceCallHandle &handle, const QString &path, OfonoVoiceCallProvider *provider, QOfonoVoiceCallManager *manager)
+    : AbstractVoiceCallHandler(provider), d_ptr(new OfonoVoiceCallHandlerPrivate(this, handle, provider, manager))
 {
     TRACE
     Q_D(OfonoVoiceCallHandler);
     d->ofonoVoiceCall = new QOfonoVoiceCall(this);
     d->ofonoVoiceCall->setVoiceCallPath(path);
 
+    d->stateMachine.setHook(VoiceCallStateMachine::HOOK_DURATION_START, [this, d](VoiceCallStatus, VoiceCallStatus) {
+        VoiceCallDurationTracker *tracker = VoiceCallDurationTracker::instance();
+        tracker->start(d->handle.value());
+        if (!d->durationTick) {
+            d->durationTick = QObject::connect(tracker, &VoiceCallDurationTracker::tick, this, [this]() {
+                emit durationChanged(duration());
+            });
+        }
+    });
+    d->stateMachine.setHook(VoiceCallStateMachine::HOOK_DURATION_STOP, [d](VoiceCallStatus, VoiceCallStatus) {
+        VoiceCallDurationTracker::instance()->stop(d->handle.value());
+        QObject::disconnect(d->durationTick);
+    });
+
     QObject::connect(d->ofonoVoiceCall, SIGNAL(lineIdentificationChanged(QString)), SIGNAL(lineIdChanged(QString)));
     QObject::connect(d->ofonoVoiceCall, SIGNAL(emergencyChanged(bool)), SIGNAL(emergencyChanged(bool)));
     QObject::connect(d->ofonoVoiceCall, SIGNAL(multipartyChanged(bool)), SIGNAL(multipartyChanged(bool)));
 
     QObject::connect(d->ofonoVoiceCall, SIGNAL(stateChanged(QString)), SLOT(onStatusChanged()));
 
+    QObject::connect(d->ofonoVoiceCall, SIGNAL(answerComplete(bool)), SLOT(onAnswerComplete(bool)));
+    QObject::connect(d->ofonoVoiceCall, SIGNAL(hangupComplete(bool)), SLOT(onHangupComplete(bool)));
+    QObject::connect(d->ofonoVoiceCallManager, SIGNAL(holdAndAnswerComplete(bool)), SLOT(onHoldAndAnswerComplete(bool)));
+    QObject::connect(d->ofonoVoiceCallManager, SIGNAL(swapCallsComplete(bool)), SLOT(onSwapCallsComplete(bool)));
+
     QObject::connect(d->ofonoVoiceCall, SIGNAL(validChanged(bool)), SLOT(onValidChanged(bool)));
     if(d->ofonoVoiceCall->isValid()) {
         onValidChanged(true);
@@ -77,17 +140,56 @@ OfonoVoiceCallHandler::~OfonoVoiceCallHandler()
 {
     TRACE
     Q_D(const OfonoVoiceCallHandler);
+    VoiceCallDurationTracker::instance()->forget(d->handle.value());
     delete d;
 }
 
+/*
+ * Makes the handler valid right away from the \a properties oFono sent with
+ * CallAdded, instead of waiting for QOfonoVoiceCall to fetch them again.
+ * QOfonoVoiceCall takes over once it has, see onValidChanged().
+ */
+void OfonoVoiceCallHandler::seed(const QVariantMap &properties)
+{
+    TRACE
+    Q_D(OfonoVoiceCallHandler);
+    if (d->ready)
+        return;
+
+    d->seed = properties;
+    d->ready = true;
+    d->stateMachine.setStatus(VoiceCallStateMachine::statusFromText(properties.value("State").toString()));
+    d->isIncoming = d->stateMachine.status() == STATUS_INCOMING;
+
+    emit validChanged(true);
+}
+
 void OfonoVoiceCallHandler::onValidChanged(bool isValid)
 {
     Q_D(OfonoVoiceCallHandler);
 
-    if (isValid)
+    if (isValid && !d->ready)
     {
         // Properties are now ready
-        d->isIncoming = d->ofonoVoiceCall->state() == QLatin1String("incoming");
+        d->ready = true;
+        d->stateMachine.setStatus(VoiceCallStateMachine::statusFromText(d->ofonoVoiceCall->state()));
+        d->isIncoming = d->stateMachine.status() == STATUS_INCOMING;
+    }
+    else if (isValid && !d->seed.isEmpty())
+    {
+        // Catch up with whatever changed since CallAdded.
+        QVariantMap seed;
+        seed.swap(d->seed);
+
+        onStatusChanged();
+        if (seed.value("LineIdentification").toString() != lineId())
+            emit lineIdChanged(lineId());
+        if (seed.value("Emergency").toBool() != isEmergency())
+            emit emergencyChanged(isEmergency());
+        if (seed.value("Multiparty").toBool() != isMultiparty())
+            emit multipartyChanged(isMultiparty());
+        if (seed.value("StartTime").toString() != d->ofonoVoiceCall->startTime())
+            emit startedAtChanged(startedAt());
     }
 
     emit validChanged(isValid);
@@ -107,17 +209,26 @@ AbstractVoiceCallProvider* OfonoVoiceCallHandler::provider() const
     return d->provider;
 }
 
+const VoiceCallHandle& OfonoVoiceCallHandler::handle() const
+{
+    TRACE
+    Q_D(const OfonoVoiceCallHandler);
+    return d->handle;
+}
+
 QString OfonoVoiceCallHandler::handlerId() const
 {
     TRACE
     Q_D(const OfonoVoiceCallHandler);
-    return d->handlerId;
+    return d->handle.toString();
 }
 
 QString OfonoVoiceCallHandler::lineId() const
 {
     TRACE
     Q_D(const OfonoVoiceCallHandler);
+    if (d->isSeeded())
+        return d->seed.value("LineIdentification").toString();
     return d->ofonoVoiceCall->lineIdentification();
 }
 
@@ -125,15 +236,16 @@ QDateTime OfonoVoiceCallHandler::startedAt() const
 {
     TRACE
     Q_D(const OfonoVoiceCallHandler);
-    DEBUG_T("CALL START TIME: %s", qPrintable(d->ofonoVoiceCall->startTime()));
-    return QDateTime::fromString(d->ofonoVoiceCall->startTime(), "");
+    QString startTime = d->isSeeded() ? d->seed.value("StartTime").toString() : d->ofonoVoiceCall->startTime();
+    DEBUG_T("CALL START TIME: %s", qPrintable(startTime));
+    return QDateTime::fromString(startTime, "");
 }
 
 int OfonoVoiceCallHandler::duration() const
 {
     TRACE
     Q_D(const OfonoVoiceCallHandler);
-    return int(qRound(d->duration/1000.0));
+    return VoiceCallDurationTracker::instance()->seconds(d->handle.value());
 }
 
 bool OfonoVoiceCallHandler::isIncoming() const
@@ -147,6 +259,8 @@ bool OfonoVoiceCallHandler::isMultiparty() const
 {
     TRACE
     Q_D(const OfonoVoiceCallHandler);
+    if (d->isSeeded())
+        return d->seed.value("Multiparty").toBool();
     return d->ofonoVoiceCall->multiparty();
 }
 
@@ -154,6 +268,8 @@ bool OfonoVoiceCallHandler::isEmergency() const
 {
     TRACE
     Q_D(const OfonoVoiceCallHandler);
+    if (d->isSeeded())
+        return d->seed.value("Emergency").toBool();
     return d->ofonoVoiceCall->emergency();
 }
 
@@ -174,80 +290,105 @@ AbstractVoiceCallHandler::VoiceCallStatus OfonoVoiceCallHandler::status() const
 {
     TRACE
     Q_D(const OfonoVoiceCallHandler);
-    QString state = d->ofonoVoiceCall->state();
-
-    if(state == "active")
-        return STATUS_ACTIVE;
-    else if(state == "held")
-        return STATUS_HELD;
-    else if(state == "dialing")
-        return STATUS_DIALING;
-    else if(state == "alerting")
-        return STATUS_ALERTING;
-    else if(state == "incoming")
-        return STATUS_INCOMING;
-    else if(state == "waiting")
-        return STATUS_WAITING;
-    else if(state == "disconnected")
-        return STATUS_DISCONNECTED;
-
-    return STATUS_NULL;
+    return d->stateMachine.status();
 }
 
 void OfonoVoiceCallHandler::answer()
+{
+    TRACE
+    requestAnswer();
+}
+
+void OfonoVoiceCallHandler::hangup()
+{
+    TRACE
+    requestHangup();
+}
+
+void OfonoVoiceCallHandler::hold(bool on)
+{
+    TRACE
+    requestHold(on);
+}
+
+VoiceCallPendingOperation* OfonoVoiceCallHandler::requestAnswer()
 {
     TRACE
     Q_D(OfonoVoiceCallHandler);
-    if (status() == STATUS_WAITING)
+    if (status() == STATUS_WAITING) {
+        VoiceCallPendingOperation *operation = d->track(d->pendingHoldAndAnswers);
         d->ofonoVoiceCallManager->holdAndAnswer();
-    else
-        d->ofonoVoiceCall->answer();
+        return operation;
+    }
+
+    VoiceCallPendingOperation *operation = d->track(d->pendingAnswers);
+    d->ofonoVoiceCall->answer();
+    return operation;
 }
 
-void OfonoVoiceCallHandler::hangup()
+VoiceCallPendingOperation* OfonoVoiceCallHandler::requestHangup()
 {
     TRACE
     Q_D(OfonoVoiceCallHandler);
+    VoiceCallPendingOperation *operation = d->track(d->pendingHangups);
     d->ofonoVoiceCall->hangup();
+    return operation;
 }
 
-void OfonoVoiceCallHandler::hold(bool on)
+VoiceCallPendingOperation* OfonoVoiceCallHandler::requestHold(bool on)
 {
-    Q_UNUSED(on)
     TRACE
     Q_D(OfonoVoiceCallHandler);
     bool isHeld = status() == STATUS_HELD;
     if (isHeld == on)
-        return;
+        return VoiceCallPendingOperation::completed(true, QString(), this);
 
+    VoiceCallPendingOperation *operation = d->track(d->pendingSwaps);
     d->ofonoVoiceCallManager->swapCalls();
+    return operation;
 }
 
-void OfonoVoiceCallHandler::deflect(const QString &target)
+void OfonoVoiceCallHandler::onAnswerComplete(bool status)
 {
     TRACE
     Q_D(OfonoVoiceCallHandler);
-    d->ofonoVoiceCall->deflect(target);
+    d->finish(d->pendingAnswers, status, d->ofonoVoiceCall->errorMessage());
 }
 
-void OfonoVoiceCallHandler::sendDtmf(const QString &tones)
+void OfonoVoiceCallHandler::onHangupComplete(bool status)
 {
     TRACE
     Q_D(OfonoVoiceCallHandler);
-    d->ofonoVoiceCallManager->sendTones(tones);
+    d->finish(d->pendingHangups, status, d->ofonoVoiceCall->errorMessage());
 }
 
-void OfonoVoiceCallHandler::timerEvent(QTimerEvent *event)
+// The manager replies to every handler; only the one that asked has a request queued.
+void OfonoVoiceCallHandler::onHoldAndAnswerComplete(bool status)
 {
     TRACE
     Q_D(OfonoVoiceCallHandler);
+    d->finish(d->pendingHoldAndAnswers, status, d->ofonoVoiceCallManager->errorMessage());
+}
 
-    // Whilst call is active, increase duration by a second each second.
-    if(isOngoing() && event->timerId() == d->durationTimerId)
-    {
-        d->duration += d->elapsedTimer.restart();
-        emit this->durationChanged(d->duration);
-    }
+void OfonoVoiceCallHandler::onSwapCallsComplete(bool status)
+{
+    TRACE
+    Q_D(OfonoVoiceCallHandler);
+    d->finish(d->pendingSwaps, status, d->ofonoVoiceCallManager->errorMessage());
+}
+
+void OfonoVoiceCallHandler::deflect(const QString &target)
+{
+    TRACE
+    Q_D(OfonoVoiceCallHandler);
+    d->ofonoVoiceCall->deflect(target);
+}
+
+void OfonoVoiceCallHandler::sendDtmf(const QString &tones)
+{
+    TRACE
+    Q_D(OfonoVoiceCallHandler);
+    d->ofonoVoiceCallManager->sendTones(tones);
 }
 
 void OfonoVoiceCallHandler::onStatusChanged()
@@ -255,18 +396,11 @@ void OfonoVoiceCallHandler::onStatusChanged()
     TRACE
     Q_D(OfonoVoiceCallHandler);
 
-    if (isOngoing())
-    {
-        if (d->durationTimerId == -1) {
-            d->durationTimerId = this->startTimer(1000);
-            d->elapsedTimer.start();
-        }
-    }
-    else if (d->durationTimerId != -1)
-    {
-        this->killTimer(d->durationTimerId);
-        d->durationTimerId = -1;
-    }
+    // A seeded call may see state changes before QOfonoVoiceCall knows the state.
+    if (d->ofonoVoiceCall->state().isEmpty())
+        return;
 
-    emit statusChanged(status());
+    // Map the oFono state once here, status() then reads the cached value.
+    if (d->stateMachine.setStatus(VoiceCallStateMachine::statusFromText(d->ofonoVoiceCall->state())))
+        emit statusChanged(status());
 }
@@ -23,6 +23,8 @@
 
 #include <abstractvoicecallhandler.h>
 
+#include <QVariantMap>
+
 class OfonoVoiceCallProvider;
 class QOfonoVoiceCallManager;
 
@@ -33,13 +35,14 @@ class OfonoVoiceCallHandler : public AbstractVoiceCallHandler
     Q_PROPERTY(QString path READ path)
 
 public:
-    explicit OfonoVoiceCallHandler(const QString &handlerId, const QString &path, OfonoVoiceCallProvider *provider, QOfonoVoiceCallManager *manager);
+    explicit OfonoVoiceCallHandler(const VoiceCallHandle &handle, const QString &path, OfonoVoiceCallProvider *provider, QOfonoVoiceCallManager *manager);
             ~OfonoVoiceCallHandler();
 
     QString path() const;
 
     AbstractVoiceCallProvider* provider() const;
 
+    const VoiceCallHandle& handle() const;
     QString handlerId() const;
     QString lineId() const;
     QDateTime startedAt() const;
@@ -56,6 +59,12 @@ public:
 
     VoiceCallStatus status() const;
 
+    void seed(const QVariantMap &properties);
+
+    VoiceCallPendingOperation* requestAnswer();
+    VoiceCallPendingOperation* requestHangup();
+    VoiceCallPendingOperation* requestHold(bool on);
+
 Q_SIGNALS:
     void validChanged(bool valid);
 
@@ -74,8 +83,10 @@ protected Q_SLOTS:
     void onStatusChanged();
     void onValidChanged(bool);
 
-protected:
-    void timerEvent(QTimerEvent *event);
+    void onAnswerComplete(bool status);
+    void onHangupComplete(bool status);
+    void onHoldAndAnswerComplete(bool status);
+    void onSwapCallsComplete(bool status);
 
 private:
     class OfonoVoiceCallHandlerPrivate *d_ptr;
@@ -22,16 +22,33 @@
 #include "ofonovoicecallhandler.h"
 #include "ofonovoicecallprovider.h"
 
+#include <voicecallstats.h>
+
 #include <qofonomodem.h>
 #include <qofonovoicecallmanager.h>
 
+#include <QPointer>
+#include <QTimer>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+
+namespace {
+
+// How long oFono may take to answer Dial, and the call to start alerting.
+const int DIAL_REPLY_TIMEOUT = 30000;
+const int DIAL_SETUP_TIMEOUT = 60000;
+
+}
+
 class OfonoVoiceCallProviderPrivate
 {
     Q_DECLARE_PUBLIC(OfonoVoiceCallProvider)
 
 public:
     OfonoVoiceCallProviderPrivate(OfonoVoiceCallProvider *q, VoiceCallManagerInterface *pManager)
-        : q_ptr(q), manager(pManager), ofonoManager(NULL), ofonoModem(NULL)
+        : q_ptr(q), manager(pManager), ofonoManager(NULL), ofonoModem(NULL), lastDialId(0)
     { /* ... */ }
 
     OfonoVoiceCallProvider *q_ptr;
@@ -45,6 +62,24 @@ public:
     QHash<QString,OfonoVoiceCallHandler*> voiceCalls;
     QHash<QString,OfonoVoiceCallHandler*> invalidVoiceCalls;
 
+    // A dial request, followed from the request until the call is alerting.
+    struct PendingDial
+    {
+        PendingDial() : requestedAt(0), dialingAt(0) {}
+
+        QPointer<VoiceCallPendingOperation> operation;
+        QString path;
+        qint64 requestedAt;
+        qint64 dialingAt;
+    };
+
+    QHash<quint64,PendingDial> pendingDials;
+    QHash<QString,quint64> dialsByPath;
+    quint64 lastDialId;
+
+    // Calls added while a Dial reply was outstanding, and when they were added.
+    QHash<QString,qint64> unclaimedCalls;
+
     QString errorString;
     void setError(const QString &errorString)
     {
@@ -52,12 +87,143 @@ public:
         debugMessage(errorString);
     }
 
+    void record(const QString &series, qint64 usecs)
+    {
+        Q_Q(OfonoVoiceCallProvider);
+        VoiceCallStats::instance()->record(q->providerId(), series, usecs);
+    }
+
+    void finishDial(quint64 id, bool ok, const QString &errorMessage)
+    {
+        QHash<quint64,PendingDial>::iterator dial = pendingDials.find(id);
+        if(dial == pendingDials.end()) return;
+
+        VoiceCallPendingOperation *operation = dial->operation;
+        if(operation && !operation->isFinished())
+        {
+            if(ok) operation->setFinished();
+            else operation->setFinishedWithError(errorMessage);
+        }
+
+        if(!ok) dropDial(id);
+    }
+
+    void dropDial(quint64 id)
+    {
+        PendingDial dial = pendingDials.take(id);
+        if(!dial.path.isEmpty()) dialsByPath.remove(dial.path);
+
+        // Nothing can claim the remaining calls without a Dial in flight.
+        bool awaitingReply = false;
+        foreach(const PendingDial &other, pendingDials)
+        {
+            if(other.path.isEmpty()) awaitingReply = true;
+        }
+        if(!awaitingReply) unclaimedCalls.clear();
+    }
+
+    OfonoVoiceCallHandler* handlerFor(const QString &path) const
+    {
+        OfonoVoiceCallHandler *handler = voiceCalls.value(path);
+        return handler ? handler : invalidVoiceCalls.value(path);
+    }
+
+    void onDialReply(quint64 id, QDBusPendingCallWatcher *watcher);
+    void claimCall(quint64 id, OfonoVoiceCallHandler *handler, qint64 addedAt);
+    void updateDialStage(OfonoVoiceCallHandler *handler);
+
+    // QOfonoVoiceCallManager only passes on the path of a new call, the
+    // properties that come with it are taken from the signal directly.
+    bool watchCallAdded(bool on)
+    {
+        Q_Q(OfonoVoiceCallProvider);
+        QDBusConnection bus = QDBusConnection::systemBus();
+        if (on)
+            return bus.connect("org.ofono", modemPath, "org.ofono.VoiceCallManager", "CallAdded",
+                               q, SLOT(onCallAddedWithProperties(QDBusObjectPath,QVariantMap)));
+        return bus.disconnect("org.ofono", modemPath, "org.ofono.VoiceCallManager", "CallAdded",
+                              q, SLOT(onCallAddedWithProperties(QDBusObjectPath,QVariantMap)));
+    }
+
     void debugMessage(const QString &message)
     {
         DEBUG_T("OfonoVoiceCallProvider(%s): %s", qPrintable(ofonoModem->modemPath()), qPrintable(message));
     }
 };
 
+void OfonoVoiceCallProviderPrivate::onDialReply(quint64 id, QDBusPendingCallWatcher *watcher)
+{
+    QDBusPendingReply<QDBusObjectPath> reply = *watcher;
+    watcher->deleteLater();
+
+    if(!pendingDials.contains(id)) return;
+    PendingDial &dial = pendingDials[id];
+    qint64 elapsed = voicecallMonotonicTimestamp() - dial.requestedAt;
+
+    if(reply.isError())
+    {
+        record(QLatin1String("dial-failed"), elapsed);
+        setError(reply.error().message());
+        finishDial(id, false, errorString);
+        return;
+    }
+
+    // The call is usually added before oFono replies, otherwise onCallAdded()
+    // claims it by its path.
+    record(QLatin1String("dial-reply"), elapsed);
+    QString path = reply.value().path();
+    dial.path = path;
+    dialsByPath.insert(path, id);
+    finishDial(id, true, QString());
+
+    OfonoVoiceCallHandler *handler = handlerFor(path);
+    if(handler) claimCall(id, handler, unclaimedCalls.value(path, voicecallMonotonicTimestamp()));
+    unclaimedCalls.remove(path);
+}
+
+/*
+ * oFono adds outgoing calls in the dialing state, so the time the call
+ * was added is when dialing started.
+ */
+void OfonoVoiceCallProviderPrivate::claimCall(quint64 id, OfonoVoiceCallHandler *handler, qint64 addedAt)
+{
+    Q_Q(OfonoVoiceCallProvider);
+    PendingDial &dial = pendingDials[id];
+    dial.dialingAt = addedAt;
+    record(QLatin1String("dial-dialing"), addedAt - dial.requestedAt);
+
+    QObject::connect(handler, SIGNAL(statusChanged(VoiceCallStatus)), q, SLOT(onDialedCallStatusChanged()), Qt::UniqueConnection);
+    updateDialStage(handler);
+}
+
+void OfonoVoiceCallProviderPrivate::updateDialStage(OfonoVoiceCallHandler *handler)
+{
+    Q_Q(OfonoVoiceCallProvider);
+    if(!dialsByPath.contains(handler->path())) return;
+    quint64 id = dialsByPath.value(handler->path());
+    const PendingDial &dial = pendingDials[id];
+
+    switch(handler->status())
+    {
+    case AbstractVoiceCallHandler::STATUS_NULL:
+    case AbstractVoiceCallHandler::STATUS_DIALING:
+        return;
+    case AbstractVoiceCallHandler::STATUS_ALERTING:
+    {
+        qint64 now = voicecallMonotonicTimestamp();
+        record(QLatin1String("dial-alerting"), now - dial.dialingAt);
+        record(QLatin1String("dial-alerting-total"), now - dial.requestedAt);
+        break;
+    }
+    default:
+        // Answered without alerting, or gone, either way there is nothing to time.
+        break;
+    }
+
+    QObject::disconnect(handler, SIGNAL(statusChanged(VoiceCallStatus)), q, SLOT(onDialedCallStatusChanged()));
+    dropDial(id);
+}
+
 OfonoVoiceCallProvider::OfonoVoiceCallProvider(const QString &path, VoiceCallManagerInterface *manager, QObject *parent)
     : AbstractVoiceCallProvider(parent), d_ptr(new OfonoVoiceCallProviderPrivate(this, manager))
 {
@@ -82,6 +248,9 @@ void OfonoVoiceCallProvider::initialize()
     QObject::connect(d->ofonoManager, SIGNAL(callAdded(QString)), SLOT(onCallAdded(QString)));
     QObject::connect(d->ofonoManager, SIGNAL(callRemoved(QString)), SLOT(onCallRemoved(QString)));
 
+    if (!d->watchCallAdded(true))
+        d->debugMessage("Failed to watch CallAdded, new calls wait for their properties");
+
     foreach (const QString &call, d->ofonoManager->getCalls())
         onCallAdded(call);
 }
@@ -128,17 +297,44 @@ QString OfonoVoiceCallProvider::errorString() const
 }
 
 bool OfonoVoiceCallProvider::dial(const QString &msisdn)
+{
+    TRACE
+    return !requestDial(msisdn)->isError();
+}
+
+VoiceCallPendingOperation* OfonoVoiceCallProvider::requestDial(const QString &msisdn)
 {
     TRACE
     Q_D(OfonoVoiceCallProvider);
     if(!d->ofonoManager || !d->ofonoManager->isValid())
     {
         d->setError("ofono connection is not valid");
-        return false;
+        return VoiceCallPendingOperation::completed(false, d->errorString, this);
     }
 
-    d->ofonoManager->dial(msisdn, "default");
-    return true;
+    quint64 id = ++d->lastDialId;
+    OfonoVoiceCallProviderPrivate::PendingDial &dial = d->pendingDials[id];
+    dial.operation = new VoiceCallPendingOperation(this);
+    dial.requestedAt = voicecallMonotonicTimestamp();
+
+    // Called directly rather than through QOfonoVoiceCallManager, which does
+    // not pass on the path of the new call.
+    QDBusMessage message = QDBusMessage::createMethodCall("org.ofono", d->modemPath, "org.ofono.VoiceCallManager", "Dial");
+    message << msisdn << QString("default");
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(message, DIAL_REPLY_TIMEOUT), this);
+    QObject::connect(watcher, &QDBusPendingCallWatcher::finished, this, [d, id](QDBusPendingCallWatcher *watcher) {
+        d->onDialReply(id, watcher);
+    });
+
+    // Stop following calls that never get as far as alerting.
+    QTimer::singleShot(DIAL_SETUP_TIMEOUT, this, [d, id]() {
+        if(!d->pendingDials.contains(id)) return;
+        d->debugMessage(QString("Dial request %1 timed out before alerting").arg(id));
+        d->finishDial(id, false, "Dial request timed out");
+    });
+
+    return dial.operation;
 }
 
 QOfonoModem* OfonoVoiceCallProvider::modem() const
@@ -148,16 +344,12 @@ QOfonoModem* OfonoVoiceCallProvider::modem() const
     return d->ofonoModem;
 }
 
-void OfonoVoiceCallProvider::onDialComplete(const bool status)
+void OfonoVoiceCallProvider::onDialedCallStatusChanged()
 {
     TRACE
     Q_D(OfonoVoiceCallProvider);
-    if (!d->ofonoManager) {
-        d->setError("ofono connection is not valid");
-        return;
-    }
-    if (!status)
-        d->setError(d->ofonoManager->errorMessage());
+    OfonoVoiceCallHandler *handler = qobject_cast<OfonoVoiceCallHandler*>(QObject::sender());
+    if (handler) d->updateDialStage(handler);
 }
 
 void OfonoVoiceCallProvider::interfacesChanged(const QStringList &interfaces)
@@ -168,8 +360,13 @@ void OfonoVoiceCallProvider::interfacesChanged(const QStringList &interfaces)
     if (!hasVoiceCallManager && d->ofonoManager) {
         foreach (QString handler, d->voiceCalls.keys())
             onCallRemoved(handler);
+        d->watchCallAdded(false);
         delete d->ofonoManager;
         d->ofonoManager = 0;
+
+        // Replies still in flight are not worth waiting for.
+        foreach (quint64 id, d->pendingDials.keys())
+            d->finishDial(id, false, "ofono voice call manager went away");
     } else if (hasVoiceCallManager && !d->ofonoManager) {
         initialize();
     }
@@ -181,10 +378,36 @@ void OfonoVoiceCallProvider::onCallAdded(const QString &call)
     Q_D(OfonoVoiceCallProvider);
     if(d->voiceCalls.contains(call)) return;
 
+    qint64 seenAt = voicecallMonotonicTimestamp();
+
     qDebug() << "Adding call handler " << call;
-    OfonoVoiceCallHandler *handler = new OfonoVoiceCallHandler(d->manager->generateHandlerId(), call, this, d->ofonoManager);
+    OfonoVoiceCallHandler *handler = new OfonoVoiceCallHandler(d->manager->generateHandle(), call, this, d->ofonoManager);
+    VoiceCallStats::instance()->markStage(handler, VoiceCallStats::STAGE_CALL_ADDED, seenAt);
     d->invalidVoiceCalls.insert(call, handler);
     QObject::connect(handler, SIGNAL(validChanged(bool)), SLOT(onVoiceCallHandlerValidChanged(bool)));
+
+    if (d->dialsByPath.contains(call))
+        d->claimCall(d->dialsByPath.value(call), handler, seenAt);
+    else if (!d->pendingDials.isEmpty())
+        d->unclaimedCalls.insert(call, seenAt);
+}
+
+/*
+ * Handles the same CallAdded signal as onCallAdded(), but with the call
+ * properties, so that the handler is ready without another round trip.
+ */
+void OfonoVoiceCallProvider::onCallAddedWithProperties(const QDBusObjectPath &call, const QVariantMap &properties)
+{
+    TRACE
+    Q_D(OfonoVoiceCallProvider);
+    if (d->voiceCalls.contains(call.path())) return;
+
+    // Whichever of the two sees the signal first creates the handler.
+    if (!d->invalidVoiceCalls.contains(call.path()))
+        onCallAdded(call.path());
+
+    OfonoVoiceCallHandler *handler = d->invalidVoiceCalls.value(call.path());
+    if (handler) handler->seed(properties);
 }
 
 void OfonoVoiceCallProvider::onVoiceCallHandlerValidChanged(bool isValid)
@@ -201,6 +424,8 @@ void OfonoVoiceCallProvider::onVoiceCallHandlerValidChanged(bool isValid)
         {
             d->voiceCalls.insert(call, handler);
             d->invalidVoiceCalls.remove(call);
+            VoiceCallStats::instance()->markStage(handler, VoiceCallStats::STAGE_HANDLER_READY);
+            d->updateDialStage(handler);
             emit this->voiceCallAdded(handler);
             emit this->voiceCallsChanged();
         }
@@ -211,8 +436,14 @@ void OfonoVoiceCallProvider::onCallRemoved(const QString &call)
 {
     TRACE
     Q_D(OfonoVoiceCallProvider);
+    d->unclaimedCalls.remove(call);
+    if (d->dialsByPath.contains(call))
+        d->dropDial(d->dialsByPath.value(call));
+
     if(!d->voiceCalls.contains(call)) {
-        delete d->invalidVoiceCalls.take(call);
+        OfonoVoiceCallHandler *handler = d->invalidVoiceCalls.take(call);
+        if (handler) VoiceCallStats::instance()->forgetCall(handler->handle().value());
+        delete handler;
         return;
     }
 
@@ -26,6 +26,8 @@
 
 #include <qofonomodem.h>
 
+#include <QDBusObjectPath>
+
 class OfonoVoiceCallProvider : public AbstractVoiceCallProvider
 {
     Q_OBJECT
@@ -43,15 +45,18 @@ public:
 
     QOfonoModem* modem() const;
 
+    VoiceCallPendingOperation* requestDial(const QString &msisdn);
+
 public Q_SLOTS:
     bool dial(const QString &msisdn);
 
 protected Q_SLOTS:
     void interfacesChanged(const QStringList &interfaces);
     void onCallAdded(const QString &call);
+    void onCallAddedWithProperties(const QDBusObjectPath &call, const QVariantMap &properties);
     void onCallRemoved(const QString &call);
 
-    void onDialComplete(const bool status);
+    void onDialedCallStatusChanged();
 
     void onVoiceCallHandlerValidChanged(bool isValid);
 
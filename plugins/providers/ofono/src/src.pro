@@ -4,10 +4,6 @@ QT += dbus
 
 PKGCONFIG += qofono-qt5
 
-enable-debug {
-    DEFINES += WANT_TRACE
-}
-
 HEADERS += \
     ofonovoicecallhandler.h  \
     ofonovoicecallprovider.h \
@@ -20,3 +16,4 @@ SOURCES += \
 
 DEFINES += PLUGIN_NAME=\\\"voicecall-ofono-plugin\\\"
 
+OTHER_FILES += ofonovoicecallproviderfactory.json
@@ -21,8 +21,40 @@
 
 #include "basechannelhandler.h"
 
+#include <voicecallpendingoperation.h>
+
+#include <QDBusPendingCallWatcher>
+
 BaseChannelHandler::BaseChannelHandler(QObject *parent)
     : AbstractVoiceCallHandler(parent)
 {
 
 }
+
+VoiceCallPendingOperation* BaseChannelHandler::track(Tp::PendingOperation *op, QObject *parent)
+{
+    VoiceCallPendingOperation *operation = new VoiceCallPendingOperation(parent);
+    QObject::connect(op, &Tp::PendingOperation::finished,
+                     operation, [operation](Tp::PendingOperation *op) {
+        if (op->isError())
+            operation->setFinishedWithError(QString("Telepathy Operation Failed: %1 - %2").arg(op->errorName(), op->errorMessage()));
+        else
+            operation->setFinished();
+    });
+    return operation;
+}
+
+VoiceCallPendingOperation* BaseChannelHandler::track(const QDBusPendingCall &call, QObject *parent)
+{
+    VoiceCallPendingOperation *operation = new VoiceCallPendingOperation(parent);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, operation);
+    QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
+                     operation, [operation](QDBusPendingCallWatcher *watcher) {
+        if (watcher->isError())
+            operation->setFinishedWithError(QString("Telepathy Operation Failed: %1 - %2").arg(watcher->error().name(), watcher->error().message()));
+        else
+            operation->setFinished();
+        watcher->deleteLater();
+    });
+    return operation;
+}
@@ -24,8 +24,12 @@
 #include <abstractvoicecallhandler.h>
 
 #include <TelepathyQt/Channel>
+#include <TelepathyQt/PendingOperation>
+
+#include <QDBusPendingCall>
 
 class TelepathyProvider;
+class VoiceCallPendingOperation;
 
 class BaseChannelHandler : public AbstractVoiceCallHandler
 {
@@ -39,6 +43,10 @@ public:
     virtual void addChildCall(BaseChannelHandler *handler) = 0;
     virtual void removeChildCall(BaseChannelHandler *handler) = 0;
 
+    // Wrap a Telepathy request into an operation that finishes along with it.
+    static VoiceCallPendingOperation* track(Tp::PendingOperation *op, QObject *parent);
+    static VoiceCallPendingOperation* track(const QDBusPendingCall &call, QObject *parent);
+
 Q_SIGNALS:
     /*** StreamedMediaChannelHandler Implementation ***/
     void error(const QString &errorMessage);
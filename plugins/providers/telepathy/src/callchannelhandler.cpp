@@ -32,70 +32,60 @@
 #include <TelepathyQt/CallContent>
 #include <TelepathyQt/Farstream/Channel>
 
-#include <QElapsedTimer>
-#include <qmath.h>
-
-static quint64 get_tick()
-{
-#if defined(CLOCK_BOOTTIME)
-   int id = CLOCK_BOOTTIME;
-#else
-   int id = CLOCK_MONOTONIC;
-#endif
-
-  quint64 res = 0;
+#include <voicecallstatemachine.h>
+#include <voicecalldurationtracker.h>
 
-  struct timespec ts;
-
-  if(clock_gettime(id, &ts) == 0) {
-    res = ts.tv_sec;
-    res *= 1000;
-    res += ts.tv_nsec / 1000000;
-  }
-
-  return res;
-}
+#include <qmath.h>
 
 class CallChannelHandlerPrivate
 {
     Q_DECLARE_PUBLIC(CallChannelHandler)
 
 public:
-    CallChannelHandlerPrivate(CallChannelHandler *q, const QString &id, Tp::CallChannelPtr c, const QDateTime &s, TelepathyProvider *p)
-        : q_ptr(q), handlerId(id), provider(p), startedAt(s), status(AbstractVoiceCallHandler::STATUS_NULL),
-          channel(c), fsChannel(NULL), duration(0), durationTimerId(-1), isEmergency(false),
+    CallChannelHandlerPrivate(CallChannelHandler *q, const VoiceCallHandle &h, Tp::CallChannelPtr c, const QDateTime &s, TelepathyProvider *p)
+        : q_ptr(q), handle(h), provider(p), startedAt(s),
+          channel(c), fsChannel(NULL), isEmergency(false),
           isForwarded(false), isIncoming(false), isRemoteHeld(false)
     { /* ... */ }
 
     CallChannelHandler  *q_ptr;
 
-    QString            handlerId;
+    VoiceCallHandle    handle;
     TelepathyProvider *provider;
 
     QDateTime          startedAt;
 
-    AbstractVoiceCallHandler::VoiceCallStatus status;
+    VoiceCallStateMachine stateMachine;
 
     Tp::CallChannelPtr channel; // CallChannel or StreamedMediaChannel
     FarstreamChannel *fsChannel;
 
-    quint64 duration;
-    quint64 connectedAt;
-    int durationTimerId;
-    QElapsedTimer elapsedTimer;
+    QMetaObject::Connection durationTick;
     bool isEmergency;
     bool isForwarded;
     bool isIncoming;
     bool isRemoteHeld;
 };
 
-CallChannelHandler::CallChannelHandler(const QString &id, Tp::CallChannelPtr channel, const QDateTime &userActionTime, TelepathyProvider *provider)
-    : BaseChannelHandler(provider), d_ptr(new CallChannelHandlerPrivate(this, id, channel, userActionTime, provider))
+CallChannelHandler::CallChannelHandler(const VoiceCallHandle &handle, Tp::CallChannelPtr channel, const QDateTime &userActionTime, TelepathyProvider *provider)
+    : BaseChannelHandler(provider), d_ptr(new CallChannelHandlerPrivate(this, handle, channel, userActionTime, provider))
 {
     TRACE
     Q_D(CallChannelHandler);
 
-    QObject::connect(this, SIGNAL(statusChanged(VoiceCallStatus)), SLOT(onStatusChanged()));
+    d->stateMachine.setHook(VoiceCallStateMachine::HOOK_DURATION_START, [this, d](VoiceCallStatus, VoiceCallStatus) {
+        VoiceCallDurationTracker *tracker = VoiceCallDurationTracker::instance();
+        tracker->start(d->handle.value());
+        if (!d->durationTick) {
+            d->durationTick = QObject::connect(tracker, &VoiceCallDurationTracker::tick, this, [this]() {
+                emit durationChanged(duration());
+            });
+        }
+    });
+    d->stateMachine.setHook(VoiceCallStateMachine::HOOK_DURATION_STOP, [d](VoiceCallStatus, VoiceCallStatus) {
+        VoiceCallDurationTracker::instance()->stop(d->handle.value());
+        QObject::disconnect(d->durationTick);
+    });
 
     QObject::connect(d->channel->becomeReady(),
                      SIGNAL(finished(Tp::PendingOperation*)),
@@ -111,6 +101,8 @@ CallChannelHandler::CallChannelHandler(const QString &id, Tp::CallChannelPtr cha
 CallChannelHandler::~CallChannelHandler()
 {
     TRACE
+    Q_D(CallChannelHandler);
+    VoiceCallDurationTracker::instance()->forget(d->handle.value());
     delete this->d_ptr;
 }
 
@@ -121,11 +113,18 @@ AbstractVoiceCallProvider* CallChannelHandler::provider() const
     return d->provider;
 }
 
+const VoiceCallHandle& CallChannelHandler::handle() const
+{
+    TRACE
+    Q_D(const CallChannelHandler);
+    return d->handle;
+}
+
 QString CallChannelHandler::handlerId() const
 {
     TRACE
     Q_D(const CallChannelHandler);
-    return d->handlerId;
+    return d->handle.toString();
 }
 
 QString CallChannelHandler::lineId() const
@@ -147,7 +146,7 @@ int CallChannelHandler::duration() const
 {
     TRACE
     Q_D(const CallChannelHandler);
-    return int(qRound(d->duration/1000.0));
+    return VoiceCallDurationTracker::instance()->seconds(d->handle.value());
 }
 
 bool CallChannelHandler::isIncoming() const
@@ -193,7 +192,7 @@ AbstractVoiceCallHandler::VoiceCallStatus CallChannelHandler::status() const
 {
     TRACE
     Q_D(const CallChannelHandler);
-    return d->status;
+    return d->stateMachine.status();
 }
 
 Tp::ChannelPtr CallChannelHandler::channel() const
@@ -203,33 +202,55 @@ Tp::ChannelPtr CallChannelHandler::channel() const
 }
 
 void CallChannelHandler::answer()
+{
+    TRACE
+    requestAnswer();
+}
+
+void CallChannelHandler::hangup()
+{
+    TRACE
+    requestHangup();
+}
+
+void CallChannelHandler::hold(bool on)
+{
+    TRACE
+    requestHold(on);
+}
+
+VoiceCallPendingOperation* CallChannelHandler::requestAnswer()
 {
     TRACE
     Q_D(CallChannelHandler);
 
-    QObject::connect(d->channel.data()->accept(),
+    Tp::PendingOperation *op = d->channel.data()->accept();
+    QObject::connect(op,
                      SIGNAL(finished(Tp::PendingOperation*)),
                      SLOT(onCallChannelAcceptCallFinished(Tp::PendingOperation*)));
 
     setStatus(STATUS_ACTIVE);
+    return track(op, this);
 }
 
-void CallChannelHandler::hangup()
+VoiceCallPendingOperation* CallChannelHandler::requestHangup()
 {
     TRACE
     Q_D(CallChannelHandler);
 
-    QObject::connect(d->channel.data()->hangup(),
+    Tp::PendingOperation *op = d->channel.data()->hangup();
+    QObject::connect(op,
                      SIGNAL(finished(Tp::PendingOperation*)),
                      SLOT(onCallChannelHangupCallFinished(Tp::PendingOperation*)));
+    return track(op, this);
 }
 
-void CallChannelHandler::hold(bool on)
+VoiceCallPendingOperation* CallChannelHandler::requestHold(bool on)
 {
     TRACE
     Q_D(CallChannelHandler);
     Tp::Client::ChannelInterfaceHoldInterface *holdIface = new Tp::Client::ChannelInterfaceHoldInterface(d->channel.data(), this);
-    holdIface->RequestHold(on);
+    return track(holdIface->RequestHold(on), this);
 }
 
 //FIXME: Don't know what telepathy API provides this.
@@ -472,45 +493,12 @@ void CallChannelHandler::onFarstreamCreateChannelFinished(Tp::PendingOperation *
     d->fsChannel->init();
 }
 
-void CallChannelHandler::timerEvent(QTimerEvent *event)
-{
-    TRACE
-    Q_D(CallChannelHandler);
-
-    if(isOngoing() && event->timerId() == d->durationTimerId)
-    {
-        d->duration = get_tick() - d->connectedAt;
-        emit this->durationChanged(duration());
-    }
-}
-
-void CallChannelHandler::onStatusChanged()
-{
-    TRACE
-    Q_D(CallChannelHandler);
-
-    if(isOngoing())
-    {
-        if (d->durationTimerId == -1) {
-            d->durationTimerId = this->startTimer(1000);
-            d->elapsedTimer.start();
-            d->connectedAt = get_tick();
-        }
-    }
-    else if (d->durationTimerId != -1)
-    {
-        this->killTimer(d->durationTimerId);
-        d->durationTimerId = -1;
-    }
-}
-
 void CallChannelHandler::setStatus(VoiceCallStatus newStatus)
 {
     TRACE
     Q_D(CallChannelHandler);
-    if (newStatus == d->status)
+    if (!d->stateMachine.setStatus(newStatus))
         return;
 
-    d->status = newStatus;
-    emit statusChanged(d->status);
+    emit statusChanged(newStatus);
 }
@@ -33,11 +33,12 @@ class CallChannelHandler : public BaseChannelHandler
     Q_OBJECT
 
 public:
-    explicit CallChannelHandler(const QString &id, Tp::CallChannelPtr channel, const QDateTime &userActionTime, TelepathyProvider *provider = 0);
+    explicit CallChannelHandler(const VoiceCallHandle &handle, Tp::CallChannelPtr channel, const QDateTime &userActionTime, TelepathyProvider *provider = 0);
             ~CallChannelHandler();
 
     /*** AbstractVoiceCallHandler Implementation ***/
     AbstractVoiceCallProvider* provider() const;
+    const VoiceCallHandle& handle() const;
     QString handlerId() const;
     QString lineId() const;
     QDateTime startedAt() const;
@@ -54,6 +55,10 @@ public:
 
     VoiceCallStatus status() const;
 
+    VoiceCallPendingOperation* requestAnswer();
+    VoiceCallPendingOperation* requestHangup();
+    VoiceCallPendingOperation* requestHold(bool on);
+
     /*** BaseChannelHandler Implementation ***/
     Tp::ChannelPtr channel() const override;
 
@@ -73,8 +78,6 @@ public Q_SLOTS:
     void split() {}
 
 protected Q_SLOTS:
-    void onStatusChanged();
-
     // CallChannel Interface Handling
     void onCallChannelChannelReady(Tp::PendingOperation *op);
     void onCallChannelChannelInvalidated(Tp::DBusProxy*,const QString &errorName, const QString &errorMessage);
@@ -91,8 +94,6 @@ protected Q_SLOTS:
     void onFarstreamCreateChannelFinished(Tp::PendingOperation *op);
 
 protected:
-    void timerEvent(QTimerEvent *event);
-
     // TODO: unimplemented
     void addChildCall(BaseChannelHandler */*handler*/) override {}
     void removeChildCall(BaseChannelHandler */*handler*/) override {}
@@ -3,8 +3,6 @@ TARGET = voicecall-telepathy-plugin
 
 PKGCONFIG += TelepathyQt5 TelepathyQt5Farstream
 
-#DEFINES += WANT_TRACE
-
 HEADERS += \
     telepathyproviderplugin.h \
     telepathyprovider.h \
@@ -22,3 +20,5 @@ SOURCES += \
     basechannelhandler.cpp
 
 DEFINES += PLUGIN_NAME=\\\"voicecall-telepathy-plugin\\\"
+
+OTHER_FILES += telepathyproviderplugin.json
@@ -31,38 +31,19 @@
 
 #include <TelepathyQt/StreamedMediaChannel>
 
-#include <QElapsedTimer>
-#include <qmath.h>
-
-static quint64 get_tick()
-{
-#if defined(CLOCK_BOOTTIME)
-   int id = CLOCK_BOOTTIME;
-#else
-   int id = CLOCK_MONOTONIC;
-#endif
-
-  quint64 res = 0;
+#include <voicecallstatemachine.h>
+#include <voicecalldurationtracker.h>
 
-  struct timespec ts;
-
-  if(clock_gettime(id, &ts) == 0) {
-    res = ts.tv_sec;
-    res *= 1000;
-    res += ts.tv_nsec / 1000000;
-  }
-
-  return res;
-}
+#include <qmath.h>
 
 class StreamChannelHandlerPrivate
 {
     Q_DECLARE_PUBLIC(StreamChannelHandler)
 
 public:
-    StreamChannelHandlerPrivate(StreamChannelHandler *q, const QString &id, Tp::StreamedMediaChannelPtr c, const QDateTime &s, TelepathyProvider *p)
-        : q_ptr(q), pendingHangup(NULL), handlerId(id), provider(p), startedAt(s), status(AbstractVoiceCallHandler::STATUS_NULL),
-          channel(c), servicePointInterface(NULL), duration(0), durationTimerId(-1), isEmergency(false),
+    StreamChannelHandlerPrivate(StreamChannelHandler *q, const VoiceCallHandle &h, Tp::StreamedMediaChannelPtr c, const QDateTime &s, TelepathyProvider *p)
+        : q_ptr(q), pendingHangup(NULL), handle(h), provider(p), startedAt(s),
+          channel(c), servicePointInterface(NULL), isEmergency(false),
           isForwarded(false), isIncoming(false), isRemoteHeld(false)
     { /* ... */ }
 
@@ -93,7 +74,7 @@ public:
     StreamChannelHandler  *q_ptr;
     QPointer<Tp::PendingOperation>  pendingHangup;
 
-    QString            handlerId;
+    VoiceCallHandle    handle;
     QString            parentHandlerId;
     TelepathyProvider *provider;
 
@@ -101,28 +82,37 @@ public:
 
     QDateTime          startedAt;
 
-    AbstractVoiceCallHandler::VoiceCallStatus status;
+    VoiceCallStateMachine stateMachine;
 
     Tp::StreamedMediaChannelPtr channel;
     Tp::Client::ChannelInterfaceServicePointInterface *servicePointInterface;
 
-    quint64 duration;
-    quint64 connectedAt;
-    int durationTimerId;
-    QElapsedTimer elapsedTimer;
+    QMetaObject::Connection durationTick;
     bool isEmergency;
     bool isForwarded;
     bool isIncoming;
     bool isRemoteHeld;
 };
 
-StreamChannelHandler::StreamChannelHandler(const QString &id, Tp::StreamedMediaChannelPtr channel, const QDateTime &userActionTime, TelepathyProvider *provider)
-    : BaseChannelHandler(provider), d_ptr(new StreamChannelHandlerPrivate(this, id, channel, userActionTime, provider))
+StreamChannelHandler::StreamChannelHandler(const VoiceCallHandle &handle, Tp::StreamedMediaChannelPtr channel, const QDateTime &userActionTime, TelepathyProvider *provider)
+    : BaseChannelHandler(provider), d_ptr(new StreamChannelHandlerPrivate(this, handle, channel, userActionTime, provider))
 {
     TRACE
     Q_D(StreamChannelHandler);
 
-    QObject::connect(this, SIGNAL(statusChanged(VoiceCallStatus)), SLOT(onStatusChanged()));
+    d->stateMachine.setHook(VoiceCallStateMachine::HOOK_DURATION_START, [this, d](VoiceCallStatus, VoiceCallStatus) {
+        VoiceCallDurationTracker *tracker = VoiceCallDurationTracker::instance();
+        tracker->start(d->handle.value());
+        if (!d->durationTick) {
+            d->durationTick = QObject::connect(tracker, &VoiceCallDurationTracker::tick, this, [this]() {
+                emit durationChanged(duration());
+            });
+        }
+    });
+    d->stateMachine.setHook(VoiceCallStateMachine::HOOK_DURATION_STOP, [d](VoiceCallStatus, VoiceCallStatus) {
+        VoiceCallDurationTracker::instance()->stop(d->handle.value());
+        QObject::disconnect(d->durationTick);
+    });
 
     QObject::connect(d->channel->becomeReady(),
                      SIGNAL(finished(Tp::PendingOperation*)),
@@ -149,6 +139,7 @@ StreamChannelHandler::~StreamChannelHandler()
         static_cast<BaseChannelHandler*>(callHandler)->setParentHandlerId(QString());
     }
 
+    VoiceCallDurationTracker::instance()->forget(d->handle.value());
     delete this->d_ptr;
 }
 
@@ -158,10 +149,16 @@ AbstractVoiceCallProvider* StreamChannelHandler::provider() const
     return d->provider;
 }
 
+const VoiceCallHandle& StreamChannelHandler::handle() const
+{
+    Q_D(const StreamChannelHandler);
+    return d->handle;
+}
+
 QString StreamChannelHandler::handlerId() const
 {
     Q_D(const StreamChannelHandler);
-    return d->handlerId;
+    return d->handle.toString();
 }
 
 Tp::ChannelPtr StreamChannelHandler::channel() const
@@ -196,7 +193,7 @@ QDateTime StreamChannelHandler::startedAt() const
 int StreamChannelHandler::duration() const
 {
     Q_D(const StreamChannelHandler);
-    return int(qRound(d->duration/1000.0));
+    return VoiceCallDurationTracker::instance()->seconds(d->handle.value());
 }
 
 bool StreamChannelHandler::isIncoming() const
@@ -249,22 +246,42 @@ QList<AbstractVoiceCallHandler*> StreamChannelHandler::childCalls() const
 AbstractVoiceCallHandler::VoiceCallStatus StreamChannelHandler::status() const
 {
     Q_D(const StreamChannelHandler);
-    return d->status;
+    return d->stateMachine.status();
 }
 
 void StreamChannelHandler::answer()
+{
+    TRACE
+    requestAnswer();
+}
+
+void StreamChannelHandler::hangup()
+{
+    TRACE
+    requestHangup();
+}
+
+void StreamChannelHandler::hold(bool on)
+{
+    TRACE
+    requestHold(on);
+}
+
+VoiceCallPendingOperation* StreamChannelHandler::requestAnswer()
 {
     TRACE
     Q_D(StreamChannelHandler);
 
-    QObject::connect(d->channel.data()->acceptCall(),
+    Tp::PendingOperation *op = d->channel.data()->acceptCall();
+    QObject::connect(op,
                      SIGNAL(finished(Tp::PendingOperation*)),
                      SLOT(onStreamedMediaChannelAcceptCallFinished(Tp::PendingOperation*)));
 
     setStatus(STATUS_ACTIVE);
+    return track(op, this);
 }
 
-void StreamChannelHandler::hangup()
+VoiceCallPendingOperation* StreamChannelHandler::requestHangup()
 {
     TRACE
     Q_D(StreamChannelHandler);
@@ -283,14 +300,17 @@ void StreamChannelHandler::hangup()
                          SIGNAL(finished(Tp::PendingOperation*)),
                          SLOT(onStreamedMediaChannelHangupCallFinished(Tp::PendingOperation*)));
     }
+
+    // A filtered request completes together with the one still pending.
+    return track(d->pendingHangup, this);
 }
 
-void StreamChannelHandler::hold(bool on)
+VoiceCallPendingOperation* StreamChannelHandler::requestHold(bool on)
 {
     TRACE
     Q_D(StreamChannelHandler);
     Tp::Client::ChannelInterfaceHoldInterface *holdIface = new Tp::Client::ChannelInterfaceHoldInterface(d->channel.data(), this);
-    holdIface->RequestHold(on);
+    return track(holdIface->RequestHold(on), this);
 }
 
 void StreamChannelHandler::getHoldState()
@@ -490,7 +510,7 @@ void StreamChannelHandler::onStreamedMediaChannelInvalidated(Tp::DBusProxy *, co
                         this,
                         SLOT(onStreamedMediaChannelInvalidated(Tp::DBusProxy*,QString,QString)));
 
-    if (d->status == STATUS_DISCONNECTED && !d->childCalls.isEmpty()) {
+    if (d->stateMachine.status() == STATUS_DISCONNECTED && !d->childCalls.isEmpty()) {
         // Conference call is in disconnect state and still has children.
         // Keep the conference handler alive in the disconnected state
         // until all children have been split or destroyed. This ensures that
@@ -593,13 +613,13 @@ void StreamChannelHandler::onStreamedMediaChannelCallStateChanged(uint, uint sta
     bool forwarded = state & Tp::ChannelCallStateForwarded;
     bool held = state & Tp::ChannelCallStateHeld;
 
-    if ((d->status == STATUS_HELD) && !held) {
+    if ((d->stateMachine.status() == STATUS_HELD) && !held) {
         setStatus(STATUS_ACTIVE);
         d->isRemoteHeld = false;
         emit remoteHeldChanged(d->isRemoteHeld);
     }
 
-    if (d->status != STATUS_HELD && held) {
+    if (d->stateMachine.status() != STATUS_HELD && held) {
         setStatus(STATUS_HELD);
         d->isRemoteHeld = true;
         emit remoteHeldChanged(d->isRemoteHeld);
@@ -674,7 +694,7 @@ void StreamChannelHandler::onStreamedMediaChannelGroupMembersChanged(QString mes
         {
             setStatus(STATUS_DISCONNECTED);
         }
-        else if (d->status != STATUS_HELD)
+        else if (d->stateMachine.status() != STATUS_HELD)
         {
             setStatus(STATUS_ACTIVE);
         }
@@ -708,17 +728,6 @@ void StreamChannelHandler::onStreamedMediaChannelHoldStateChanged(uint state, ui
     }
 }
 
-void StreamChannelHandler::timerEvent(QTimerEvent *event)
-{
-    Q_D(StreamChannelHandler);
-
-    if(isOngoing() && event->timerId() == d->durationTimerId)
-    {
-        d->duration = get_tick() - d->connectedAt;
-        emit this->durationChanged(duration());
-    }
-}
-
 void StreamChannelHandler::addChildCall(BaseChannelHandler *handler)
 {
     TRACE
@@ -727,7 +736,7 @@ void StreamChannelHandler::addChildCall(BaseChannelHandler *handler)
         return;
     DEBUG_T("Added child call: %s", qPrintable(handler->handlerId()));
     d->childCalls.append(handler);
-    handler->setParentHandlerId(d->handlerId);
+    handler->setParentHandlerId(d->handle.toString());
     emit childCallsChanged();
 }
 
@@ -747,37 +756,16 @@ void StreamChannelHandler::removeChildCall(BaseChannelHandler *handler)
     }
 }
 
-void StreamChannelHandler::onStatusChanged()
-{
-    TRACE
-    Q_D(StreamChannelHandler);
-
-    if(isOngoing())
-    {
-        if (d->durationTimerId == -1) {
-            d->durationTimerId = this->startTimer(1000);
-            d->elapsedTimer.start();
-            d->connectedAt = get_tick();
-        }
-    }
-    else if (d->durationTimerId != -1)
-    {
-        this->killTimer(d->durationTimerId);
-        d->durationTimerId = -1;
-    }
-}
-
 void StreamChannelHandler::setStatus(VoiceCallStatus newStatus)
 {
     TRACE
     Q_D(StreamChannelHandler);
-    if (newStatus == d->status)
+    if (!d->stateMachine.setStatus(newStatus))
         return;
 
-    d->status = newStatus;
-    emit statusChanged(d->status);
+    emit statusChanged(newStatus);
 
-    if (d->status == STATUS_DISCONNECTED && !d->parentHandlerId.isEmpty()) {
+    if (d->stateMachine.status() == STATUS_DISCONNECTED && !d->parentHandlerId.isEmpty()) {
         BaseChannelHandler *confHandler = d->provider->voiceCall(d->parentHandlerId);
         if (confHandler && confHandler->status() == STATUS_DISCONNECTED) {
             // Destroy this call immediately since the conference call is managing the disconnection
@@ -32,11 +32,12 @@ class StreamChannelHandler : public BaseChannelHandler
     Q_OBJECT
 
 public:
-    explicit StreamChannelHandler(const QString &id, Tp::StreamedMediaChannelPtr channel, const QDateTime &userActionTime, TelepathyProvider *provider = 0);
+    explicit StreamChannelHandler(const VoiceCallHandle &handle, Tp::StreamedMediaChannelPtr channel, const QDateTime &userActionTime, TelepathyProvider *provider = 0);
             ~StreamChannelHandler();
 
     /*** AbstractVoiceCallHandler Implementation ***/
     AbstractVoiceCallProvider* provider() const;
+    const VoiceCallHandle& handle() const;
     QString handlerId() const;
     QString lineId() const;
     QDateTime startedAt() const;
@@ -51,6 +52,10 @@ public:
 
     VoiceCallStatus status() const;
 
+    VoiceCallPendingOperation* requestAnswer();
+    VoiceCallPendingOperation* requestHangup();
+    VoiceCallPendingOperation* requestHold(bool on);
+
     /*** BaseChannelHandler Implementation ***/
     Tp::ChannelPtr channel() const override;
     void setParentHandlerId(const QString &handler) override;
@@ -69,8 +74,6 @@ public Q_SLOTS:
     void split();
 
 protected Q_SLOTS:
-    void onStatusChanged();
-
     // TODO: Remove when tp-ring updated to call channel interface.
     // StreamedMediaChannel Interface Handling
     void onStreamedMediaChannelReady(Tp::PendingOperation *op);
@@ -102,7 +105,6 @@ protected Q_SLOTS:
     void onStreamedMediaChannelConferenceMergeChannelFinished(Tp::PendingOperation *op);
 
 protected:
-    void timerEvent(QTimerEvent *event);
     void addChildCall(BaseChannelHandler *handler) override;
     void removeChildCall(BaseChannelHandler *handler) override;
 
@@ -24,6 +24,8 @@
 #include "callchannelhandler.h"
 #include "streamchannelhandler.h"
 
+#include <voicecallstats.h>
+
 #include <TelepathyQt/CallChannel>
 #include <TelepathyQt/StreamedMediaChannel>
 #include <TelepathyQt/PendingReady>
@@ -48,7 +50,7 @@ public:
 
     QString                      errorString;
 
-    QHash<QString,BaseChannelHandler*> voiceCalls;
+    QHash<quint64,BaseChannelHandler*> voiceCalls;
 
     Tp::PendingChannelRequest *tpChannelRequest;
 
@@ -105,7 +107,10 @@ BaseChannelHandler *TelepathyProvider::voiceCall(const QString &handlerId) const
 {
     TRACE
     Q_D(const TelepathyProvider);
-    return d->voiceCalls.value(handlerId);
+    quint64 handle = VoiceCallHandle::valueOf(handlerId);
+    if (!handle)
+        return NULL;
+    return d->voiceCalls.value(handle);
 }
 
 BaseChannelHandler *TelepathyProvider::voiceCall(Tp::ChannelPtr channel) const
@@ -122,6 +127,12 @@ BaseChannelHandler *TelepathyProvider::voiceCall(Tp::ChannelPtr channel) const
 }
 
 bool TelepathyProvider::dial(const QString &msisdn)
+{
+    TRACE
+    return !requestDial(msisdn)->isError();
+}
+
+VoiceCallPendingOperation* TelepathyProvider::requestDial(const QString &msisdn)
 {
     TRACE
     Q_D(TelepathyProvider);
@@ -130,7 +141,7 @@ bool TelepathyProvider::dial(const QString &msisdn)
         d->errorString = "Can't initiate a call when one is pending!";
         WARNING_T("%s", qPrintable(d->errorString));
         emit this->error(d->errorString);
-        return false;
+        return VoiceCallPendingOperation::completed(false, d->errorString, this);
     }
 
     if (d->account->protocolName() == "sip") {
@@ -143,7 +154,7 @@ bool TelepathyProvider::dial(const QString &msisdn)
         d->errorString = "Attempting to dial an unknown protocol";
         WARNING_T("%s", qPrintable(d->errorString));
         emit this->error(d->errorString);
-        return false;
+        return VoiceCallPendingOperation::completed(false, d->errorString, this);
     }
 
     QObject::connect(d->tpChannelRequest,
@@ -153,7 +164,7 @@ bool TelepathyProvider::dial(const QString &msisdn)
                      SIGNAL(channelRequestCreated(Tp::ChannelRequestPtr)),
                      SLOT(onChannelRequestCreated(Tp::ChannelRequestPtr)));
 
-    return true;
+    return BaseChannelHandler::track(d->tpChannelRequest, this);
 }
 
 bool TelepathyProvider::createConference(Tp::ChannelPtr channel1, Tp::ChannelPtr channel2)
@@ -262,6 +273,7 @@ void TelepathyProvider::createHandler(Tp::ChannelPtr ch, const QDateTime &userAc
     TRACE
     Q_D(TelepathyProvider);
     BaseChannelHandler *handler = 0;
+    qint64 seenAt = voicecallMonotonicTimestamp();
 
     DEBUG_T("\tProcessing channel: %s", qPrintable(ch->objectPath()));
 
@@ -269,14 +281,14 @@ void TelepathyProvider::createHandler(Tp::ChannelPtr ch, const QDateTime &userAc
     if(callChannel && !callChannel.isNull())
     {
         DEBUG_T("Found CallChannel interface.");
-        handler = new CallChannelHandler(d->manager->generateHandlerId(), callChannel, userActionTime, this);
+        handler = new CallChannelHandler(d->manager->generateHandle(), callChannel, userActionTime, this);
     }
 
     Tp::StreamedMediaChannelPtr streamChannel = Tp::StreamedMediaChannelPtr::dynamicCast(ch);
     if(streamChannel && !streamChannel.isNull())
     {
         DEBUG_T("Found StreamedMediaChannel interface.");
-        handler = new StreamChannelHandler(d->manager->generateHandlerId(), streamChannel, userActionTime, this);
+        handler = new StreamChannelHandler(d->manager->generateHandle(), streamChannel, userActionTime, this);
 
         connect(handler, &BaseChannelHandler::channelMerged, this, &TelepathyProvider::onChannelMerged);
         connect(handler, &BaseChannelHandler::channelRemoved, this, &TelepathyProvider::onChannelRemoved);
@@ -288,7 +300,8 @@ void TelepathyProvider::createHandler(Tp::ChannelPtr ch, const QDateTime &userAc
 
     if(!handler) return;
 
-    d->voiceCalls.insert(handler->handlerId(), handler);
+    VoiceCallStats::instance()->markStage(handler, VoiceCallStats::STAGE_CALL_ADDED, seenAt);
+    d->voiceCalls.insert(handler->handle().value(), handler);
 
     QObject::connect(handler, SIGNAL(error(QString)), SIGNAL(error(QString)));
     QObject::connect(handler, SIGNAL(invalidated(QString,QString)), SLOT(onHandlerInvalidated(QString,QString)));
@@ -354,7 +367,7 @@ void TelepathyProvider::onHandlerInvalidated(const QString &errorName, const QSt
     Q_D(TelepathyProvider);
 
     BaseChannelHandler *handler = qobject_cast<BaseChannelHandler*>(QObject::sender());
-    d->voiceCalls.remove(handler->handlerId());
+    d->voiceCalls.remove(handler->handle().value());
 
     emit this->voiceCallRemoved(handler->handlerId());
     emit this->voiceCallsChanged();
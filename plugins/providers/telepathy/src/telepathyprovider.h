@@ -51,6 +51,8 @@ public:
 
     void updateConferenceHoldState();
 
+    VoiceCallPendingOperation* requestDial(const QString &msisdn);
+
 public Q_SLOTS:
     bool dial(const QString &msisdn);
 
@@ -53,7 +53,8 @@ class TelepathyProviderPluginPrivate
 
 public:
     TelepathyProviderPluginPrivate(TelepathyProviderPlugin *q)
-        : q_ptr(q), manager(NULL), tpClientHandler(NULL), tpClientRegistrar(NULL), am(NULL)
+        : q_ptr(q), manager(NULL), tpClientHandler(NULL), tpClientRegistrar(NULL), am(NULL),
+          isGStreamerInitialized(false)
     {/* ... */}
 
     TelepathyProviderPlugin     *q_ptr;
@@ -67,9 +68,25 @@ public:
 
     QHash<QString,TelepathyProvider*>    providers;
 
+    // GStreamer loads its whole plugin registry on init, which is only
+    // needed once there is a channel to stream.
+    bool isGStreamerInitialized;
+    void initializeGStreamer();
+
     static const Tp::ChannelClassSpecList CHANNEL_SPECS;
 };
 
+void TelepathyProviderPluginPrivate::initializeGStreamer()
+{
+    if (isGStreamerInitialized) return;
+
+    int argc = 0;
+    char **argv = { 0 };
+
+    gst_init(&argc, &argv);
+    isGStreamerInitialized = true;
+}
+
 //TODO: Properly ascertain what these different types actually related to (ring, sip, etc).
 const Tp::ChannelClassSpecList TelepathyProviderPluginPrivate::CHANNEL_SPECS =
         (Tp::ChannelClassSpecList()
@@ -107,8 +124,6 @@ bool TelepathyProviderPlugin::initialize()
 {
     TRACE
     Q_D(TelepathyProviderPlugin);
-    int argc = 0;
-    char **argv = { 0 };
 
     Tp::registerTypes();
 
@@ -118,7 +133,6 @@ bool TelepathyProviderPlugin::initialize()
 #endif
 
     g_type_init();
-    gst_init(&argc, &argv);
 
     d->am = Tp::AccountManager::create();
 
@@ -232,6 +246,8 @@ void TelepathyProviderPlugin::handleChannels(const Tp::MethodInvocationContextPt
         return;
     }
 
+    d->initializeGStreamer();
+
     TelepathyProvider *provider = d->providers.value(account.data()->uniqueIdentifier());
     DEBUG_T("Found provider for account %1, invoking provider to create handlers.", qPrintable(account.data()->uniqueIdentifier()));
     foreach(Tp::ChannelPtr ch, channels)
@@ -33,7 +33,7 @@ class TelepathyProviderPlugin : public AbstractVoiceCallManagerPlugin, public Tp
 {
     Q_OBJECT
 
-    Q_PLUGIN_METADATA(IID "org.nemomobile.voicecall.telepathy")
+    Q_PLUGIN_METADATA(IID "org.nemomobile.voicecall.telepathy" FILE "telepathyproviderplugin.json")
     Q_INTERFACES(AbstractVoiceCallManagerPlugin)
 
 public:
@@ -68,6 +68,13 @@ AbstractVoiceCallProvider* AudioCallPolicyProxy::provider() const
     return d->subject->provider();
 }
 
+const VoiceCallHandle& AudioCallPolicyProxy::handle() const
+{
+    TRACE
+    Q_D(const AudioCallPolicyProxy);
+    return d->subject->handle();
+}
+
 QString AudioCallPolicyProxy::handlerId() const
 {
     TRACE
@@ -34,6 +34,7 @@ public:
 
     AbstractVoiceCallProvider* provider() const;
 
+    const VoiceCallHandle& handle() const;
     QString handlerId() const;
     QString lineId() const;
     QDateTime startedAt() const;
@@ -54,8 +54,38 @@ public:
     QMediaPlayer                *player;
     AbstractVoiceCallHandler    *currentCall;
     VoiceCallManagerInterface   *manager;
+
+    void setupPlayer();
+    void releaseCurrentCall();
 };
 
+void BasicRingtoneNotificationProviderPrivate::releaseCurrentCall()
+{
+    Q_Q(BasicRingtoneNotificationProvider);
+    if (!currentCall) return;
+
+    DEBUG_T("Disconnecting from handler.");
+    QObject::disconnect(currentCall, 0, q, 0);
+    currentCall = NULL;
+
+    if (player)
+    {
+        player->stop();
+        player->setPosition(0);
+    }
+}
+
+void BasicRingtoneNotificationProviderPrivate::setupPlayer()
+{
+    Q_Q(BasicRingtoneNotificationProvider);
+
+    QObject::connect(manager, SIGNAL(silenceRingtoneRequested()), player, SLOT(stop()));
+
+    player->setMedia(QMediaContent(QUrl::fromLocalFile("/usr/share/voicecall/sounds/ring-1.wav")));
+    player->setVolume(100);
+    QObject::connect(player, SIGNAL(mediaStatusChanged(QMediaPlayer::MediaStatus)), q, SLOT(onMediaPlayerMediaStatusChanged()));
+}
+
 BasicRingtoneNotificationProvider::BasicRingtoneNotificationProvider(QObject *parent)
     : AbstractVoiceCallManagerPlugin(parent),
       d_ptr(new BasicRingtoneNotificationProviderPrivate(this))
@@ -97,11 +127,9 @@ bool BasicRingtoneNotificationProvider::configure(VoiceCallManagerInterface *man
 
     d->manager = manager;
     QObject::connect(manager, SIGNAL(voiceCallAdded(AbstractVoiceCallHandler*)), SLOT(onVoiceCallAdded(AbstractVoiceCallHandler*)));
-    QObject::connect(manager, SIGNAL(silenceRingtoneRequested()), d->player, SLOT(stop()));
+    QObject::connect(manager, SIGNAL(voiceCallRemoved(QString)), SLOT(onVoiceCallRemoved(QString)));
 
-    d->player->setMedia(QMediaContent(QUrl::fromLocalFile("/usr/share/voicecall/sounds/ring-1.wav")));
-    d->player->setVolume(100);
-    QObject::connect(d->player, SIGNAL(mediaStatusChanged(QMediaPlayer::MediaStatus)), SLOT(onMediaPlayerMediaStatusChanged()));
+    d->setupPlayer();
 
     return true;
 }
@@ -115,12 +143,24 @@ bool BasicRingtoneNotificationProvider::start()
 bool BasicRingtoneNotificationProvider::suspend()
 {
     TRACE
+    Q_D(BasicRingtoneNotificationProvider);
+
+    // The player holds on to decoder and audio resources, drop it while idle.
+    if (d->currentCall) return false;
+
+    delete d->player;
+    d->player = NULL;
     return true;
 }
 
 bool BasicRingtoneNotificationProvider::resume()
 {
     TRACE
+    Q_D(BasicRingtoneNotificationProvider);
+    if (d->player) return true;
+
+    d->player = new QMediaPlayer(this);
+    d->setupPlayer();
     return true;
 }
 
@@ -135,6 +175,7 @@ void BasicRingtoneNotificationProvider::onVoiceCallAdded(AbstractVoiceCallHandle
     Q_D(BasicRingtoneNotificationProvider);
 
     QObject::connect(handler, SIGNAL(statusChanged(VoiceCallStatus)), SLOT(onVoiceCallStatusChanged()));
+    QObject::connect(handler, SIGNAL(destroyed()), SLOT(onVoiceCallDestroyed()));
     d->currentCall = handler;
 }
 
@@ -145,13 +186,7 @@ void BasicRingtoneNotificationProvider::onVoiceCallStatusChanged()
 
     if(d->currentCall->status() != AbstractVoiceCallHandler::STATUS_INCOMING)
     {
-        DEBUG_T("Disconnecting from handler.");
-        QObject::disconnect(d->currentCall, SIGNAL(statusChanged(VoiceCallStatus)), this, SLOT(onVoiceCallStatusChanged()));
-
-        d->player->stop();
-        d->player->setPosition(0);
-
-        d->currentCall = NULL;
+        d->releaseCurrentCall();
     }
     else if(d->player->mediaStatus() != QMediaPlayer::PlayingState)
     {
@@ -160,6 +195,34 @@ void BasicRingtoneNotificationProvider::onVoiceCallStatusChanged()
     }
 }
 
+/*
+  A call can go away while still incoming, it must not keep suspend() from
+  dropping the player.
+*/
+void BasicRingtoneNotificationProvider::onVoiceCallRemoved(const QString &handlerId)
+{
+    TRACE
+    Q_D(BasicRingtoneNotificationProvider);
+    if (d->currentCall && d->currentCall->handlerId() == handlerId)
+        d->releaseCurrentCall();
+}
+
+void BasicRingtoneNotificationProvider::onVoiceCallDestroyed()
+{
+    TRACE
+    Q_D(BasicRingtoneNotificationProvider);
+    if (d->currentCall == sender())
+    {
+        // The handler is half destroyed, nothing to disconnect from anymore.
+        d->currentCall = NULL;
+        if (d->player)
+        {
+            d->player->stop();
+            d->player->setPosition(0);
+        }
+    }
+}
+
 void BasicRingtoneNotificationProvider::onMediaPlayerMediaStatusChanged()
 {
     TRACE
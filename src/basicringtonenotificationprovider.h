@@ -45,6 +45,8 @@ public Q_SLOTS:
 protected Q_SLOTS:
     void onVoiceCallAdded(AbstractVoiceCallHandler *handler);
     void onVoiceCallStatusChanged();
+    void onVoiceCallRemoved(const QString &handlerId);
+    void onVoiceCallDestroyed();
     void onMediaPlayerMediaStatusChanged();
 
 private:
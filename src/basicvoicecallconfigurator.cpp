@@ -23,9 +23,41 @@
 
 #include "dbus/voicecallmanagerdbusservice.h"
 #include "basicringtonenotificationprovider.h"
+#include "voicecallpluginmanifest.h"
+#include "voicecallstartupprofiler.h"
 
-#include <QDir>
+#include <voicecallstats.h>
+
+#include <QElapsedTimer>
 #include <QPluginLoader>
+#include <QRunnable>
+#include <QSettings>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+// Plugins listed here run in a thread of their own instead of the main thread.
+// VOICECALL_THREADED_PLUGINS (comma separated plugin ids) overrides the
+// "Plugins/threaded" setting.
+static QStringList threadedPluginIds()
+{
+    QByteArray env = qgetenv("VOICECALL_THREADED_PLUGINS");
+    if (!env.isNull())
+        return QString::fromLocal8Bit(env).split(',', QString::SkipEmptyParts);
+
+    return QSettings().value("Plugins/threaded").toStringList();
+}
+
+class VoiceCallPluginLoadTask : public QRunnable
+{
+public:
+    explicit VoiceCallPluginLoadTask(QPluginLoader *loader) : loader(loader) {/* ... */}
+
+    void run() { loader->load(); }
+
+private:
+    QPluginLoader *loader;
+};
 
 class BasicVoiceCallConfiguratorPrivate
 {
@@ -41,18 +73,176 @@ public:
     VoiceCallManagerInterface *manager;
 
     QHash<QString,AbstractVoiceCallManagerPlugin*> plugins;
+
+    QStringList threadedPlugins;
+    QHash<QString,QThread*> pluginThreads;
+
+    QList<VoiceCallPluginInfo> lazyPlugins;
+
+    QList<QPluginLoader*> loadPlugins(const QList<VoiceCallPluginInfo> &plugins, QThreadPool *pool);
+    void installPlugins(const QList<VoiceCallPluginInfo> &plugins, const QList<QPluginLoader*> &loaders);
+
+    bool installThreadedPlugin(AbstractVoiceCallManagerPlugin *plugin);
+    bool invokePlugin(AbstractVoiceCallManagerPlugin *plugin, const char *method);
 };
 
+bool BasicVoiceCallConfiguratorPrivate::invokePlugin(AbstractVoiceCallManagerPlugin *plugin, const char *method)
+{
+    bool result = false;
+    QMetaObject::invokeMethod(plugin, method,
+                              pluginThreads.contains(plugin->pluginId()) ? Qt::BlockingQueuedConnection
+                                                                         : Qt::DirectConnection,
+                              Q_RETURN_ARG(bool, result));
+    return result;
+}
+
+QList<QPluginLoader*> BasicVoiceCallConfiguratorPrivate::loadPlugins(const QList<VoiceCallPluginInfo> &plugins, QThreadPool *pool)
+{
+    QList<QPluginLoader*> loaders;
+
+    // Only the loading happens on the pool, the instances are created on
+    // this thread by installPlugins().
+    pool->setMaxThreadCount(qMax(1, qMin(plugins.count(), QThread::idealThreadCount())));
+    foreach (const VoiceCallPluginInfo &info, plugins)
+    {
+        DEBUG_T("Attempting to load dynamic plugin: %s", qPrintable(info.filePath));
+        QPluginLoader *loader = new QPluginLoader(info.filePath);
+        pool->start(new VoiceCallPluginLoadTask(loader));
+        loaders.append(loader);
+    }
+
+    return loaders;
+}
+
+void BasicVoiceCallConfiguratorPrivate::installPlugins(const QList<VoiceCallPluginInfo> &plugins, const QList<QPluginLoader*> &loaders)
+{
+    Q_Q(BasicVoiceCallConfigurator);
+
+    for (int i = 0; i < plugins.count(); ++i)
+    {
+        const VoiceCallPluginInfo &info = plugins.at(i);
+        QPluginLoader *loader = loaders.at(i);
+
+        bool ready = true;
+        foreach (const QString &dependency, info.dependencies)
+        {
+            if (!this->plugins.contains(dependency))
+            {
+                WARNING_T("Plugin %s requires %s, which is not installed", qPrintable(info.id), qPrintable(dependency));
+                ready = false;
+            }
+        }
+
+        if (!ready)
+        {
+            loader->unload();
+            continue;
+        }
+
+        QObject *instance = loader->instance();
+        AbstractVoiceCallManagerPlugin *managerPlugin = NULL;
+
+        if(!instance)
+        {
+            WARNING_T("Failed to load plugin: %s", qPrintable(loader->errorString()));
+            loader->unload();
+            continue;
+        }
+
+        managerPlugin = qobject_cast<AbstractVoiceCallManagerPlugin*>(instance);
+
+        if(!managerPlugin)
+        {
+            WARNING_T("Failed to load plugin: No manager plugin interface.");
+            loader->unload();
+            continue;
+        }
+
+        if (managerPlugin->pluginId() != info.id)
+        {
+            WARNING_T("Plugin %s identifies itself as %s", qPrintable(info.id), qPrintable(managerPlugin->pluginId()));
+        }
+
+        if (!q->installPlugin(managerPlugin)) {
+            WARNING_T("Plugin configuration failed");
+            delete managerPlugin;
+            loader->unload();
+            continue;
+        }
+    }
+
+    qDeleteAll(loaders);
+}
+
+bool BasicVoiceCallConfiguratorPrivate::installThreadedPlugin(AbstractVoiceCallManagerPlugin *plugin)
+{
+    Q_Q(BasicVoiceCallConfigurator);
+    DEBUG_T("Running plugin %s in its own thread", qPrintable(plugin->pluginId()));
+
+    QThread *thread = new QThread(q);
+    thread->setObjectName(plugin->pluginId());
+    plugin->moveToThread(thread);
+    thread->start();
+
+    // Set up is still sequential, the plugin just runs it in its own thread.
+    bool ok = false;
+    {
+        VoiceCallStartupProfiler::Phase phase("initialize");
+        QMetaObject::invokeMethod(plugin, "initialize", Qt::BlockingQueuedConnection);
+    }
+    {
+        VoiceCallStartupProfiler::Phase phase("configure");
+        QMetaObject::invokeMethod(plugin, "configure", Qt::BlockingQueuedConnection,
+                                  Q_RETURN_ARG(bool, ok), Q_ARG(VoiceCallManagerInterface*, manager));
+    }
+    if (ok)
+    {
+        VoiceCallStartupProfiler::Phase phase("start");
+        QMetaObject::invokeMethod(plugin, "start", Qt::BlockingQueuedConnection);
+    }
+
+    if (!ok)
+    {
+        // The caller deletes the plugin, which is only safe once its thread is gone.
+        thread->quit();
+        thread->wait();
+        delete thread;
+        return false;
+    }
+
+    // Resumed in its own thread, timed there. The request is queued ahead of
+    // anything the wake up itself sends to the plugin, so that still finds
+    // the plugin resumed.
+    QObject::connect(q, &BasicVoiceCallConfigurator::threadedPluginsResumeRequested, plugin, [plugin]() {
+        QElapsedTimer elapsed;
+        elapsed.start();
+
+        if (!plugin->resume())
+            WARNING_T("Plugin %s failed to resume", qPrintable(plugin->pluginId()));
+
+        VoiceCallStats::instance()->record(plugin->pluginId(), "resume", elapsed.nsecsElapsed() / 1000);
+    }, Qt::QueuedConnection);
+
+    pluginThreads.insert(plugin->pluginId(), thread);
+    return true;
+}
+
 BasicVoiceCallConfigurator::BasicVoiceCallConfigurator(QObject *parent)
     : QObject(parent), d_ptr(new BasicVoiceCallConfiguratorPrivate(this))
 {
     TRACE
+    qRegisterMetaType<VoiceCallManagerInterface*>("VoiceCallManagerInterface*");
 }
 
 BasicVoiceCallConfigurator::~BasicVoiceCallConfigurator()
 {
     TRACE
     Q_D(BasicVoiceCallConfigurator);
+    foreach (QThread *thread, d->pluginThreads)
+    {
+        thread->quit();
+        thread->wait();
+    }
     delete d;
 }
 
@@ -61,51 +251,62 @@ bool BasicVoiceCallConfigurator::configure(VoiceCallManagerInterface *manager)
     TRACE
     Q_D(BasicVoiceCallConfigurator);
     d->manager = manager;
+    d->threadedPlugins = threadedPluginIds();
+
+    QObject::connect(manager, SIGNAL(idleChanged(bool)), SLOT(onManagerIdleChanged(bool)));
+
+    DEBUG_T("Loading dynamic plugins from: %s", VOICECALL_PLUGIN_DIRECTORY);
+    QList<VoiceCallPluginInfo> eagerPlugins;
+    {
+        VoiceCallStartupProfiler::Phase phase("plugin manifest");
+        foreach (const VoiceCallPluginInfo &info, VoiceCallPluginManifest::sort(VoiceCallPluginManifest::load(VOICECALL_PLUGIN_DIRECTORY)))
+        {
+            if (info.isLazy)
+                d->lazyPlugins.append(info);
+            else
+                eagerPlugins.append(info);
+        }
+    }
+
+    // Map the eager plugins while the D-Bus service comes up.
+    QThreadPool pool;
+    QList<QPluginLoader*> loaders = d->loadPlugins(eagerPlugins, &pool);
 
     // Install statically linked plugins.
     VoiceCallManagerDBusService *srv = new VoiceCallManagerDBusService(this);
     if (!this->installPlugin(srv)) {
         WARNING_T("Installation of DBus service failed, already running?");
         delete srv;
+        pool.waitForDone();
+        qDeleteAll(loaders);
         return false;
     }
 
-    QDir pluginPath(VOICECALL_PLUGIN_DIRECTORY);
-    DEBUG_T("Loading dynamic plugins from: %s", qPrintable(pluginPath.absolutePath()));
-    foreach(QString plugin, pluginPath.entryList((QStringList() << "lib*plugin*so"),
-                                                 QDir::NoDotAndDotDot | QDir::Files))
     {
-        DEBUG_T("Attempting to load dynamic plugin: %s", qPrintable(pluginPath.absoluteFilePath(plugin)));
+        VoiceCallStartupProfiler::Phase phase("waiting for plugin loading");
+        pool.waitForDone();
+    }
+    d->installPlugins(eagerPlugins, loaders);
 
-        QPluginLoader loader(pluginPath.absoluteFilePath(plugin));
-        QObject *instance = loader.instance();
-        AbstractVoiceCallManagerPlugin *managerPlugin = NULL;
+    // Everything else waits for the event loop, the service is usable by then.
+    if (!d->lazyPlugins.isEmpty())
+        QTimer::singleShot(0, this, SLOT(loadLazyPlugins()));
 
-        if(!instance)
-        {
-            WARNING_T("Failed to load plugin: %s", qPrintable(loader.errorString()));
-            loader.unload();
-            continue;
-        }
+    return true;
+}
 
-        managerPlugin = qobject_cast<AbstractVoiceCallManagerPlugin*>(instance);
+void BasicVoiceCallConfigurator::loadLazyPlugins()
+{
+    TRACE
+    Q_D(BasicVoiceCallConfigurator);
+    VoiceCallStartupProfiler::Phase phase("lazy plugins");
 
-        if(!managerPlugin)
-        {
-            WARNING_T("Failed to load plugin: No manager plugin interface.");
-            loader.unload();
-            continue;
-        }
+    QThreadPool pool;
+    QList<QPluginLoader*> loaders = d->loadPlugins(d->lazyPlugins, &pool);
+    pool.waitForDone();
 
-        if (!this->installPlugin(managerPlugin)) {
-            WARNING_T("Plugin configuration failed");
-            delete managerPlugin;
-            loader.unload();
-            continue;
-        }
-    }
-
-    return true;
+    d->installPlugins(d->lazyPlugins, loaders);
+    d->lazyPlugins.clear();
 }
 
 bool BasicVoiceCallConfigurator::installPlugin(AbstractVoiceCallManagerPlugin *plugin)
@@ -122,10 +323,30 @@ bool BasicVoiceCallConfigurator::installPlugin(AbstractVoiceCallManagerPlugin *p
 
     d->plugins.insert(plugin->pluginId(), plugin);
 
-    plugin->initialize();
-    if (!plugin->configure(d->manager))
+    VoiceCallStartupProfiler::Phase phase(plugin->pluginId());
+
+    if (d->threadedPlugins.contains(plugin->pluginId()) && !plugin->parent())
+    {
+        if (d->installThreadedPlugin(plugin))
+            return true;
+
+        d->plugins.remove(plugin->pluginId());
         return false;
-    plugin->start();
+    }
+
+    {
+        VoiceCallStartupProfiler::Phase phase("initialize");
+        plugin->initialize();
+    }
+    {
+        VoiceCallStartupProfiler::Phase phase("configure");
+        if (!plugin->configure(d->manager))
+            return false;
+    }
+    {
+        VoiceCallStartupProfiler::Phase phase("start");
+        plugin->start();
+    }
     return true;
 }
 
@@ -135,9 +356,61 @@ void BasicVoiceCallConfigurator::removePlugin(AbstractVoiceCallManagerPlugin *pl
     Q_D(BasicVoiceCallConfigurator);
     if(!d->plugins.contains(plugin->pluginId())) return;
 
-    plugin->suspend();
-    plugin->finalize();
+    QThread *thread = d->pluginThreads.take(plugin->pluginId());
+    if (thread)
+    {
+        QMetaObject::invokeMethod(plugin, "suspend", Qt::BlockingQueuedConnection);
+        QMetaObject::invokeMethod(plugin, "finalize", Qt::BlockingQueuedConnection);
+
+        // Stop the thread once the plugin has been deleted in it.
+        QObject::connect(plugin, SIGNAL(destroyed()), thread, SLOT(quit()));
+        QObject::connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+    }
+    else
+    {
+        plugin->suspend();
+        plugin->finalize();
+    }
 
     d->plugins.remove(plugin->pluginId());
     plugin->deleteLater();
 }
+
+void BasicVoiceCallConfigurator::onManagerIdleChanged(bool idle)
+{
+    TRACE
+    Q_D(BasicVoiceCallConfigurator);
+
+    if (idle)
+    {
+        foreach (AbstractVoiceCallManagerPlugin *plugin, d->plugins)
+        {
+            if (!d->invokePlugin(plugin, "suspend"))
+                WARNING_T("Plugin %s failed to suspend", qPrintable(plugin->pluginId()));
+        }
+        return;
+    }
+
+    // Runs before the call or dial request that woke the manager up is passed
+    // on, so the time spent here adds to the call setup latency. Threaded
+    // plugins are not waited for, they resume in their own thread.
+    emit threadedPluginsResumeRequested();
+
+    QElapsedTimer total;
+    total.start();
+
+    foreach (AbstractVoiceCallManagerPlugin *plugin, d->plugins)
+    {
+        if (d->pluginThreads.contains(plugin->pluginId())) continue;
+
+        QElapsedTimer elapsed;
+        elapsed.start();
+
+        if (!d->invokePlugin(plugin, "resume"))
+            WARNING_T("Plugin %s failed to resume", qPrintable(plugin->pluginId()));
+
+        VoiceCallStats::instance()->record(plugin->pluginId(), "resume", elapsed.nsecsElapsed() / 1000);
+    }
+
+    VoiceCallStats::instance()->record("manager", "resume", total.nsecsElapsed() / 1000);
+}
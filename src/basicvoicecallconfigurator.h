@@ -35,6 +35,8 @@ public:
             ~BasicVoiceCallConfigurator();
 
 Q_SIGNALS:
+    // Delivered to the plugins running in their own threads, see onManagerIdleChanged().
+    void threadedPluginsResumeRequested();
 
 public Q_SLOTS:
     bool configure(VoiceCallManagerInterface *manager);
@@ -44,6 +46,10 @@ protected Q_SLOTS:
     bool installPlugin(AbstractVoiceCallManagerPlugin *plugin);
     void removePlugin(AbstractVoiceCallManagerPlugin *plugin);
 
+    void onManagerIdleChanged(bool idle);
+
+    void loadLazyPlugins();
+
 private:
     class BasicVoiceCallConfiguratorPrivate *d_ptr;
 
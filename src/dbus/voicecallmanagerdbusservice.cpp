@@ -22,12 +22,20 @@
 
 #include "voicecallmanagerdbusservice.h"
 #include <dbus/voicecallmanagerdbusadapter.h>
-#include <dbus/voicecallhandlerdbusadapter.h>
+#include <dbus/voicecallhandlerdbusobject.h>
+#include <dbus/voicecallstatsdbusadapter.h>
+#include <dbus/voicecallobjectmanagerdbusadapter.h>
+#include <dbus/voicecallpropertiesnotifier.h>
 
 #include <voicecallmanagerinterface.h>
 
+#include "voicecallstatetablewriter.h"
+
 #include <QDBusError>
 #include <QDBusConnection>
+#include <QDBusServer>
+#include <QFile>
+#include <QDir>
 
 class VoiceCallManagerDBusServicePrivate
 {
@@ -35,13 +43,40 @@ class VoiceCallManagerDBusServicePrivate
 
 public:
     VoiceCallManagerDBusServicePrivate(VoiceCallManagerDBusService *q)
-        : q_ptr(q), manager(NULL), managerAdapter(NULL)
+        : q_ptr(q), manager(NULL), managerAdapter(NULL), objectManagerAdapter(NULL), callsObject(NULL), peerServer(NULL), stateTable(NULL)
     {/* ... */}
 
     VoiceCallManagerDBusService *q_ptr;
 
     VoiceCallManagerInterface *manager;
     VoiceCallManagerDBusAdapter *managerAdapter;
+    VoiceCallObjectManagerDBusAdapter *objectManagerAdapter;
+
+    // Serves every /calls/<id> path, and /calls/active.
+    VoiceCallHandlerDBusObject *callsObject;
+
+    // Private socket for clients that connect directly instead of through the bus daemon.
+    QDBusServer *peerServer;
+    QStringList peerConnections;
+
+    VoiceCallStateTableWriter *stateTable;
+
+    void startPeerServer();
+
+    bool registerObjects(QDBusConnection connection);
+
+    // Forgets peer connections that have been closed.
+    void prunePeerConnections()
+    {
+        for(int i = peerConnections.count() - 1; i >= 0; --i)
+        {
+            if(QDBusConnection(peerConnections.at(i)).isConnected()) continue;
+
+            DEBUG_T("Dropping closed peer connection %s", qPrintable(peerConnections.at(i)));
+            VoiceCallPropertiesNotifier::removeConnection(peerConnections.at(i));
+            QDBusConnection::disconnectFromPeer(peerConnections.takeAt(i));
+        }
+    }
 };
 
 VoiceCallManagerDBusService::VoiceCallManagerDBusService(QObject *parent)
@@ -76,12 +111,15 @@ bool VoiceCallManagerDBusService::configure(VoiceCallManagerInterface *manager)
 
     d->manager = manager;
     d->managerAdapter = new VoiceCallManagerDBusAdapter(manager);
+    d->objectManagerAdapter = new VoiceCallObjectManagerDBusAdapter(manager);
+    new VoiceCallStatsDBusAdapter(manager);
 
-    if(!QDBusConnection::sessionBus().registerObject("/", manager))
-    {
-        WARNING_T("Failed to register DBus object: %s", qPrintable(QDBusConnection::sessionBus().lastError().message()));
-        return false;
-    }
+    // Configured before the manager adapter, so that a call is known here by
+    // the time CallAdded carries its properties.
+    d->callsObject = new VoiceCallHandlerDBusObject(this);
+    d->callsObject->configure(manager);
+
+    if(!d->registerObjects(QDBusConnection::sessionBus())) return false;
 
     if(!QDBusConnection::sessionBus().registerService("org.nemomobile.voicecall"))
     {
@@ -89,11 +127,17 @@ bool VoiceCallManagerDBusService::configure(VoiceCallManagerInterface *manager)
         return false;
     }
 
-    QObject::connect(manager, SIGNAL(voiceCallAdded(AbstractVoiceCallHandler*)), SLOT(onVoiceCallAdded(AbstractVoiceCallHandler*)));
-    QObject::connect(manager, SIGNAL(voiceCallRemoved(QString)), SLOT(onVoiceCallRemoved(QString)));
-    QObject::connect(manager, SIGNAL(activeVoiceCallChanged()), SLOT(onActiveVoiceCallChanged()));
+    d->startPeerServer();
+
+    d->managerAdapter->configure(manager, d->callsObject);
+    d->objectManagerAdapter->configure(manager, d->callsObject);
+
+    d->stateTable = new VoiceCallStateTableWriter(manager, d->callsObject, this);
+    if(d->stateTable->isValid())
+    {
+        d->managerAdapter->setStateTable(d->stateTable->fileDescriptor());
+    }
 
-    d->managerAdapter->configure(manager);
     return true;
 }
 
@@ -120,39 +164,71 @@ void VoiceCallManagerDBusService::finalize()
     TRACE
 }
 
-void VoiceCallManagerDBusService::onVoiceCallAdded(AbstractVoiceCallHandler *handler)
+void VoiceCallManagerDBusService::onPeerConnected(const QDBusConnection &peer)
 {
     TRACE
     Q_D(VoiceCallManagerDBusService);
+    QDBusConnection connection(peer);
 
-    new VoiceCallHandlerDBusAdapter(handler);
+    DEBUG_T("Accepted peer connection %s", qPrintable(connection.name()));
 
-    if(!QDBusConnection::sessionBus().registerObject("/calls/" + handler->handlerId(), handler))
+    // Export the same objects as on the session bus.
+    if(!d->registerObjects(connection))
     {
-        WARNING_T("Failed to register DBus object: %s", qPrintable(QDBusConnection::sessionBus().lastError().message()));
+        QDBusConnection::disconnectFromPeer(connection.name());
+        return;
     }
+
+    d->prunePeerConnections();
+    d->peerConnections.append(connection.name());
+    VoiceCallPropertiesNotifier::addConnection(connection);
 }
 
-void VoiceCallManagerDBusService::onVoiceCallRemoved(const QString &handlerId)
+bool VoiceCallManagerDBusServicePrivate::registerObjects(QDBusConnection connection)
 {
     TRACE
-    Q_D(VoiceCallManagerDBusService);
+    if(!connection.registerObject("/", manager))
+    {
+        WARNING_T("Failed to register DBus object: %s", qPrintable(connection.lastError().message()));
+        return false;
+    }
 
-    QDBusConnection::sessionBus().unregisterObject("/calls/" + handlerId);
+    if(!connection.registerVirtualObject("/calls", callsObject, QDBusConnection::SubPath))
+    {
+        WARNING_T("Failed to register DBus object: %s", qPrintable(connection.lastError().message()));
+        connection.unregisterObject("/");
+        return false;
+    }
+
+    return true;
 }
 
-void VoiceCallManagerDBusService::onActiveVoiceCallChanged()
+void VoiceCallManagerDBusServicePrivate::startPeerServer()
 {
     TRACE
-    Q_D(VoiceCallManagerDBusService);
+    Q_Q(VoiceCallManagerDBusService);
+    QByteArray runtimeDir = qgetenv("XDG_RUNTIME_DIR");
 
-    if(d->manager->activeVoiceCall())
+    if(runtimeDir.isEmpty())
     {
-        DEBUG_T("VoiceCallManagerDBusService:: registering active voice call interface.");
-        QDBusConnection::sessionBus().registerObject("/calls/active", d->manager->activeVoiceCall());
+        DEBUG_T("XDG_RUNTIME_DIR is not set, not listening for peer connections.");
+        return;
     }
-    else
+
+    // The bus name is ours, so a socket left at this path is stale.
+    QString path = QDir(QString::fromLocal8Bit(runtimeDir)).filePath("voicecall-manager-peer");
+    QFile::remove(path);
+
+    peerServer = new QDBusServer("unix:path=" + path, q);
+    if(!peerServer->isConnected())
     {
-        QDBusConnection::sessionBus().unregisterObject("/calls/active");
+        WARNING_T("Failed to listen for peer connections on %s: %s", qPrintable(path),
+                  qPrintable(peerServer->lastError().message()));
+        delete peerServer;
+        peerServer = NULL;
+        return;
     }
+
+    QObject::connect(peerServer, SIGNAL(newConnection(QDBusConnection)), q, SLOT(onPeerConnected(QDBusConnection)));
+    managerAdapter->setPeerAddress(peerServer->address());
 }
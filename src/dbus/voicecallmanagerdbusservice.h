@@ -24,6 +24,8 @@
 #include <abstractvoicecallhandler.h>
 #include <abstractvoicecallmanagerplugin.h>
 
+#include <QDBusConnection>
+
 class VoiceCallManagerDBusService : public AbstractVoiceCallManagerPlugin
 {
     Q_OBJECT
@@ -43,10 +45,7 @@ public Q_SLOTS:
     void finalize();
 
 protected Q_SLOTS:
-    void onVoiceCallAdded(AbstractVoiceCallHandler *handler);
-    void onVoiceCallRemoved(const QString &handlerId);
-
-    void onActiveVoiceCallChanged();
+    void onPeerConnected(const QDBusConnection &peer);
 
 private:
     class VoiceCallManagerDBusServicePrivate *d_ptr;
@@ -20,23 +20,76 @@
  */
 #include <QCoreApplication>
 
+#include "common.h"
 #include "voicecallmanager.h"
 #include "basicvoicecallconfigurator.h"
+#include "voicecallstartupprofiler.h"
+
+#include <QTimer>
+
+// Time given to asynchronous start up (lazy plugins, modem discovery) before
+// the startup profile is reported.
+#define VOICECALL_PROFILE_SETTLE_TIME 3000
+
+#ifdef WANT_TRACE
+#include <QSocketNotifier>
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int traceDumpFds[2];
+
+static void onTraceDumpSignal(int)
+{
+    char c = 1;
+    if (::write(traceDumpFds[0], &c, 1) < 0) {/* Nothing to do in a signal handler. */}
+}
+#endif
 
 Q_DECL_EXPORT int main(int argc, char **argv)
 {
+    VoiceCallStartupProfiler *profiler = VoiceCallStartupProfiler::instance();
+    profiler->setup(argc, argv);
+
+    int phase = profiler->begin("application");
     QCoreApplication app(argc, argv);
 
     QCoreApplication::setOrganizationName("nemomobile");
     QCoreApplication::setApplicationName("voicecall");
 
+#ifdef WANT_TRACE
+    // SIGUSR1 dumps the trace buffers; they are dumped on exit as well.
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, traceDumpFds) == 0) {
+        QSocketNotifier *notifier = new QSocketNotifier(traceDumpFds[1], QSocketNotifier::Read, &app);
+        QObject::connect(notifier, &QSocketNotifier::activated, [](int fd) {
+            char c;
+            if (::read(fd, &c, 1) > 0) voicecallTraceDump();
+        });
+        ::signal(SIGUSR1, onTraceDumpSignal);
+    }
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, voicecallTraceDump);
+#endif
+
+    profiler->end(phase);
+
+    phase = profiler->begin("manager");
     VoiceCallManager manager;
+    profiler->end(phase);
+
     BasicVoiceCallConfigurator configurator;
 
+    phase = profiler->begin("configure");
     if (!configurator.configure(&manager)) {
         qFatal("VoiceCall: configurator failed; exiting");
         return -1;
     }
+    profiler->end(phase);
+
+    if (profiler->isEnabled()) {
+        QTimer::singleShot(0, [profiler]() { profiler->mark("event loop running"); });
+        QTimer::singleShot(VOICECALL_PROFILE_SETTLE_TIME, [profiler]() { profiler->finish(); });
+    }
 
     return app.exec();
 }
@@ -5,6 +5,10 @@ CONFIG += link_pkgconfig
 
 INCLUDEPATH += ../lib/src
 
+enable-debug {
+    DEFINES += WANT_TRACE
+}
+
 DEFINES += VOICECALL_PLUGIN_DIRECTORY=\"\\\"$$[QT_INSTALL_LIBS]/voicecall/plugins\\\"\"
 
 enable-nemo-devicelock {
@@ -26,12 +30,24 @@ HEADERS += \
     dbus/voicecallmanagerdbusservice.h \
     basicvoicecallconfigurator.h \
     voicecallmanager.h \
+    voicecallcounters.h \
+    threadedvoicecallprovider.h \
+    threadedvoicecallhandler.h \
+    voicecallpluginmanifest.h \
+    voicecallstartupprofiler.h \
+    voicecallstatetablewriter.h \
     basicringtonenotificationprovider.h
 
 SOURCES += \
     dbus/voicecallmanagerdbusservice.cpp \
     basicvoicecallconfigurator.cpp \
     voicecallmanager.cpp \
+    voicecallcounters.cpp \
+    threadedvoicecallprovider.cpp \
+    threadedvoicecallhandler.cpp \
+    voicecallpluginmanifest.cpp \
+    voicecallstartupprofiler.cpp \
+    voicecallstatetablewriter.cpp \
     main.cpp \
     basicringtonenotificationprovider.cpp
 
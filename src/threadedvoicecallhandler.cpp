@@ -0,0 +1,365 @@
+/*
+ * This file is a part of the Voice Call Manager project
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "common.h"
+#include "threadedvoicecallhandler.h"
+#include "threadedvoicecallprovider.h"
+
+#include <voicecalldurationtracker.h>
+
+class ThreadedVoiceCallHandlerPrivate
+{
+    Q_DECLARE_PUBLIC(ThreadedVoiceCallHandler)
+
+public:
+    ThreadedVoiceCallHandlerPrivate(ThreadedVoiceCallHandler *q, AbstractVoiceCallHandler *s,
+                                    ThreadedVoiceCallProvider *p, ThreadedVoiceCallRelay *r)
+        : q_ptr(q), provider(p), relay(r),
+          handle(s->handle()), lineId(s->lineId()), startedAt(s->startedAt()),
+          duration(s->duration()), isIncoming(s->isIncoming()), isMultiparty(s->isMultiparty()),
+          isEmergency(s->isEmergency()), isForwarded(s->isForwarded()), isRemoteHeld(s->isRemoteHeld()),
+          parentHandlerId(s->parentHandlerId()), status(s->status())
+    {
+        foreach (AbstractVoiceCallHandler *child, s->childCalls())
+            childCallIds.append(child->handlerId());
+    }
+
+    void forward(const char *method, const QVariant &argument = QVariant())
+    {
+        QMetaObject::invokeMethod(relay, "invoke", Qt::QueuedConnection,
+                                  Q_ARG(QString, handle.toString()),
+                                  Q_ARG(QByteArray, QByteArray(method)),
+                                  Q_ARG(QVariant, argument));
+    }
+
+    ThreadedVoiceCallHandler *q_ptr;
+
+    ThreadedVoiceCallProvider *provider;
+    ThreadedVoiceCallRelay *relay;
+
+    VoiceCallHandle handle;
+    QString lineId;
+    QDateTime startedAt;
+    int duration;
+    bool isIncoming;
+    bool isMultiparty;
+    bool isEmergency;
+    bool isForwarded;
+    bool isRemoteHeld;
+    QString parentHandlerId;
+    QStringList childCallIds;
+
+    AbstractVoiceCallHandler::VoiceCallStatus status;
+};
+
+ThreadedVoiceCallHandler::ThreadedVoiceCallHandler(AbstractVoiceCallHandler *subject,
+                                                   ThreadedVoiceCallProvider *provider,
+                                                   ThreadedVoiceCallRelay *relay)
+    : AbstractVoiceCallHandler(), d_ptr(new ThreadedVoiceCallHandlerPrivate(this, subject, provider, relay))
+{
+    TRACE
+    // Queued connections copy the arguments when the subject emits, so the
+    // values seen here are the ones the subject had at that point.
+    QObject::connect(subject, SIGNAL(statusChanged(VoiceCallStatus)),
+                     this, SLOT(onStatusChanged(VoiceCallStatus)), Qt::QueuedConnection);
+    QObject::connect(subject, SIGNAL(lineIdChanged(QString)),
+                     this, SLOT(onLineIdChanged(QString)), Qt::QueuedConnection);
+    QObject::connect(subject, SIGNAL(startedAtChanged(QDateTime)),
+                     this, SLOT(onStartedAtChanged(QDateTime)), Qt::QueuedConnection);
+    QObject::connect(subject, SIGNAL(durationChanged(int)),
+                     this, SLOT(onDurationChanged(int)), Qt::QueuedConnection);
+    QObject::connect(subject, SIGNAL(emergencyChanged(bool)),
+                     this, SLOT(onEmergencyChanged(bool)), Qt::QueuedConnection);
+    QObject::connect(subject, SIGNAL(multipartyChanged(bool)),
+                     this, SLOT(onMultipartyChanged(bool)), Qt::QueuedConnection);
+    QObject::connect(subject, SIGNAL(forwardedChanged(bool)),
+                     this, SLOT(onForwardedChanged(bool)), Qt::QueuedConnection);
+    QObject::connect(subject, SIGNAL(remoteHeldChanged(bool)),
+                     this, SLOT(onRemoteHeldChanged(bool)), Qt::QueuedConnection);
+    QObject::connect(subject, SIGNAL(parentHandlerIdChanged(QString)),
+                     this, SLOT(onParentHandlerIdChanged(QString)), Qt::QueuedConnection);
+}
+
+ThreadedVoiceCallHandler::~ThreadedVoiceCallHandler()
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    delete d;
+}
+
+AbstractVoiceCallProvider* ThreadedVoiceCallHandler::provider() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallHandler);
+    return d->provider;
+}
+
+const VoiceCallHandle& ThreadedVoiceCallHandler::handle() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallHandler);
+    return d->handle;
+}
+
+QString ThreadedVoiceCallHandler::handlerId() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallHandler);
+    return d->handle.toString();
+}
+
+QString ThreadedVoiceCallHandler::lineId() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallHandler);
+    return d->lineId;
+}
+
+QDateTime ThreadedVoiceCallHandler::startedAt() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallHandler);
+    return d->startedAt;
+}
+
+int ThreadedVoiceCallHandler::duration() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallHandler);
+
+    // Providers using the shared tracker have the current value there.
+    VoiceCallDurationTracker *tracker = VoiceCallDurationTracker::instance();
+    if(tracker->duration(d->handle.value()) >= 0) return tracker->seconds(d->handle.value());
+    return d->duration;
+}
+
+bool ThreadedVoiceCallHandler::isIncoming() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallHandler);
+    return d->isIncoming;
+}
+
+bool ThreadedVoiceCallHandler::isMultiparty() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallHandler);
+    return d->isMultiparty;
+}
+
+bool ThreadedVoiceCallHandler::isEmergency() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallHandler);
+    return d->isEmergency;
+}
+
+bool ThreadedVoiceCallHandler::isForwarded() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallHandler);
+    return d->isForwarded;
+}
+
+bool ThreadedVoiceCallHandler::isRemoteHeld() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallHandler);
+    return d->isRemoteHeld;
+}
+
+QString ThreadedVoiceCallHandler::parentHandlerId() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallHandler);
+    return d->parentHandlerId;
+}
+
+QList<AbstractVoiceCallHandler*> ThreadedVoiceCallHandler::childCalls() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallHandler);
+    QList<AbstractVoiceCallHandler*> results;
+
+    foreach (const QString &childCallId, d->childCallIds)
+    {
+        AbstractVoiceCallHandler *child = d->provider->voiceCall(childCallId);
+        if (child) results.append(child);
+    }
+
+    return results;
+}
+
+AbstractVoiceCallHandler::VoiceCallStatus ThreadedVoiceCallHandler::status() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallHandler);
+    return d->status;
+}
+
+void ThreadedVoiceCallHandler::answer()
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->forward("answer");
+}
+
+void ThreadedVoiceCallHandler::hangup()
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->forward("hangup");
+}
+
+void ThreadedVoiceCallHandler::hold(bool on)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->forward("hold", on);
+}
+
+VoiceCallPendingOperation* ThreadedVoiceCallHandler::requestAnswer()
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    return d->provider->forwardRequest(d->handle.toString(), "answer");
+}
+
+VoiceCallPendingOperation* ThreadedVoiceCallHandler::requestHangup()
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    return d->provider->forwardRequest(d->handle.toString(), "hangup");
+}
+
+VoiceCallPendingOperation* ThreadedVoiceCallHandler::requestHold(bool on)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    return d->provider->forwardRequest(d->handle.toString(), "hold", on);
+}
+
+void ThreadedVoiceCallHandler::deflect(const QString &target)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->forward("deflect", target);
+}
+
+void ThreadedVoiceCallHandler::sendDtmf(const QString &tones)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->forward("sendDtmf", tones);
+}
+
+void ThreadedVoiceCallHandler::merge(const QString &callHandle)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->forward("merge", callHandle);
+}
+
+void ThreadedVoiceCallHandler::split()
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->forward("split");
+}
+
+void ThreadedVoiceCallHandler::onStatusChanged(VoiceCallStatus status)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->status = status;
+    emit statusChanged(status);
+}
+
+void ThreadedVoiceCallHandler::onLineIdChanged(const QString &lineId)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->lineId = lineId;
+    emit lineIdChanged(lineId);
+}
+
+void ThreadedVoiceCallHandler::onStartedAtChanged(const QDateTime &startedAt)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->startedAt = startedAt;
+    emit startedAtChanged(startedAt);
+}
+
+void ThreadedVoiceCallHandler::onDurationChanged(int duration)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->duration = duration;
+    emit durationChanged(duration);
+}
+
+void ThreadedVoiceCallHandler::onEmergencyChanged(bool isEmergency)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->isEmergency = isEmergency;
+    emit emergencyChanged(isEmergency);
+}
+
+void ThreadedVoiceCallHandler::onMultipartyChanged(bool isMultiparty)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->isMultiparty = isMultiparty;
+    emit multipartyChanged(isMultiparty);
+}
+
+void ThreadedVoiceCallHandler::onForwardedChanged(bool isForwarded)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->isForwarded = isForwarded;
+    emit forwardedChanged(isForwarded);
+}
+
+void ThreadedVoiceCallHandler::onRemoteHeldChanged(bool isRemoteHeld)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->isRemoteHeld = isRemoteHeld;
+    emit remoteHeldChanged(isRemoteHeld);
+}
+
+void ThreadedVoiceCallHandler::onParentHandlerIdChanged(const QString &parentHandlerId)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->parentHandlerId = parentHandlerId;
+    emit parentHandlerIdChanged(parentHandlerId);
+}
+
+void ThreadedVoiceCallHandler::onChildCallsChanged(const QStringList &childCallIds)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallHandler);
+    d->childCallIds = childCallIds;
+    emit childCallsChanged();
+}
@@ -0,0 +1,93 @@
+/*
+ * This file is a part of the Voice Call Manager project
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef THREADEDVOICECALLHANDLER_H
+#define THREADEDVOICECALLHANDLER_H
+
+#include <abstractvoicecallhandler.h>
+
+class ThreadedVoiceCallProvider;
+class ThreadedVoiceCallRelay;
+
+/*
+ * Main thread stand-in for a handler owned by a provider running in a worker
+ * thread. Property values are copied when the proxy is created and then kept
+ * up to date through queued connections, so reads never touch the subject.
+ * Slots are forwarded to the worker thread through the provider's relay.
+ */
+class ThreadedVoiceCallHandler : public AbstractVoiceCallHandler
+{
+    Q_OBJECT
+
+public:
+    // Must be constructed in the thread of subject.
+    explicit ThreadedVoiceCallHandler(AbstractVoiceCallHandler *subject,
+                                      ThreadedVoiceCallProvider *provider,
+                                      ThreadedVoiceCallRelay *relay);
+            ~ThreadedVoiceCallHandler();
+
+    AbstractVoiceCallProvider* provider() const;
+
+    const VoiceCallHandle& handle() const;
+    QString handlerId() const;
+    QString lineId() const;
+    QDateTime startedAt() const;
+    int duration() const;
+    bool isIncoming() const;
+    bool isMultiparty() const;
+    bool isEmergency() const;
+    bool isForwarded() const;
+    bool isRemoteHeld() const;
+    QString parentHandlerId() const;
+    QList<AbstractVoiceCallHandler*> childCalls() const;
+
+    VoiceCallStatus status() const;
+
+    VoiceCallPendingOperation* requestAnswer();
+    VoiceCallPendingOperation* requestHangup();
+    VoiceCallPendingOperation* requestHold(bool on);
+
+public Q_SLOTS:
+    void answer();
+    void hangup();
+    void hold(bool on);
+    void deflect(const QString &target);
+    void sendDtmf(const QString &tones);
+    void merge(const QString &callHandle);
+    void split();
+
+    void onStatusChanged(VoiceCallStatus status);
+    void onLineIdChanged(const QString &lineId);
+    void onStartedAtChanged(const QDateTime &startedAt);
+    void onDurationChanged(int duration);
+    void onEmergencyChanged(bool isEmergency);
+    void onMultipartyChanged(bool isMultiparty);
+    void onForwardedChanged(bool isForwarded);
+    void onRemoteHeldChanged(bool isRemoteHeld);
+    void onParentHandlerIdChanged(const QString &parentHandlerId);
+    void onChildCallsChanged(const QStringList &childCallIds);
+
+private:
+    class ThreadedVoiceCallHandlerPrivate *d_ptr;
+
+    Q_DECLARE_PRIVATE(ThreadedVoiceCallHandler)
+};
+
+#endif // THREADEDVOICECALLHANDLER_H
@@ -0,0 +1,342 @@
+/*
+ * This file is a part of the Voice Call Manager project
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "common.h"
+#include "threadedvoicecallprovider.h"
+#include "threadedvoicecallhandler.h"
+
+#include <QHash>
+#include <QThread>
+
+class ThreadedVoiceCallProviderPrivate
+{
+    Q_DECLARE_PUBLIC(ThreadedVoiceCallProvider)
+
+public:
+    ThreadedVoiceCallProviderPrivate(ThreadedVoiceCallProvider *q, AbstractVoiceCallProvider *s)
+        : q_ptr(q), relay(NULL),
+          providerId(s->providerId()), providerType(s->providerType()), errorString(s->errorString()),
+          lastOperation(0)
+    { /* ... */ }
+
+    ThreadedVoiceCallProvider *q_ptr;
+
+    ThreadedVoiceCallRelay *relay;
+
+    QString providerId;
+    QString providerType;
+    QString errorString;
+
+    QList<AbstractVoiceCallHandler*> voiceCalls;
+
+    // Requests running in the provider's thread, by id.
+    QHash<qulonglong, QPointer<VoiceCallPendingOperation> > operations;
+    qulonglong lastOperation;
+
+    qulonglong addOperation(VoiceCallPendingOperation *operation)
+    {
+        operations.insert(++lastOperation, operation);
+        return lastOperation;
+    }
+};
+
+ThreadedVoiceCallProvider::ThreadedVoiceCallProvider(AbstractVoiceCallProvider *subject, QThread *target)
+    : AbstractVoiceCallProvider(), d_ptr(new ThreadedVoiceCallProviderPrivate(this, subject))
+{
+    TRACE
+    Q_D(ThreadedVoiceCallProvider);
+    qRegisterMetaType<ThreadedVoiceCallHandler*>("ThreadedVoiceCallHandler*");
+    qRegisterMetaType<AbstractVoiceCallHandler::VoiceCallStatus>("VoiceCallStatus");
+
+    d->relay = new ThreadedVoiceCallRelay(subject, this, target);
+
+    QObject::connect(d->relay, SIGNAL(voiceCallAdded(ThreadedVoiceCallHandler*)),
+                     this, SLOT(onVoiceCallAdded(ThreadedVoiceCallHandler*)), Qt::QueuedConnection);
+    QObject::connect(d->relay, SIGNAL(childCallsChanged(QString,QStringList)),
+                     this, SLOT(onChildCallsChanged(QString,QStringList)), Qt::QueuedConnection);
+    QObject::connect(d->relay, SIGNAL(operationFinished(qulonglong,bool,QString)),
+                     this, SLOT(onOperationFinished(qulonglong,bool,QString)), Qt::QueuedConnection);
+    QObject::connect(d->relay, SIGNAL(error(QString)),
+                     this, SLOT(onError(QString)), Qt::QueuedConnection);
+    QObject::connect(subject, SIGNAL(voiceCallRemoved(QString)),
+                     this, SLOT(onVoiceCallRemoved(QString)), Qt::QueuedConnection);
+    QObject::connect(subject, SIGNAL(voiceCallsChanged()),
+                     this, SIGNAL(voiceCallsChanged()), Qt::QueuedConnection);
+    QObject::connect(subject, SIGNAL(error(QString)),
+                     this, SLOT(onError(QString)), Qt::QueuedConnection);
+
+    foreach (AbstractVoiceCallHandler *handler, subject->voiceCalls())
+    {
+        ThreadedVoiceCallHandler *proxy = d->relay->createProxy(handler);
+        proxy->setParent(this);
+        d->voiceCalls.append(proxy);
+    }
+
+    this->moveToThread(target);
+}
+
+ThreadedVoiceCallProvider::~ThreadedVoiceCallProvider()
+{
+    TRACE
+    Q_D(ThreadedVoiceCallProvider);
+    d->relay->deleteLater();
+    delete d;
+}
+
+QString ThreadedVoiceCallProvider::providerId() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallProvider);
+    return d->providerId;
+}
+
+QString ThreadedVoiceCallProvider::providerType() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallProvider);
+    return d->providerType;
+}
+
+QList<AbstractVoiceCallHandler*> ThreadedVoiceCallProvider::voiceCalls() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallProvider);
+    return d->voiceCalls;
+}
+
+QString ThreadedVoiceCallProvider::errorString() const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallProvider);
+    return d->errorString;
+}
+
+ThreadedVoiceCallHandler* ThreadedVoiceCallProvider::voiceCall(const QString &handlerId) const
+{
+    TRACE
+    Q_D(const ThreadedVoiceCallProvider);
+    quint64 value = VoiceCallHandle::valueOf(handlerId);
+
+    foreach (AbstractVoiceCallHandler *handler, d->voiceCalls)
+    {
+        if (handler->handle().value() == value)
+            return static_cast<ThreadedVoiceCallHandler*>(handler);
+    }
+
+    return NULL;
+}
+
+bool ThreadedVoiceCallProvider::dial(const QString &msisdn)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallProvider);
+    // The outcome is only known in the provider's thread, failures are
+    // reported through error().
+    return QMetaObject::invokeMethod(d->relay, "dial", Qt::QueuedConnection, Q_ARG(QString, msisdn));
+}
+
+VoiceCallPendingOperation* ThreadedVoiceCallProvider::requestDial(const QString &msisdn)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallProvider);
+    VoiceCallPendingOperation *operation = new VoiceCallPendingOperation(this);
+
+    QMetaObject::invokeMethod(d->relay, "requestDial", Qt::QueuedConnection,
+                              Q_ARG(qulonglong, d->addOperation(operation)), Q_ARG(QString, msisdn));
+    return operation;
+}
+
+VoiceCallPendingOperation* ThreadedVoiceCallProvider::forwardRequest(const QString &handlerId, const QByteArray &method,
+                                                                     const QVariant &argument)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallProvider);
+    VoiceCallPendingOperation *operation = new VoiceCallPendingOperation(this);
+
+    QMetaObject::invokeMethod(d->relay, "request", Qt::QueuedConnection,
+                              Q_ARG(qulonglong, d->addOperation(operation)), Q_ARG(QString, handlerId),
+                              Q_ARG(QByteArray, method), Q_ARG(QVariant, argument));
+    return operation;
+}
+
+void ThreadedVoiceCallProvider::onVoiceCallAdded(ThreadedVoiceCallHandler *handler)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallProvider);
+    handler->setParent(this);
+    d->voiceCalls.append(handler);
+    emit voiceCallAdded(handler);
+}
+
+void ThreadedVoiceCallProvider::onVoiceCallRemoved(const QString &handlerId)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallProvider);
+    ThreadedVoiceCallHandler *handler = voiceCall(handlerId);
+    if (!handler) return;
+
+    d->voiceCalls.removeOne(handler);
+    emit voiceCallRemoved(handlerId);
+    handler->deleteLater();
+}
+
+void ThreadedVoiceCallProvider::onChildCallsChanged(const QString &handlerId, const QStringList &childCallIds)
+{
+    TRACE
+    ThreadedVoiceCallHandler *handler = voiceCall(handlerId);
+    if (handler) handler->onChildCallsChanged(childCallIds);
+}
+
+void ThreadedVoiceCallProvider::onError(const QString &errorString)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallProvider);
+    d->errorString = errorString;
+    emit error(errorString);
+}
+
+void ThreadedVoiceCallProvider::onOperationFinished(qulonglong id, bool ok, const QString &errorMessage)
+{
+    TRACE
+    Q_D(ThreadedVoiceCallProvider);
+    VoiceCallPendingOperation *operation = d->operations.take(id);
+    if (!operation) return;
+
+    if (ok)
+        operation->setFinished();
+    else
+        operation->setFinishedWithError(errorMessage);
+}
+
+ThreadedVoiceCallRelay::ThreadedVoiceCallRelay(AbstractVoiceCallProvider *subject,
+                                               ThreadedVoiceCallProvider *proxy, QThread *target)
+    : QObject(), m_subject(subject), m_proxy(proxy), m_target(target)
+{
+    TRACE
+    QObject::connect(subject, SIGNAL(voiceCallAdded(AbstractVoiceCallHandler*)),
+                     this, SLOT(onVoiceCallAdded(AbstractVoiceCallHandler*)));
+}
+
+ThreadedVoiceCallHandler* ThreadedVoiceCallRelay::createProxy(AbstractVoiceCallHandler *handler)
+{
+    TRACE
+    ThreadedVoiceCallHandler *proxy = new ThreadedVoiceCallHandler(handler, m_proxy, this);
+
+    // Child calls are passed by id, the proxy resolves them to their proxies.
+    QObject::connect(handler, &AbstractVoiceCallHandler::childCallsChanged, this, [this, handler]() {
+        QStringList childCallIds;
+        foreach (AbstractVoiceCallHandler *child, handler->childCalls())
+            childCallIds.append(child->handlerId());
+        emit childCallsChanged(handler->handlerId(), childCallIds);
+    });
+
+    return proxy;
+}
+
+void ThreadedVoiceCallRelay::invoke(const QString &handlerId, const QByteArray &method, const QVariant &argument)
+{
+    TRACE
+    AbstractVoiceCallHandler *handler = voiceCall(handlerId);
+    if (!handler)
+    {
+        WARNING_T("Call %s is gone, dropping %s", qPrintable(handlerId), method.constData());
+        return;
+    }
+
+    if (!argument.isValid())
+        QMetaObject::invokeMethod(handler, method.constData());
+    else if (argument.type() == QVariant::Bool)
+        QMetaObject::invokeMethod(handler, method.constData(), Q_ARG(bool, argument.toBool()));
+    else
+        QMetaObject::invokeMethod(handler, method.constData(), Q_ARG(QString, argument.toString()));
+}
+
+void ThreadedVoiceCallRelay::request(qulonglong id, const QString &handlerId, const QByteArray &method, const QVariant &argument)
+{
+    TRACE
+    AbstractVoiceCallHandler *handler = voiceCall(handlerId);
+    if (!handler)
+    {
+        emit operationFinished(id, false, QString("Call %1 is gone").arg(handlerId));
+        return;
+    }
+
+    if (method == "answer")
+        track(id, handler->requestAnswer());
+    else if (method == "hangup")
+        track(id, handler->requestHangup());
+    else if (method == "hold")
+        track(id, handler->requestHold(argument.toBool()));
+    else
+        emit operationFinished(id, false, QString("Unknown request %1").arg(QString::fromLatin1(method)));
+}
+
+void ThreadedVoiceCallRelay::dial(const QString &msisdn)
+{
+    TRACE
+    if (!m_subject) return;
+
+    if (!m_subject->dial(msisdn))
+    {
+        WARNING_T("Failed to dial on provider %s", qPrintable(m_subject->providerId()));
+        emit error(m_subject->errorString());
+    }
+}
+
+void ThreadedVoiceCallRelay::requestDial(qulonglong id, const QString &msisdn)
+{
+    TRACE
+    if (!m_subject)
+    {
+        emit operationFinished(id, false, "The provider is gone");
+        return;
+    }
+
+    track(id, m_subject->requestDial(msisdn));
+}
+
+AbstractVoiceCallHandler* ThreadedVoiceCallRelay::voiceCall(const QString &handlerId) const
+{
+    if (!m_subject) return NULL;
+
+    quint64 value = VoiceCallHandle::valueOf(handlerId);
+    foreach (AbstractVoiceCallHandler *handler, m_subject->voiceCalls())
+    {
+        if (handler->handle().value() == value) return handler;
+    }
+
+    return NULL;
+}
+
+// Reports the outcome of an operation started in this thread to the proxy.
+void ThreadedVoiceCallRelay::track(qulonglong id, VoiceCallPendingOperation *operation)
+{
+    QObject::connect(operation, &VoiceCallPendingOperation::finished, this, [this, id](VoiceCallPendingOperation *operation) {
+        emit operationFinished(id, !operation->isError(), operation->errorMessage());
+    });
+}
+
+void ThreadedVoiceCallRelay::onVoiceCallAdded(AbstractVoiceCallHandler *handler)
+{
+    TRACE
+    ThreadedVoiceCallHandler *proxy = createProxy(handler);
+    proxy->moveToThread(m_target);
+    emit voiceCallAdded(proxy);
+}
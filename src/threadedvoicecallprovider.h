@@ -0,0 +1,117 @@
+/*
+ * This file is a part of the Voice Call Manager project
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef THREADEDVOICECALLPROVIDER_H
+#define THREADEDVOICECALLPROVIDER_H
+
+#include <abstractvoicecallprovider.h>
+
+#include <QPointer>
+
+class ThreadedVoiceCallHandler;
+
+/*
+ * Main thread stand-in for a provider that lives in a worker thread.
+ *
+ * The manager and the other plugins only ever see the proxy: the provider
+ * and handler state they read is a copy owned by the main thread, and calls
+ * into the provider are queued to its thread. The proxy has to be created in
+ * the provider's thread, it moves itself to the target thread once the
+ * current calls have been copied.
+ */
+class ThreadedVoiceCallProvider : public AbstractVoiceCallProvider
+{
+    Q_OBJECT
+
+public:
+    explicit ThreadedVoiceCallProvider(AbstractVoiceCallProvider *subject, QThread *target);
+            ~ThreadedVoiceCallProvider();
+
+    QString providerId() const;
+    QString providerType() const;
+    QList<AbstractVoiceCallHandler*> voiceCalls() const;
+    QString errorString() const;
+
+    ThreadedVoiceCallHandler* voiceCall(const QString &handlerId) const;
+
+    VoiceCallPendingOperation* requestDial(const QString &msisdn);
+
+    // Runs the request method of a call in the provider's thread, and
+    // finishes the returned operation here once that one finishes.
+    VoiceCallPendingOperation* forwardRequest(const QString &handlerId, const QByteArray &method,
+                                              const QVariant &argument = QVariant());
+
+public Q_SLOTS:
+    bool dial(const QString &msisdn);
+
+protected Q_SLOTS:
+    void onVoiceCallAdded(ThreadedVoiceCallHandler *handler);
+    void onVoiceCallRemoved(const QString &handlerId);
+    void onChildCallsChanged(const QString &handlerId, const QStringList &childCallIds);
+    void onError(const QString &errorString);
+    void onOperationFinished(qulonglong id, bool ok, const QString &errorMessage);
+
+private:
+    class ThreadedVoiceCallProviderPrivate *d_ptr;
+
+    Q_DECLARE_PRIVATE(ThreadedVoiceCallProvider)
+};
+
+/*
+ * Worker thread side of ThreadedVoiceCallProvider. Creates handler proxies
+ * as the provider announces calls and runs forwarded calls in the provider's
+ * thread. Handlers are looked up by id when a call arrives, so a handler
+ * that went away in the meantime is simply not found.
+ */
+class ThreadedVoiceCallRelay : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ThreadedVoiceCallRelay(AbstractVoiceCallProvider *subject,
+                                    ThreadedVoiceCallProvider *proxy, QThread *target);
+
+    ThreadedVoiceCallHandler* createProxy(AbstractVoiceCallHandler *handler);
+
+Q_SIGNALS:
+    void voiceCallAdded(ThreadedVoiceCallHandler *handler);
+    void childCallsChanged(const QString &handlerId, const QStringList &childCallIds);
+    void operationFinished(qulonglong id, bool ok, const QString &errorMessage);
+    void error(const QString &errorString);
+
+public Q_SLOTS:
+    void invoke(const QString &handlerId, const QByteArray &method, const QVariant &argument);
+    void request(qulonglong id, const QString &handlerId, const QByteArray &method, const QVariant &argument);
+    void dial(const QString &msisdn);
+    void requestDial(qulonglong id, const QString &msisdn);
+
+protected Q_SLOTS:
+    void onVoiceCallAdded(AbstractVoiceCallHandler *handler);
+
+private:
+    AbstractVoiceCallHandler* voiceCall(const QString &handlerId) const;
+    void track(qulonglong id, VoiceCallPendingOperation *operation);
+
+    QPointer<AbstractVoiceCallProvider> m_subject;
+    ThreadedVoiceCallProvider *m_proxy;
+    QThread *m_target;
+};
+
+#endif // THREADEDVOICECALLPROVIDER_H
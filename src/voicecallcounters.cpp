@@ -0,0 +1,251 @@
+/*
+ * This file is a part of the Voice Call Manager project
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "common.h"
+#include "voicecallcounters.h"
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QTimer>
+
+#include <unistd.h>
+
+// Changes are coalesced for this long before being appended to the journal.
+#define VOICECALL_COUNTERS_FLUSH_DELAY 2000
+
+// Number of journal records after which they are folded back into QSettings.
+#define VOICECALL_COUNTERS_COMPACT_THRESHOLD 32
+
+/*
+ * The counters are kept in memory and written behind:
+ *
+ *  - changes mark the counters dirty and arm a coalescing timer,
+ *  - on timeout (or shutdown) one record holding both absolute totals is
+ *    appended to a small journal next to the settings file,
+ *  - every VOICECALL_COUNTERS_COMPACT_THRESHOLD records the totals are
+ *    written to the "Voice Counters" settings group and the journal truncated.
+ *
+ * Records hold absolute values, so replaying the last complete line after a
+ * crash is idempotent, also when the crash hit between QSettings::sync() and
+ * the truncation.
+ */
+class VoiceCallCountersPrivate
+{
+    Q_DECLARE_PUBLIC(VoiceCallCounters)
+
+public:
+    VoiceCallCountersPrivate(VoiceCallCounters *q)
+        : q_ptr(q), dirty(false), journalEntries(0)
+    {/* ... */}
+
+    VoiceCallCounters *q_ptr;
+
+    QAtomicInt received;
+    QAtomicInt dialled;
+
+    QTimer flushTimer;
+    QString journalPath;
+
+    bool dirty;
+    int journalEntries;
+
+    void load();
+    void markDirty();
+};
+
+void VoiceCallCountersPrivate::load()
+{
+    QSettings settings;
+    journalPath = QFileInfo(settings.fileName()).absolutePath()
+                + QLatin1String("/voicecall-counters.journal");
+
+    settings.beginGroup(QLatin1String("Voice Counters"));
+    received.storeRelease(settings.value(QLatin1String("Received")).toInt());
+    dialled.storeRelease(settings.value(QLatin1String("Dialled")).toInt());
+    settings.endGroup();
+
+    QFile journal(journalPath);
+    if (!journal.open(QIODevice::ReadOnly)) return;
+
+    // Only the last complete record matters, a torn tail is ignored.
+    while (!journal.atEnd())
+    {
+        QByteArray line = journal.readLine();
+        if (!line.endsWith('\n')) break;
+
+        QList<QByteArray> fields = line.trimmed().split(' ');
+        if (fields.count() != 2) continue;
+
+        bool receivedOk = false, dialledOk = false;
+        int r = fields.at(0).toInt(&receivedOk);
+        int d = fields.at(1).toInt(&dialledOk);
+        if (!receivedOk || !dialledOk) continue;
+
+        received.storeRelease(r);
+        dialled.storeRelease(d);
+        ++journalEntries;
+    }
+
+    if (journalEntries > 0)
+    {
+        DEBUG_T("Recovered call counters from journal: received %d, dialled %d",
+                received.loadAcquire(), dialled.loadAcquire());
+    }
+}
+
+void VoiceCallCountersPrivate::markDirty()
+{
+    dirty = true;
+    if (!flushTimer.isActive()) flushTimer.start();
+}
+
+VoiceCallCounters::VoiceCallCounters(QObject *parent)
+    : QObject(parent), d_ptr(new VoiceCallCountersPrivate(this))
+{
+    TRACE
+    Q_D(VoiceCallCounters);
+    d->load();
+
+    // Fold a journal left behind by a previous run back into the settings.
+    if (d->journalEntries > 0) compact();
+
+    d->flushTimer.setSingleShot(true);
+    d->flushTimer.setInterval(VOICECALL_COUNTERS_FLUSH_DELAY);
+    QObject::connect(&d->flushTimer, SIGNAL(timeout()), SLOT(flush()));
+
+    if (QCoreApplication::instance())
+        QObject::connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), SLOT(compact()));
+}
+
+VoiceCallCounters::~VoiceCallCounters()
+{
+    TRACE
+    compact();
+    delete d_ptr;
+}
+
+int VoiceCallCounters::totalOutgoingCallDuration() const
+{
+    Q_D(const VoiceCallCounters);
+    return d->dialled.loadAcquire();
+}
+
+int VoiceCallCounters::totalIncomingCallDuration() const
+{
+    Q_D(const VoiceCallCounters);
+    return d->received.loadAcquire();
+}
+
+void VoiceCallCounters::addOutgoingCallDuration(int seconds)
+{
+    TRACE
+    Q_D(VoiceCallCounters);
+    if (seconds <= 0) return;
+    d->dialled.fetchAndAddOrdered(seconds);
+    d->markDirty();
+}
+
+void VoiceCallCounters::addIncomingCallDuration(int seconds)
+{
+    TRACE
+    Q_D(VoiceCallCounters);
+    if (seconds <= 0) return;
+    d->received.fetchAndAddOrdered(seconds);
+    d->markDirty();
+}
+
+void VoiceCallCounters::reset()
+{
+    TRACE
+    Q_D(VoiceCallCounters);
+    d->received.storeRelease(0);
+    d->dialled.storeRelease(0);
+
+    // A reset is user initiated and rare, persist it right away.
+    d->dirty = true;
+    compact();
+}
+
+void VoiceCallCounters::flush()
+{
+    TRACE
+    Q_D(VoiceCallCounters);
+    d->flushTimer.stop();
+    if (!d->dirty) return;
+
+    QDir().mkpath(QFileInfo(d->journalPath).absolutePath());
+
+    QFile journal(d->journalPath);
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        WARNING_T("Failed to open counter journal %s, writing settings directly.", qPrintable(d->journalPath));
+        compact();
+        return;
+    }
+
+    QByteArray record = QByteArray::number(d->received.loadAcquire())
+                      + ' ' + QByteArray::number(d->dialled.loadAcquire()) + '\n';
+
+    if (journal.write(record) != record.size() || !journal.flush())
+    {
+        WARNING_T("Failed to append to counter journal %s", qPrintable(d->journalPath));
+        journal.close();
+        compact();
+        return;
+    }
+
+    ::fdatasync(journal.handle());
+    journal.close();
+
+    d->dirty = false;
+    if (++d->journalEntries >= VOICECALL_COUNTERS_COMPACT_THRESHOLD) compact();
+}
+
+void VoiceCallCounters::compact()
+{
+    TRACE
+    Q_D(VoiceCallCounters);
+    d->flushTimer.stop();
+    if (!d->dirty && d->journalEntries == 0) return;
+
+    QSettings settings;
+    settings.beginGroup(QLatin1String("Voice Counters"));
+    settings.setValue(QLatin1String("Received"), d->received.loadAcquire());
+    settings.setValue(QLatin1String("Dialled"), d->dialled.loadAcquire());
+    settings.endGroup();
+    settings.sync();
+
+    if (settings.status() != QSettings::NoError)
+    {
+        WARNING_T("Failed to write call counters to %s", qPrintable(settings.fileName()));
+        return;
+    }
+
+    DEBUG_T("Compacted call counters: received %d, dialled %d",
+            d->received.loadAcquire(), d->dialled.loadAcquire());
+
+    QFile::remove(d->journalPath);
+    d->dirty = false;
+    d->journalEntries = 0;
+}
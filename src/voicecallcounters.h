@@ -0,0 +1,52 @@
+/*
+ * This file is a part of the Voice Call Manager project
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef VOICECALLCOUNTERS_H
+#define VOICECALLCOUNTERS_H
+
+#include <QObject>
+
+class VoiceCallCounters : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit VoiceCallCounters(QObject *parent = 0);
+            ~VoiceCallCounters();
+
+    int totalOutgoingCallDuration() const;
+    int totalIncomingCallDuration() const;
+
+    void addOutgoingCallDuration(int seconds);
+    void addIncomingCallDuration(int seconds);
+    void reset();
+
+public Q_SLOTS:
+    void flush();
+    void compact();
+
+private:
+    class VoiceCallCountersPrivate *d_ptr;
+
+    Q_DISABLE_COPY(VoiceCallCounters)
+    Q_DECLARE_PRIVATE(VoiceCallCounters)
+};
+
+#endif // VOICECALLCOUNTERS_H
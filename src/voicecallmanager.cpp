@@ -20,10 +20,17 @@
  */
 #include "common.h"
 #include "voicecallmanager.h"
+#include "voicecallcounters.h"
+#include "voicecallstats.h"
+#include "threadedvoicecallprovider.h"
+#include "voicecallstartupprofiler.h"
 
+#include <QAtomicInt>
+#include <QDateTime>
 #include <QHash>
-#include <QUuid>
-#include <QSettings>
+#include <QMutex>
+#include <QThread>
+#include <QTimer>
 
 #ifdef WITH_NEMO_DEVICELOCK
 #include <nemo-devicelock/devicelock.h>
@@ -33,21 +40,41 @@
 #include "audiocallpolicyproxy.h"
 #endif
 
+// How long the manager waits without calls before going idle.
+#define VOICECALL_IDLE_TIMEOUT 30000
+
 class VoiceCallManagerPrivate
 {
     Q_DECLARE_PUBLIC(VoiceCallManager)
 
 public:
     VoiceCallManagerPrivate(VoiceCallManager *q)
-        : q_ptr(q), activeVoiceCall(NULL),
-          audioMode("earpiece"), isAudioRouted(false), isMicrophoneMuted(false), isSpeakerMuted(false)
+        : q_ptr(q), handleEpoch(quint32(QDateTime::currentMSecsSinceEpoch() / 1000)), activeVoiceCall(NULL),
+          audioMode("earpiece"), isAudioRouted(false), isMicrophoneMuted(false), isSpeakerMuted(false),
+          isIdle(false)
     {/* ... */}
 
     VoiceCallManager *q_ptr;
 
     QHash<QString, AbstractVoiceCallProvider*> providers;
 
-    QHash<QString, AbstractVoiceCallHandler*> voiceCalls;
+    // Providers appended from worker threads, mapped to their main thread
+    // proxies. Written from the worker threads, hence the lock.
+    QMutex threadedProvidersLock;
+    QHash<AbstractVoiceCallProvider*, ThreadedVoiceCallProvider*> threadedProviders;
+
+    quint32 handleEpoch;
+    QAtomicInt handleCounter;
+
+    // Registry of calls known to the manager, maintained incrementally from
+    // onVoiceCallAdded()/onVoiceCallRemoved(). The lists are handed out as
+    // implicitly shared copies, so readers never allocate.
+    QHash<quint64, AbstractVoiceCallHandler*> voiceCalls;
+    QList<AbstractVoiceCallHandler*> voiceCallList;
+
+    // Per-status indexes, kept up to date from each handler's statusChanged().
+    QHash<AbstractVoiceCallHandler*, AbstractVoiceCallHandler::VoiceCallStatus> indexedStatus;
+    QList<AbstractVoiceCallHandler*> statusIndex[AbstractVoiceCallHandler::STATUS_DISCONNECTED + 1];
 
     AbstractVoiceCallHandler *activeVoiceCall;
 
@@ -61,12 +88,140 @@ public:
     bool isSpeakerMuted;
 
     QString errorString;
+
+    VoiceCallCounters counters;
+
+    // Changes made during the current event loop iteration, committed from
+    // a zero timer so every consumer sees them as one delta.
+    VoiceCallChangeSet changes;
+    QTimer commitTimer;
+
+    bool isIdle;
+    QTimer idleTimer;
+
+    void setIdle(bool idle);
+
+    void registerVoiceCall(AbstractVoiceCallHandler *handler);
+    AbstractVoiceCallHandler* unregisterVoiceCall(quint64 handle);
+    void reindexVoiceCall(AbstractVoiceCallHandler *handler);
+
+    void markChanged(VoiceCallChangeSet::ManagerProperties properties);
+    void markCallChanged(AbstractVoiceCallHandler *handler, VoiceCallChangeSet::CallProperties properties);
 };
 
+void VoiceCallManagerPrivate::markChanged(VoiceCallChangeSet::ManagerProperties properties)
+{
+    changes.changeManager(properties);
+    if (!commitTimer.isActive()) commitTimer.start();
+}
+
+void VoiceCallManagerPrivate::markCallChanged(AbstractVoiceCallHandler *handler, VoiceCallChangeSet::CallProperties properties)
+{
+    changes.changeCall(handler, properties);
+    if (!commitTimer.isActive()) commitTimer.start();
+}
+
+void VoiceCallManagerPrivate::setIdle(bool idle)
+{
+    Q_Q(VoiceCallManager);
+    if (!idle) idleTimer.stop();
+    if (isIdle == idle) return;
+
+    DEBUG_T("VCM: %s idle state", idle ? "entering" : "leaving");
+    isIdle = idle;
+    emit q->idleChanged(idle);
+}
+
+void VoiceCallManagerPrivate::registerVoiceCall(AbstractVoiceCallHandler *handler)
+{
+    Q_Q(VoiceCallManager);
+    AbstractVoiceCallHandler::VoiceCallStatus status = handler->status();
+
+    voiceCalls.insert(handler->handle().value(), handler);
+    voiceCallList.append(handler);
+    indexedStatus.insert(handler, status);
+    statusIndex[status].append(handler);
+
+    QObject::connect(handler, SIGNAL(statusChanged(VoiceCallStatus)), q, SLOT(onVoiceCallStatusChanged()));
+
+    QObject::connect(handler, &AbstractVoiceCallHandler::lineIdChanged, q, [this, handler]() {
+        markCallChanged(handler, VoiceCallChangeSet::LineIdProperty);
+    });
+    QObject::connect(handler, &AbstractVoiceCallHandler::startedAtChanged, q, [this, handler]() {
+        markCallChanged(handler, VoiceCallChangeSet::StartedAtProperty);
+    });
+    QObject::connect(handler, &AbstractVoiceCallHandler::durationChanged, q, [this, handler]() {
+        markCallChanged(handler, VoiceCallChangeSet::DurationProperty);
+    });
+    QObject::connect(handler, &AbstractVoiceCallHandler::emergencyChanged, q, [this, handler]() {
+        markCallChanged(handler, VoiceCallChangeSet::EmergencyProperty);
+    });
+    QObject::connect(handler, &AbstractVoiceCallHandler::multipartyChanged, q, [this, handler]() {
+        markCallChanged(handler, VoiceCallChangeSet::MultipartyProperty);
+    });
+    QObject::connect(handler, &AbstractVoiceCallHandler::forwardedChanged, q, [this, handler]() {
+        markCallChanged(handler, VoiceCallChangeSet::ForwardedProperty);
+    });
+    QObject::connect(handler, &AbstractVoiceCallHandler::remoteHeldChanged, q, [this, handler]() {
+        markCallChanged(handler, VoiceCallChangeSet::RemoteHeldProperty);
+    });
+    QObject::connect(handler, &AbstractVoiceCallHandler::parentHandlerIdChanged, q, [this, handler]() {
+        markCallChanged(handler, VoiceCallChangeSet::ParentHandlerIdProperty);
+    });
+    QObject::connect(handler, &AbstractVoiceCallHandler::childCallsChanged, q, [this, handler]() {
+        markCallChanged(handler, VoiceCallChangeSet::ChildCallsProperty);
+    });
+
+    changes.addCall(handler);
+    if (!commitTimer.isActive()) commitTimer.start();
+}
+
+AbstractVoiceCallHandler* VoiceCallManagerPrivate::unregisterVoiceCall(quint64 handle)
+{
+    Q_Q(VoiceCallManager);
+    AbstractVoiceCallHandler *handler = voiceCalls.take(handle);
+    if (!handler) return NULL;
+
+    QObject::disconnect(handler, 0, q, 0);
+
+    voiceCallList.removeOne(handler);
+    statusIndex[indexedStatus.take(handler)].removeOne(handler);
+
+    changes.removeCall(handler);
+    if (!commitTimer.isActive()) commitTimer.start();
+
+    return handler;
+}
+
+void VoiceCallManagerPrivate::reindexVoiceCall(AbstractVoiceCallHandler *handler)
+{
+    QHash<AbstractVoiceCallHandler*, AbstractVoiceCallHandler::VoiceCallStatus>::iterator i = indexedStatus.find(handler);
+    if (i == indexedStatus.end()) return;
+
+    AbstractVoiceCallHandler::VoiceCallStatus status = handler->status();
+    if (i.value() == status) return;
+
+    statusIndex[i.value()].removeOne(handler);
+    statusIndex[status].append(handler);
+    i.value() = status;
+}
+
 VoiceCallManager::VoiceCallManager(QObject *parent)
     : VoiceCallManagerInterface(parent), d_ptr(new VoiceCallManagerPrivate(this))
 {
     TRACE
+    Q_D(VoiceCallManager);
+    qRegisterMetaType<VoiceCallChangeSet>();
+    qRegisterMetaType<AbstractVoiceCallProvider*>("AbstractVoiceCallProvider*");
+
+    d->commitTimer.setSingleShot(true);
+    d->commitTimer.setInterval(0);
+    QObject::connect(&d->commitTimer, SIGNAL(timeout()), SLOT(commitChanges()));
+
+    d->idleTimer.setSingleShot(true);
+    d->idleTimer.setInterval(VOICECALL_IDLE_TIMEOUT);
+    QObject::connect(&d->idleTimer, &QTimer::timeout, this, [d]() { d->setIdle(true); });
+    d->idleTimer.start();
 }
 
 VoiceCallManager::~VoiceCallManager()
@@ -75,6 +230,13 @@ VoiceCallManager::~VoiceCallManager()
     delete d_ptr;
 }
 
+bool VoiceCallManager::isIdle() const
+{
+    TRACE
+    Q_D(const VoiceCallManager);
+    return d->isIdle;
+}
+
 QString VoiceCallManager::errorString() const
 {
     TRACE
@@ -109,6 +271,22 @@ void VoiceCallManager::appendProvider(AbstractVoiceCallProvider *provider)
 {
     TRACE
     Q_D(VoiceCallManager);
+
+    if (QThread::currentThread() != this->thread())
+    {
+        // The proxy has to be created here, in the provider's thread, so it
+        // sees every call announced after this point.
+        ThreadedVoiceCallProvider *proxy = new ThreadedVoiceCallProvider(provider, this->thread());
+        {
+            QMutexLocker locker(&d->threadedProvidersLock);
+            d->threadedProviders.insert(provider, proxy);
+        }
+
+        QMetaObject::invokeMethod(this, "appendProvider", Qt::QueuedConnection,
+                                  Q_ARG(AbstractVoiceCallProvider*, proxy));
+        return;
+    }
+
     if(d->providers.contains(provider->providerId())) return;
 
     DEBUG_T("VCM: Registering voice call provider: %s", qPrintable(provider->providerId()));
@@ -123,6 +301,8 @@ void VoiceCallManager::appendProvider(AbstractVoiceCallProvider *provider)
                      SLOT(setError(QString)));
 
     d->providers.insert(provider->providerId(), provider);
+    VoiceCallStartupProfiler::instance()->mark("provider " + provider->providerId());
+    d->markChanged(VoiceCallChangeSet::ProvidersProperty);
     emit this->providersChanged();
     emit this->providerAdded(provider);
 
@@ -134,6 +314,23 @@ void VoiceCallManager::removeProvider(AbstractVoiceCallProvider *provider)
 {
     TRACE
     Q_D(VoiceCallManager);
+
+    if (QThread::currentThread() != this->thread())
+    {
+        ThreadedVoiceCallProvider *proxy = NULL;
+        {
+            QMutexLocker locker(&d->threadedProvidersLock);
+            proxy = d->threadedProviders.take(provider);
+        }
+
+        if (proxy)
+        {
+            QMetaObject::invokeMethod(this, "removeProvider", Qt::QueuedConnection,
+                                      Q_ARG(AbstractVoiceCallProvider*, proxy));
+        }
+        return;
+    }
+
     if(!d->providers.contains(provider->providerId())) return;
 
     DEBUG_T("VCM: Deregistering voice call provider: %s", qPrintable(provider->providerId()));
@@ -151,43 +348,76 @@ void VoiceCallManager::removeProvider(AbstractVoiceCallProvider *provider)
                         SLOT(setError(QString)));
 
     d->providers.remove(provider->providerId());
+    d->markChanged(VoiceCallChangeSet::ProvidersProperty);
     emit this->providersChanged();
     emit this->providerRemoved(provider->providerId());
+
+    // Calls of a departing provider are no longer reachable through the manager.
+    foreach (AbstractVoiceCallHandler *handler, d->voiceCallList)
+    {
+        if (handler->provider() != provider) continue;
+
+        d->unregisterVoiceCall(handler->handle().value());
+
+        if (d->activeVoiceCall == handler)
+        {
+            d->activeVoiceCall = NULL;
+            d->markChanged(VoiceCallChangeSet::ActiveVoiceCallProperty);
+        }
+    }
+
+    // Proxies are owned by the manager, the provider itself by its plugin.
+    if (qobject_cast<ThreadedVoiceCallProvider*>(provider))
+        provider->deleteLater();
 }
 
-QString VoiceCallManager::generateHandlerId()
+VoiceCallHandle VoiceCallManager::generateHandle()
 {
     TRACE
-    QString handlerId = QUuid::createUuid().toString().mid(1, 36); // Remove curly braces.
-    return handlerId.replace('-', ""); // Remove dashes, (can't have dashes in dbus paths)
+    Q_D(VoiceCallManager);
+    quint32 serial = quint32(d->handleCounter.fetchAndAddOrdered(1) + 1);
+    return VoiceCallHandle((quint64(d->handleEpoch) << 32) | serial);
 }
 
-int VoiceCallManager::voiceCallCount() const
+quint32 VoiceCallManager::handleEpoch() const
 {
     TRACE
     Q_D(const VoiceCallManager);
-    int result = 0;
+    return d->handleEpoch;
+}
 
-    foreach(AbstractVoiceCallProvider *provider, d->providers.values())
-    {
-        result += provider->voiceCalls().length();
-    }
+QString VoiceCallManager::generateHandlerId()
+{
+    TRACE
+    return generateHandle().toString();
+}
 
-    return result;
+int VoiceCallManager::voiceCallCount() const
+{
+    TRACE
+    Q_D(const VoiceCallManager);
+    return d->voiceCallList.count();
 }
 
 QList<AbstractVoiceCallHandler*> VoiceCallManager::voiceCalls() const
 {
     TRACE
     Q_D(const VoiceCallManager);
-    QList<AbstractVoiceCallHandler*> results;
+    return d->voiceCallList;
+}
 
-    foreach(AbstractVoiceCallProvider *provider, d->providers)
-    {
-        results.append(provider->voiceCalls());
-    }
+int VoiceCallManager::voiceCallCount(AbstractVoiceCallHandler::VoiceCallStatus status) const
+{
+    TRACE
+    Q_D(const VoiceCallManager);
+    return d->statusIndex[status].count();
+}
 
-    return results;
+QList<AbstractVoiceCallHandler*> VoiceCallManager::voiceCalls(AbstractVoiceCallHandler::VoiceCallStatus status) const
+{
+    TRACE
+    Q_D(const VoiceCallManager);
+    return d->statusIndex[status];
 }
 
 QString VoiceCallManager::audioMode() const
@@ -224,6 +454,7 @@ void VoiceCallManager::setAudioMode(const QString &mode)
     Q_D(VoiceCallManager);
     d->audioMode = mode;
     emit this->setAudioModeRequested(mode);
+    d->markChanged(VoiceCallChangeSet::AudioModeProperty);
     emit this->audioModeChanged();
 }
 
@@ -233,6 +464,7 @@ void VoiceCallManager::setAudioRouted(bool on)
     Q_D(VoiceCallManager);
     d->isAudioRouted = on;
     emit this->setAudioRoutedRequested(on);
+    d->markChanged(VoiceCallChangeSet::AudioRoutedProperty);
     emit this->audioRoutedChanged();
 }
 
@@ -242,6 +474,7 @@ void VoiceCallManager::setMuteMicrophone(bool on)
     Q_D(VoiceCallManager);
     d->isMicrophoneMuted = on;
     emit this->setMuteMicrophoneRequested(on);
+    d->markChanged(VoiceCallChangeSet::MicrophoneMutedProperty);
     emit this->microphoneMutedChanged();
 }
 
@@ -251,6 +484,7 @@ void VoiceCallManager::setMuteSpeaker(bool on)
     Q_D(VoiceCallManager);
     d->isSpeakerMuted = on;
     emit this->setMuteSpeakerRequested(on);
+    d->markChanged(VoiceCallChangeSet::SpeakerMutedProperty);
     emit this->speakerMutedChanged();
 }
 
@@ -259,6 +493,7 @@ void VoiceCallManager::onAudioModeChanged(const QString &mode)
     TRACE
     Q_D(VoiceCallManager);
     d->audioMode = mode;
+    d->markChanged(VoiceCallChangeSet::AudioModeProperty);
     emit this->audioModeChanged();
 }
 
@@ -267,6 +502,7 @@ void VoiceCallManager::onAudioRoutedChanged(bool on)
     TRACE
     Q_D(VoiceCallManager);
     d->isAudioRouted = on;
+    d->markChanged(VoiceCallChangeSet::AudioRoutedProperty);
     emit this->audioRoutedChanged();
 }
 
@@ -275,6 +511,7 @@ void VoiceCallManager::onMuteMicrophoneChanged(bool on)
     TRACE
     Q_D(VoiceCallManager);
     d->isMicrophoneMuted = on;
+    d->markChanged(VoiceCallChangeSet::MicrophoneMutedProperty);
     emit this->microphoneMutedChanged();
 }
 
@@ -283,6 +520,7 @@ void VoiceCallManager::onMuteSpeakerChanged(bool on)
     TRACE
     Q_D(VoiceCallManager);
     d->isSpeakerMuted = on;
+    d->markChanged(VoiceCallChangeSet::SpeakerMutedProperty);
     emit this->speakerMutedChanged();
 }
 
@@ -298,7 +536,38 @@ bool VoiceCallManager::dial(const QString &providerId, const QString &msisdn)
         return false;
     }
 
-    return provider->dial(msisdn);
+    // Plugins have to be back before the provider reports the new call.
+    d->setIdle(false);
+    bool result = provider->dial(msisdn);
+
+    // Go back to idle eventually should the call never show up.
+    if (d->voiceCallList.isEmpty())
+        d->idleTimer.start();
+
+    return result;
+}
+
+VoiceCallPendingOperation* VoiceCallManager::requestDial(const QString &providerId, const QString &msisdn)
+{
+    TRACE
+    Q_D(VoiceCallManager);
+    AbstractVoiceCallProvider *provider = d->providers.value(providerId);
+
+    if(!provider)
+    {
+        this->setError(QString("*** Unable to find voice call provider with id: ") + providerId);
+        return VoiceCallPendingOperation::completed(false, errorString(), this);
+    }
+
+    // Plugins have to be back before the provider reports the new call.
+    d->setIdle(false);
+    VoiceCallPendingOperation *operation = provider->requestDial(msisdn);
+
+    // Go back to idle eventually should the call never show up.
+    if (d->voiceCallList.isEmpty())
+        d->idleTimer.start();
+
+    return operation;
 }
 
 void VoiceCallManager::silenceRingtone()
@@ -345,16 +614,18 @@ void VoiceCallManager::onVoiceCallAdded(AbstractVoiceCallHandler *handler)
     }
 #endif
 
-    //AudioCallPolicyProxy *pHandler = new AudioCallPolicyProxy(handler, this);
-    d->voiceCalls.insert(handler->handlerId(), handler);
+    if (d->voiceCalls.contains(handler->handle().value())) return;
 
-    emit this->voiceCallAdded(handler);
-    emit this->voiceCallsChanged();
+    d->setIdle(false);
+
+    //AudioCallPolicyProxy *pHandler = new AudioCallPolicyProxy(handler, this);
+    d->registerVoiceCall(handler);
+    VoiceCallStats::instance()->markStage(handler, VoiceCallStats::STAGE_MANAGER_ADDED);
 
     if(!d->activeVoiceCall)
     {
         d->activeVoiceCall = handler;
-        emit this->activeVoiceCallChanged();
+        d->markChanged(VoiceCallChangeSet::ActiveVoiceCallProperty);
     }
 }
 
@@ -362,74 +633,91 @@ void VoiceCallManager::onVoiceCallRemoved(const QString &handlerId)
 {
     TRACE
     Q_D(VoiceCallManager);
-    AbstractVoiceCallHandler *handler = d->voiceCalls.value(handlerId);
+    AbstractVoiceCallHandler *handler = d->unregisterVoiceCall(VoiceCallHandle::valueOf(handlerId));
     if (!handler) {
         DEBUG_T("VCM: attempt to remove unregistered handler: %s", qPrintable(handlerId));
         return;
     }
-    d->voiceCalls.remove(handlerId);
+    VoiceCallStats::instance()->forgetCall(handler->handle().value());
 
-    emit this->voiceCallRemoved(handlerId);
-    emit this->voiceCallsChanged();
-
-    if (d->activeVoiceCall && d->activeVoiceCall->handlerId() == handlerId)
+    if (d->activeVoiceCall == handler)
     {
         d->activeVoiceCall = NULL;
-        emit this->activeVoiceCallChanged();
+        d->markChanged(VoiceCallChangeSet::ActiveVoiceCallProperty);
     }
 
-    QSettings settings;
-    settings.beginGroup(QLatin1String("Voice Counters"));
-
     // Update call time statistics
     if (handler->isIncoming()) {
-        int received = settings.value(QLatin1String("Received")).toInt();
-        received += handler->duration();
-        DEBUG_T("Incoming call ended. Total incoming duration is now %d", received);
-        settings.setValue(QLatin1String("Received"), received);
+        d->counters.addIncomingCallDuration(handler->duration());
+        DEBUG_T("Incoming call ended. Total incoming duration is now %d", d->counters.totalIncomingCallDuration());
         emit totalIncomingCallDurationChanged();
     } else {
-        int dialled = settings.value(QLatin1String("Dialled")).toInt();
-        dialled += handler->duration();
-        DEBUG_T("Outgoing call ended. Total outgoing duration is now %d", dialled);
-        settings.setValue(QLatin1String("Dialled"), dialled);
+        d->counters.addOutgoingCallDuration(handler->duration());
+        DEBUG_T("Outgoing call ended. Total outgoing duration is now %d", d->counters.totalOutgoingCallDuration());
         emit totalOutgoingCallDurationChanged();
     }
 
-    settings.endGroup();
+    // The provider owns the handler and deletes it, the change set no longer
+    // refers to it.
+}
+
+void VoiceCallManager::onVoiceCallStatusChanged()
+{
+    TRACE
+    Q_D(VoiceCallManager);
+    AbstractVoiceCallHandler *handler = qobject_cast<AbstractVoiceCallHandler*>(QObject::sender());
+    if (!handler) return;
 
-    handler->deleteLater();
+    d->reindexVoiceCall(handler);
+    d->markCallChanged(handler, VoiceCallChangeSet::StatusProperty);
+}
+
+void VoiceCallManager::commitChanges()
+{
+    TRACE
+    Q_D(VoiceCallManager);
+    d->commitTimer.stop();
+
+    if (d->changes.isEmpty()) return;
+
+    VoiceCallChangeSet changes = d->changes;
+    d->changes.clear();
+
+    // Additions and removals go out with the rest of the change set, so
+    // voiceCalls() and activeVoiceCall() already match them.
+    foreach (AbstractVoiceCallHandler *handler, changes.addedCalls())
+        emit this->voiceCallAdded(handler);
+    foreach (const VoiceCallHandle &handle, changes.removedCalls())
+        emit this->voiceCallRemoved(handle.toString());
+
+    if (changes.managerProperties() & VoiceCallChangeSet::VoiceCallsProperty)
+        emit this->voiceCallsChanged();
+    if (changes.managerProperties() & VoiceCallChangeSet::ActiveVoiceCallProperty)
+        emit this->activeVoiceCallChanged();
+
+    emit this->changesCommitted(changes);
+
+    if (d->voiceCallList.isEmpty() && !d->isIdle && !d->idleTimer.isActive())
+        d->idleTimer.start();
 }
 
 int VoiceCallManager::totalOutgoingCallDuration() const
 {
-    QSettings settings;
-    settings.beginGroup(QLatin1String("Voice Counters"));
-    int dialled = settings.value(QLatin1String("Dialled")).toInt();
-    DEBUG_T("Request for outgoing call duration. Total: %d", dialled);
-    return dialled;
+    Q_D(const VoiceCallManager);
+    return d->counters.totalOutgoingCallDuration();
 }
 
 int VoiceCallManager::totalIncomingCallDuration() const
 {
-    QSettings settings;
-    settings.beginGroup(QLatin1String("Voice Counters"));
-    int received = settings.value(QLatin1String("Received")).toInt();
-    DEBUG_T("Request for incoming call duration. Total: %d", received);
-    return received;
+    Q_D(const VoiceCallManager);
+    return d->counters.totalIncomingCallDuration();
 }
 
 void VoiceCallManager::resetCallDurationCounters()
 {
-    {
-        QSettings settings;
-        settings.beginGroup(QLatin1String("Voice Counters"));
-        settings.setValue(QLatin1String("Received"), 0);
-        settings.setValue(QLatin1String("Dialled"), 0);
-        settings.endGroup();
-    }
+    Q_D(VoiceCallManager);
+    d->counters.reset();
 
     emit totalOutgoingCallDurationChanged();
     emit totalIncomingCallDurationChanged();
 }
-
@@ -33,11 +33,16 @@ public:
 
     QList<AbstractVoiceCallProvider*> providers() const;
 
+    VoiceCallHandle generateHandle();
+    quint32 handleEpoch() const;
     QString generateHandlerId();
 
     int voiceCallCount() const;
     QList<AbstractVoiceCallHandler*> voiceCalls() const;
 
+    int voiceCallCount(AbstractVoiceCallHandler::VoiceCallStatus status) const;
+    QList<AbstractVoiceCallHandler*> voiceCalls(AbstractVoiceCallHandler::VoiceCallStatus status) const;
+
     AbstractVoiceCallHandler* activeVoiceCall() const;
 
     QString audioMode() const;
@@ -51,9 +56,15 @@ public:
     int totalIncomingCallDuration() const;
     void resetCallDurationCounters();
 
+    bool isIdle() const;
+
+    VoiceCallPendingOperation* requestDial(const QString &providerId, const QString &msisdn);
+
 public Q_SLOTS:
     void setError(const QString &errorString);
 
+    void commitChanges();
+
     void appendProvider(AbstractVoiceCallProvider *provider);
     void removeProvider(AbstractVoiceCallProvider *provider);
 
@@ -80,6 +91,7 @@ public Q_SLOTS:
 protected Q_SLOTS:
     void onVoiceCallAdded(AbstractVoiceCallHandler *handler);
     void onVoiceCallRemoved(const QString &handlerId);
+    void onVoiceCallStatusChanged();
 
 private:
     class VoiceCallManagerPrivate *d_ptr;
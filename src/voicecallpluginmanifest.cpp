@@ -0,0 +1,238 @@
+/*
+ * This file is a part of the Voice Call Manager project
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "common.h"
+#include "voicecallpluginmanifest.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPluginLoader>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+
+// Bump whenever the cache layout changes.
+#define VOICECALL_PLUGIN_MANIFEST_VERSION 1
+
+static QString manifestCachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/plugin-manifest.json";
+}
+
+static QStringList pluginFiles(const QDir &directory)
+{
+    return directory.entryList(QStringList() << "lib*plugin*so", QDir::NoDotAndDotDot | QDir::Files);
+}
+
+static bool readCache(const QDir &directory, QList<VoiceCallPluginInfo> *plugins)
+{
+    QFile file(manifestCachePath());
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QJsonObject cache = QJsonDocument::fromJson(file.readAll()).object();
+    if (cache.value("version").toInt() != VOICECALL_PLUGIN_MANIFEST_VERSION
+            || cache.value("directory").toString() != directory.absolutePath()
+            || cache.value("modified").toDouble() != QFileInfo(directory.absolutePath()).lastModified().toMSecsSinceEpoch())
+        return false;
+
+    foreach (const QJsonValue &value, cache.value("plugins").toArray())
+    {
+        QJsonObject entry = value.toObject();
+        QFileInfo fileInfo(directory.absoluteFilePath(entry.value("file").toString()));
+
+        // A plugin replaced in place leaves the directory untouched.
+        if (!fileInfo.exists()
+                || entry.value("modified").toDouble() != fileInfo.lastModified().toMSecsSinceEpoch()
+                || entry.value("size").toDouble() != fileInfo.size())
+            return false;
+
+        VoiceCallPluginInfo info;
+        info.filePath = fileInfo.absoluteFilePath();
+        info.id = entry.value("id").toString();
+        info.isLazy = entry.value("lazy").toBool();
+        info.isProvider = entry.value("provider").toBool();
+        foreach (const QJsonValue &dependency, entry.value("dependencies").toArray())
+            info.dependencies.append(dependency.toString());
+
+        plugins->append(info);
+    }
+
+    return true;
+}
+
+static void writeCache(const QDir &directory, const QList<VoiceCallPluginInfo> &plugins)
+{
+    QJsonArray entries;
+    foreach (const VoiceCallPluginInfo &info, plugins)
+    {
+        QFileInfo fileInfo(info.filePath);
+        QJsonObject entry;
+        entry.insert("file", fileInfo.fileName());
+        entry.insert("modified", double(fileInfo.lastModified().toMSecsSinceEpoch()));
+        entry.insert("size", double(fileInfo.size()));
+        entry.insert("id", info.id);
+        entry.insert("dependencies", QJsonArray::fromStringList(info.dependencies));
+        entry.insert("lazy", info.isLazy);
+        entry.insert("provider", info.isProvider);
+        entries.append(entry);
+    }
+
+    QJsonObject cache;
+    cache.insert("version", VOICECALL_PLUGIN_MANIFEST_VERSION);
+    cache.insert("directory", directory.absolutePath());
+    cache.insert("modified", double(QFileInfo(directory.absolutePath()).lastModified().toMSecsSinceEpoch()));
+    cache.insert("plugins", entries);
+
+    QString path = manifestCachePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)
+            || file.write(QJsonDocument(cache).toJson(QJsonDocument::Compact)) < 0
+            || !file.commit())
+        WARNING_T("Failed to write plugin manifest cache %s", qPrintable(path));
+}
+
+QList<VoiceCallPluginInfo> VoiceCallPluginManifest::load(const QString &directory)
+{
+    TRACE_STATIC
+    QDir pluginPath(directory);
+    QList<VoiceCallPluginInfo> plugins;
+
+    if (readCache(pluginPath, &plugins))
+    {
+        DEBUG_T("Using cached plugin manifest for %s", qPrintable(pluginPath.absolutePath()));
+        return plugins;
+    }
+    plugins.clear();
+
+    DEBUG_T("Scanning plugins in: %s", qPrintable(pluginPath.absolutePath()));
+    foreach (const QString &plugin, pluginFiles(pluginPath))
+    {
+        // Reads the metadata section without loading the library.
+        QPluginLoader loader(pluginPath.absoluteFilePath(plugin));
+        QJsonObject metaData = loader.metaData();
+        if (metaData.isEmpty())
+        {
+            WARNING_T("Not a plugin: %s", qPrintable(loader.fileName()));
+            continue;
+        }
+
+        QJsonObject data = metaData.value("MetaData").toObject();
+
+        VoiceCallPluginInfo info;
+        info.filePath = pluginPath.absoluteFilePath(plugin);
+        info.id = data.value("id").toString(QFileInfo(plugin).completeBaseName());
+        info.isLazy = data.value("lazy").toBool(false);
+        info.isProvider = data.value("provider").toBool(false);
+        foreach (const QJsonValue &dependency, data.value("dependencies").toArray())
+            info.dependencies.append(dependency.toString());
+
+        plugins.append(info);
+    }
+
+    writeCache(pluginPath, plugins);
+    return plugins;
+}
+
+static bool visitPlugin(const QString &id,
+                        const QHash<QString, VoiceCallPluginInfo> &plugins,
+                        QSet<QString> &visiting, QSet<QString> &visited,
+                        QList<VoiceCallPluginInfo> &result)
+{
+    if (visited.contains(id)) return true;
+    if (visiting.contains(id))
+    {
+        WARNING_T("Plugin dependency cycle through %s", qPrintable(id));
+        return false;
+    }
+
+    visiting.insert(id);
+
+    const VoiceCallPluginInfo &info = plugins[id];
+    bool ok = true;
+    foreach (const QString &dependency, info.dependencies)
+    {
+        // Dependencies outside the manifest, such as the statically linked
+        // plugins, are checked when the plugin is installed.
+        if (plugins.contains(dependency) && !visitPlugin(dependency, plugins, visiting, visited, result))
+            ok = false;
+    }
+
+    visiting.remove(id);
+    if (!ok) return false;
+
+    visited.insert(id);
+    result.append(info);
+    return true;
+}
+
+QList<VoiceCallPluginInfo> VoiceCallPluginManifest::sort(const QList<VoiceCallPluginInfo> &plugins)
+{
+    TRACE_STATIC
+    QHash<QString, VoiceCallPluginInfo> byId;
+    QStringList order;
+
+    foreach (const VoiceCallPluginInfo &info, plugins)
+    {
+        if (byId.contains(info.id))
+        {
+            WARNING_T("Ignoring %s, plugin %s already provided by %s", qPrintable(info.filePath),
+                      qPrintable(info.id), qPrintable(byId.value(info.id).filePath));
+            continue;
+        }
+        byId.insert(info.id, info);
+        order.append(info.id);
+    }
+
+    // Whatever an eager plugin depends on has to be loaded eagerly as well.
+    bool promoted = true;
+    while (promoted)
+    {
+        promoted = false;
+        foreach (const QString &id, order)
+        {
+            if (byId.value(id).isLazy) continue;
+
+            foreach (const QString &dependency, byId.value(id).dependencies)
+            {
+                QHash<QString, VoiceCallPluginInfo>::iterator i = byId.find(dependency);
+                if (i != byId.end() && i->isLazy)
+                {
+                    i->isLazy = false;
+                    promoted = true;
+                }
+            }
+        }
+    }
+
+    QSet<QString> visiting;
+    QSet<QString> visited;
+    QList<VoiceCallPluginInfo> result;
+
+    foreach (const QString &id, order)
+        visitPlugin(id, byId, visiting, visited, result);
+
+    return result;
+}
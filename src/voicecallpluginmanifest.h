@@ -0,0 +1,68 @@
+/*
+ * This file is a part of the Voice Call Manager project
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef VOICECALLPLUGINMANIFEST_H
+#define VOICECALLPLUGINMANIFEST_H
+
+#include <QStringList>
+
+/*
+ * Metadata of a dynamic plugin, from the JSON file compiled into it with
+ * Q_PLUGIN_METADATA:
+ *
+ *   {
+ *       "id": "voicecall-ofono-plugin",
+ *       "dependencies": [],
+ *       "lazy": false,
+ *       "provider": true
+ *   }
+ *
+ * Lazy plugins are loaded once the daemon is up and serving D-Bus. Plugins
+ * without metadata are treated as eager and identified by their file name.
+ */
+struct VoiceCallPluginInfo
+{
+    VoiceCallPluginInfo() : isLazy(false), isProvider(false) {}
+
+    QString filePath;
+    QString id;
+    QStringList dependencies;
+    bool isLazy;
+    bool isProvider;
+};
+
+/*
+ * Lists the plugins of a directory. The result is cached in the user's cache
+ * directory and reused for as long as neither the directory nor any of the
+ * listed files have changed, so a normal start does not have to read the
+ * metadata out of every plugin.
+ */
+class VoiceCallPluginManifest
+{
+public:
+    static QList<VoiceCallPluginInfo> load(const QString &directory);
+
+    // Orders plugins so that dependencies come first and makes anything an
+    // eager plugin depends on eager too. Plugins with duplicate ids or in a
+    // dependency cycle are dropped.
+    static QList<VoiceCallPluginInfo> sort(const QList<VoiceCallPluginInfo> &plugins);
+};
+
+#endif // VOICECALLPLUGINMANIFEST_H
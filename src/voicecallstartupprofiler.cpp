@@ -0,0 +1,281 @@
+/*
+ * This file is a part of the Voice Call Manager project
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "common.h"
+#include "voicecallstartupprofiler.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QSaveFile>
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static qint64 clockMicroseconds(clockid_t clock)
+{
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) return 0;
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+static qint64 residentKilobytes()
+{
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) return 0;
+
+    // size resident shared text lib data dt, in pages
+    QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.count() < 2) return 0;
+
+    return fields.at(1).toLongLong() * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+struct VoiceCallStartupRecord
+{
+    QString name;
+    bool isMark;
+    int depth;
+    qint64 start;
+    qint64 wall;
+    qint64 cpuStart;
+    qint64 cpu;
+    qint64 rssStart;
+    qint64 rssDelta;
+};
+
+class VoiceCallStartupProfilerPrivate
+{
+public:
+    VoiceCallStartupProfilerPrivate()
+        : isEnabled(false), isFinished(false), depth(0), originWall(0), originCpu(0)
+    {/* ... */}
+
+    bool isEnabled;
+    bool isFinished;
+    QString reportPath;
+
+    int depth;
+    qint64 originWall;
+    qint64 originCpu;
+
+    QList<VoiceCallStartupRecord> records;
+
+    void printReport() const;
+    void writeReport() const;
+};
+
+void VoiceCallStartupProfilerPrivate::printReport() const
+{
+    qInfo("Startup profile (CPU time before main: %lld us):", originCpu);
+    foreach (const VoiceCallStartupRecord &record, records)
+    {
+        if (record.isMark)
+        {
+            qInfo("  %*s@ %8.3f ms  %s (rss %lld kB)", record.depth * 2, "",
+                  record.start / 1000.0, qPrintable(record.name), record.rssStart);
+        }
+        else
+        {
+            qInfo("  %*s%-*s wall %8.3f ms  cpu %8.3f ms  rss %+6lld kB", record.depth * 2, "",
+                  40 - record.depth * 2, qPrintable(record.name),
+                  record.wall / 1000.0, record.cpu / 1000.0, record.rssDelta);
+        }
+    }
+}
+
+void VoiceCallStartupProfilerPrivate::writeReport() const
+{
+    QJsonArray phases;
+    QJsonArray marks;
+
+    foreach (const VoiceCallStartupRecord &record, records)
+    {
+        QJsonObject entry;
+        entry.insert("name", record.name);
+        entry.insert("depth", record.depth);
+
+        if (record.isMark)
+        {
+            entry.insert("at_us", double(record.start));
+            entry.insert("rss_kb", double(record.rssStart));
+            marks.append(entry);
+        }
+        else
+        {
+            entry.insert("start_us", double(record.start));
+            entry.insert("wall_us", double(record.wall));
+            entry.insert("cpu_us", double(record.cpu));
+            entry.insert("rss_delta_kb", double(record.rssDelta));
+            phases.append(entry);
+        }
+    }
+
+    QJsonObject report;
+    report.insert("cpu_before_main_us", double(originCpu));
+    report.insert("wall_us", double(clockMicroseconds(CLOCK_MONOTONIC) - originWall));
+    report.insert("cpu_us", double(clockMicroseconds(CLOCK_PROCESS_CPUTIME_ID)));
+    report.insert("rss_kb", double(residentKilobytes()));
+    report.insert("phases", phases);
+    report.insert("marks", marks);
+
+    QSaveFile file(reportPath);
+    if (!file.open(QIODevice::WriteOnly)
+            || file.write(QJsonDocument(report).toJson()) < 0
+            || !file.commit())
+    {
+        WARNING_T("Failed to write startup profile to %s", qPrintable(reportPath));
+        return;
+    }
+
+    qInfo("Startup profile written to %s", qPrintable(reportPath));
+}
+
+VoiceCallStartupProfiler::Phase::Phase(const QString &name)
+    : m_index(VoiceCallStartupProfiler::instance()->begin(name))
+{
+}
+
+VoiceCallStartupProfiler::Phase::~Phase()
+{
+    VoiceCallStartupProfiler::instance()->end(m_index);
+}
+
+VoiceCallStartupProfiler::VoiceCallStartupProfiler()
+    : d_ptr(new VoiceCallStartupProfilerPrivate)
+{
+}
+
+VoiceCallStartupProfiler::~VoiceCallStartupProfiler()
+{
+    delete d_ptr;
+}
+
+VoiceCallStartupProfiler* VoiceCallStartupProfiler::instance()
+{
+    static VoiceCallStartupProfiler profiler;
+    return &profiler;
+}
+
+void VoiceCallStartupProfiler::setup(int &argc, char **argv)
+{
+    Q_D(VoiceCallStartupProfiler);
+
+    QByteArray env = qgetenv("VOICECALL_PROFILE_STARTUP");
+    if (!env.isEmpty() && env != "0")
+    {
+        d->isEnabled = true;
+        if (env != "1") d->reportPath = QString::fromLocal8Bit(env);
+    }
+
+    static const char option[] = "--profile-startup";
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strncmp(argv[i], option, sizeof(option) - 1) != 0) continue;
+
+        const char *value = argv[i] + sizeof(option) - 1;
+        if (*value != '\0' && *value != '=') continue;
+
+        d->isEnabled = true;
+        if (*value == '=') d->reportPath = QString::fromLocal8Bit(value + 1);
+
+        // Keep the option away from QCoreApplication.
+        for (int j = i; j < argc - 1; ++j) argv[j] = argv[j + 1];
+        argv[--argc] = NULL;
+        --i;
+    }
+
+    if (!d->isEnabled) return;
+
+    d->originWall = clockMicroseconds(CLOCK_MONOTONIC);
+    d->originCpu = clockMicroseconds(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+bool VoiceCallStartupProfiler::isEnabled() const
+{
+    Q_D(const VoiceCallStartupProfiler);
+    return d->isEnabled && !d->isFinished;
+}
+
+int VoiceCallStartupProfiler::begin(const QString &name)
+{
+    Q_D(VoiceCallStartupProfiler);
+    if (!isEnabled()) return -1;
+
+    VoiceCallStartupRecord record;
+    record.name = name;
+    record.isMark = false;
+    record.depth = d->depth++;
+    record.start = clockMicroseconds(CLOCK_MONOTONIC) - d->originWall;
+    record.wall = 0;
+    record.cpuStart = clockMicroseconds(CLOCK_PROCESS_CPUTIME_ID);
+    record.cpu = 0;
+    record.rssStart = residentKilobytes();
+    record.rssDelta = 0;
+
+    d->records.append(record);
+    return d->records.count() - 1;
+}
+
+void VoiceCallStartupProfiler::end(int index)
+{
+    Q_D(VoiceCallStartupProfiler);
+    if (index < 0 || index >= d->records.count()) return;
+
+    VoiceCallStartupRecord &record = d->records[index];
+    record.wall = clockMicroseconds(CLOCK_MONOTONIC) - d->originWall - record.start;
+    record.cpu = clockMicroseconds(CLOCK_PROCESS_CPUTIME_ID) - record.cpuStart;
+    record.rssDelta = residentKilobytes() - record.rssStart;
+    --d->depth;
+}
+
+void VoiceCallStartupProfiler::mark(const QString &name)
+{
+    Q_D(VoiceCallStartupProfiler);
+    if (!isEnabled()) return;
+
+    VoiceCallStartupRecord record;
+    record.name = name;
+    record.isMark = true;
+    record.depth = d->depth;
+    record.start = clockMicroseconds(CLOCK_MONOTONIC) - d->originWall;
+    record.wall = record.cpuStart = record.cpu = record.rssDelta = 0;
+    record.rssStart = residentKilobytes();
+
+    d->records.append(record);
+}
+
+void VoiceCallStartupProfiler::finish()
+{
+    Q_D(VoiceCallStartupProfiler);
+    if (!isEnabled()) return;
+
+    d->isFinished = true;
+
+    if (d->reportPath.isEmpty())
+        d->printReport();
+    else
+        d->writeReport();
+
+    d->records.clear();
+}
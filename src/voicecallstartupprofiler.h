@@ -0,0 +1,76 @@
+/*
+ * This file is a part of the Voice Call Manager project
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef VOICECALLSTARTUPPROFILER_H
+#define VOICECALLSTARTUPPROFILER_H
+
+#include <QString>
+
+/*
+ * Startup profiling, enabled with --profile-startup[=report.json] or the
+ * VOICECALL_PROFILE_STARTUP environment variable (1, or a report path).
+ *
+ * Phases are nested scopes; for each one the wall clock time, the process
+ * CPU time and the change in resident set size are recorded. Marks record
+ * one-off events, such as a provider showing up, relative to the start.
+ * The report is printed, or written as JSON when a path was given.
+ *
+ * Only meant to be used from the main thread.
+ */
+class VoiceCallStartupProfiler
+{
+public:
+    class Phase
+    {
+    public:
+        explicit Phase(const QString &name);
+        ~Phase();
+
+    private:
+        int m_index;
+
+        Q_DISABLE_COPY(Phase)
+    };
+
+    static VoiceCallStartupProfiler* instance();
+
+    // Consumes --profile-startup from the arguments, call before QCoreApplication.
+    void setup(int &argc, char **argv);
+
+    bool isEnabled() const;
+
+    // For phases that do not fit a scope; end() takes what begin() returned.
+    int begin(const QString &name);
+    void end(int index);
+
+    void mark(const QString &name);
+    void finish();
+
+private:
+    VoiceCallStartupProfiler();
+   ~VoiceCallStartupProfiler();
+
+    class VoiceCallStartupProfilerPrivate *d_ptr;
+
+    Q_DISABLE_COPY(VoiceCallStartupProfiler)
+    Q_DECLARE_PRIVATE(VoiceCallStartupProfiler)
+};
+
+#endif // VOICECALLSTARTUPPROFILER_H
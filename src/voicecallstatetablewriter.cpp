@@ -0,0 +1,317 @@
+/*
+ * This file is a part of the Voice Call Manager project
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "common.h"
+#include "voicecallstatetablewriter.h"
+
+#include <voicecallmanagerinterface.h>
+#include <voicecallstatetable.h>
+#include <dbus/voicecallhandlerdbusobject.h>
+
+#include <QHash>
+#include <QFile>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <new>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef F_SEAL_FUTURE_WRITE
+#define F_SEAL_FUTURE_WRITE 0x0010 // Linux 5.1
+#endif
+
+class VoiceCallStateTableWriterPrivate
+{
+    Q_DECLARE_PUBLIC(VoiceCallStateTableWriter)
+
+public:
+    VoiceCallStateTableWriterPrivate(VoiceCallStateTableWriter *q, VoiceCallManagerInterface *pManager,
+                                     VoiceCallHandlerDBusObject *pCalls)
+        : q_ptr(q), manager(pManager), calls(pCalls), fd(-1), readOnlyFd(-1), table(NULL)
+    {/* ... */}
+
+    VoiceCallStateTableWriter *q_ptr;
+
+    VoiceCallManagerInterface *manager;
+    VoiceCallHandlerDBusObject *calls;
+
+    int fd;
+    int readOnlyFd;
+    VoiceCallStateTableLayout *table;
+
+    // Call handle -> record index.
+    QHash<quint64, int> records;
+
+    // Calls waiting for a free record, oldest first.
+    QList<AbstractVoiceCallHandler*> pending;
+
+    bool create();
+    bool publishPending();
+
+    void writeRecord(int index, AbstractVoiceCallHandler *handler);
+    void clearRecord(int index);
+    void writeHeader();
+
+    static void beginWrite(std::atomic<quint32> &sequence)
+    {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    static void endWrite(std::atomic<quint32> &sequence)
+    {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+};
+
+bool VoiceCallStateTableWriterPrivate::create()
+{
+    TRACE
+    fd = memfd_create("voicecall-state", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if(fd < 0)
+    {
+        WARNING_T("Failed to create the call state table: %s", strerror(errno));
+        return false;
+    }
+
+    if(ftruncate(fd, sizeof(VoiceCallStateTableLayout)) < 0)
+    {
+        WARNING_T("Failed to size the call state table: %s", strerror(errno));
+        return false;
+    }
+
+    // Clients map the table without checking its size again, so it must not change.
+    if(fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) < 0)
+    {
+        WARNING_T("Failed to seal the call state table: %s", strerror(errno));
+        return false;
+    }
+
+    void *mapping = mmap(NULL, sizeof(VoiceCallStateTableLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(mapping == MAP_FAILED)
+    {
+        WARNING_T("Failed to map the call state table: %s", strerror(errno));
+        return false;
+    }
+
+    // Only the mapping above stays writable: clients could otherwise reopen
+    // their descriptor through /proc read-write and corrupt the table.
+    int seals = F_SEAL_FUTURE_WRITE | F_SEAL_SEAL;
+    if(fcntl(fd, F_ADD_SEALS, seals) < 0 && errno == EINVAL)
+    {
+        // Kernels before 5.1 do not know the seal. The size is still sealed
+        // and clients get a read-only descriptor, but could reopen it writable.
+        WARNING_T("Kernel cannot write-seal the call state table, clients could write to it");
+        seals = F_SEAL_SEAL;
+        fcntl(fd, F_ADD_SEALS, seals);
+    }
+    if((fcntl(fd, F_GET_SEALS) & seals) != seals)
+    {
+        WARNING_T("Failed to write-seal the call state table: %s", strerror(errno));
+        munmap(mapping, sizeof(VoiceCallStateTableLayout));
+        return false;
+    }
+
+    // Hand out a read-only descriptor as well, the seal covers reopening it.
+    readOnlyFd = open(QFile::encodeName(QString("/proc/self/fd/%1").arg(fd)).constData(), O_RDONLY | O_CLOEXEC);
+    if(readOnlyFd < 0)
+    {
+        WARNING_T("Failed to open the call state table read-only: %s", strerror(errno));
+        munmap(mapping, sizeof(VoiceCallStateTableLayout));
+        return false;
+    }
+
+    table = new (mapping) VoiceCallStateTableLayout();
+    table->header.magic = VOICECALL_STATE_TABLE_MAGIC;
+    table->header.version = VOICECALL_STATE_TABLE_VERSION;
+    table->header.recordSize = sizeof(VoiceCallStateRecord);
+    table->header.recordCount = VOICECALL_STATE_TABLE_RECORDS;
+    table->header.writerPid = quint32(getpid());
+    return true;
+}
+
+/*!
+  Moves pending calls into free records, returns true if any was published.
+*/
+bool VoiceCallStateTableWriterPrivate::publishPending()
+{
+    bool published = false;
+    int index = 0;
+
+    while(!pending.isEmpty())
+    {
+        while(index < VOICECALL_STATE_TABLE_RECORDS
+              && (table->records[index].flags & VoiceCallStateRecord::FLAG_IN_USE)) ++index;
+        if(index == VOICECALL_STATE_TABLE_RECORDS) break;
+
+        AbstractVoiceCallHandler *handler = pending.takeFirst();
+        records.insert(handler->handle().value(), index);
+        writeRecord(index, handler);
+        published = true;
+    }
+
+    return published;
+}
+
+void VoiceCallStateTableWriterPrivate::writeRecord(int index, AbstractVoiceCallHandler *handler)
+{
+    VoiceCallStateRecord &record = table->records[index];
+
+    quint32 flags = VoiceCallStateRecord::FLAG_IN_USE;
+    if(handler->isIncoming()) flags |= VoiceCallStateRecord::FLAG_INCOMING;
+    if(handler->isEmergency()) flags |= VoiceCallStateRecord::FLAG_EMERGENCY;
+    if(handler->isMultiparty()) flags |= VoiceCallStateRecord::FLAG_MULTIPARTY;
+    if(handler->isForwarded()) flags |= VoiceCallStateRecord::FLAG_FORWARDED;
+    if(handler->isRemoteHeld()) flags |= VoiceCallStateRecord::FLAG_REMOTE_HELD;
+
+    QByteArray lineId = handler->lineId().toUtf8().left(VOICECALL_STATE_LINE_ID_SIZE - 1);
+
+    beginWrite(record.sequence);
+    record.status = handler->status();
+    record.flags = flags;
+    record.handle = handler->handle().value();
+    record.startedAt = handler->startedAt().toMSecsSinceEpoch();
+    record.connectedAt = calls->connectedAt(handler);
+    record.heldTime = calls->heldTime(handler);
+    memset(record.lineId, 0, sizeof(record.lineId));
+    memcpy(record.lineId, lineId.constData(), lineId.size());
+    endWrite(record.sequence);
+}
+
+void VoiceCallStateTableWriterPrivate::clearRecord(int index)
+{
+    VoiceCallStateRecord &record = table->records[index];
+
+    beginWrite(record.sequence);
+    record.status = AbstractVoiceCallHandler::STATUS_NULL;
+    record.flags = 0;
+    record.handle = 0;
+    endWrite(record.sequence);
+}
+
+void VoiceCallStateTableWriterPrivate::writeHeader()
+{
+    AbstractVoiceCallHandler *active = manager->activeVoiceCall();
+
+    beginWrite(table->header.sequence);
+    table->header.generation++;
+    table->header.activeHandle = active ? active->handle().value() : 0;
+    endWrite(table->header.sequence);
+}
+
+VoiceCallStateTableWriter::VoiceCallStateTableWriter(VoiceCallManagerInterface *manager, VoiceCallHandlerDBusObject *calls,
+                                                     QObject *parent)
+    : QObject(parent), d_ptr(new VoiceCallStateTableWriterPrivate(this, manager, calls))
+{
+    TRACE
+    Q_D(VoiceCallStateTableWriter);
+
+    if(!d->create())
+    {
+        if(d->fd >= 0) close(d->fd);
+        d->fd = -1;
+        return;
+    }
+
+    VoiceCallChangeSet initial;
+    foreach(AbstractVoiceCallHandler *handler, manager->voiceCalls())
+    {
+        initial.addCall(handler);
+    }
+    onChangesCommitted(initial);
+
+    QObject::connect(manager, &VoiceCallManagerInterface::changesCommitted,
+                     this, &VoiceCallStateTableWriter::onChangesCommitted);
+}
+
+VoiceCallStateTableWriter::~VoiceCallStateTableWriter()
+{
+    TRACE
+    Q_D(VoiceCallStateTableWriter);
+    if(d->table)
+    {
+        // Tells readers that see a stuck sequence that nobody will fix it.
+        VoiceCallStateTableWriterPrivate::beginWrite(d->table->header.sequence);
+        d->table->header.writerPid = 0;
+        VoiceCallStateTableWriterPrivate::endWrite(d->table->header.sequence);
+        munmap(d->table, sizeof(VoiceCallStateTableLayout));
+    }
+    if(d->readOnlyFd >= 0) close(d->readOnlyFd);
+    if(d->fd >= 0) close(d->fd);
+    delete d;
+}
+
+bool VoiceCallStateTableWriter::isValid() const
+{
+    Q_D(const VoiceCallStateTableWriter);
+    return d->table != NULL;
+}
+
+int VoiceCallStateTableWriter::fileDescriptor() const
+{
+    Q_D(const VoiceCallStateTableWriter);
+    return d->readOnlyFd;
+}
+
+void VoiceCallStateTableWriter::onChangesCommitted(const VoiceCallChangeSet &changes)
+{
+    TRACE
+    Q_D(VoiceCallStateTableWriter);
+    if(!d->table) return;
+
+    bool changed = false;
+
+    foreach(const VoiceCallHandle &handle, changes.removedCalls())
+    {
+        for(int i = d->pending.count() - 1; i >= 0; --i)
+        {
+            if(d->pending.at(i)->handle() == handle) d->pending.removeAt(i);
+        }
+
+        if(!d->records.contains(handle.value())) continue;
+        d->clearRecord(d->records.take(handle.value()));
+        changed = true;
+    }
+
+    // Calls that find the table full are published once a record is freed.
+    d->pending.append(changes.addedCalls());
+    if(d->publishPending()) changed = true;
+    if(!changes.addedCalls().isEmpty() && !d->pending.isEmpty())
+    {
+        WARNING_T("Call state table is full, %d calls waiting to be published", d->pending.count());
+    }
+
+    QHash<AbstractVoiceCallHandler*, VoiceCallChangeSet::CallProperties>::const_iterator it;
+    for(it = changes.changedCalls().constBegin(); it != changes.changedCalls().constEnd(); ++it)
+    {
+        if(int(it.value()) == VoiceCallChangeSet::DurationProperty) continue;
+        if(!d->records.contains(it.key()->handle().value())) continue;
+
+        d->writeRecord(d->records.value(it.key()->handle().value()), it.key());
+        changed = true;
+    }
+
+    if(changed || (changes.managerProperties() & VoiceCallChangeSet::ActiveVoiceCallProperty))
+    {
+        d->writeHeader();
+    }
+}
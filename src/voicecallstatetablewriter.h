@@ -0,0 +1,64 @@
+/*
+ * This file is a part of the Voice Call Manager project
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef VOICECALLSTATETABLEWRITER_H
+#define VOICECALLSTATETABLEWRITER_H
+
+#include <QObject>
+
+#include <voicecallchangeset.h>
+
+class VoiceCallManagerInterface;
+class VoiceCallHandlerDBusObject;
+
+/*
+ * Publishes the calls of the manager into the shared VoiceCallStateTable.
+ *
+ * The table lives in a sealed memfd; clients get a read-only descriptor to it
+ * and map it themselves. Records are rewritten once per event loop iteration
+ * from the manager's committed changes, duration ticks alone are skipped as
+ * readers derive the duration from connectedAt.
+ */
+class VoiceCallStateTableWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Call timing is read from the object exporting the calls on D-Bus.
+    explicit VoiceCallStateTableWriter(VoiceCallManagerInterface *manager, VoiceCallHandlerDBusObject *calls,
+                                       QObject *parent = 0);
+            ~VoiceCallStateTableWriter();
+
+    bool isValid() const;
+
+    // Read-only descriptor to hand out to clients, owned by the writer.
+    int fileDescriptor() const;
+
+protected Q_SLOTS:
+    void onChangesCommitted(const VoiceCallChangeSet &changes);
+
+private:
+    class VoiceCallStateTableWriterPrivate *d_ptr;
+
+    Q_DISABLE_COPY(VoiceCallStateTableWriter)
+    Q_DECLARE_PRIVATE(VoiceCallStateTableWriter)
+};
+
+#endif // VOICECALLSTATETABLEWRITER_H
@@ -0,0 +1,10 @@
+TEMPLATE = app
+QT = core dbus testlib
+CONFIG += testcase c++11
+CONFIG -= app_bundle
+
+INCLUDEPATH += $$PWD/../lib/src
+LIBS += -L$$PWD/../lib/src -lvoicecall
+
+# So that "make check" runs against the library in the tree.
+QMAKE_RPATHDIR += $$PWD/../lib/src
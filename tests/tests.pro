@@ -0,0 +1,9 @@
+TEMPLATE = subdirs
+SUBDIRS = \
+    tst_voicecalldurationtracker \
+    tst_voicecallpluginmanifest \
+    tst_voicecallproperties \
+    tst_voicecallsequence \
+    tst_voicecallsignalscheduler \
+    tst_voicecallstatemachine \
+    tst_voicecallstatetable
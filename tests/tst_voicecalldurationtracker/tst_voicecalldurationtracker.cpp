@@ -0,0 +1,168 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include <QtTest>
+
+#include "voicecalldurationtracker.h"
+
+// Slack for the scheduler, the tracker itself reads the clock exactly.
+#define TOLERANCE 150
+
+class tst_VoiceCallDurationTracker : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void untracked();
+    void accumulates();
+    void restartKeepsDuration();
+    void forgets();
+    void roundsSeconds();
+    void ticksWhileSubscribed();
+    void unsubscribesDestroyed();
+};
+
+void tst_VoiceCallDurationTracker::untracked()
+{
+    VoiceCallDurationTracker *tracker = VoiceCallDurationTracker::instance();
+
+    QCOMPARE(tracker->duration(1), Q_INT64_C(-1));
+    QCOMPARE(tracker->seconds(1), 0);
+
+    // Stopping an unknown call does not start tracking it.
+    tracker->stop(1);
+    QCOMPARE(tracker->duration(1), Q_INT64_C(-1));
+}
+
+void tst_VoiceCallDurationTracker::accumulates()
+{
+    VoiceCallDurationTracker *tracker = VoiceCallDurationTracker::instance();
+
+    tracker->start(2);
+    QTest::qSleep(200);
+    tracker->stop(2);
+
+    qint64 first = tracker->duration(2);
+    QVERIFY2(first >= 200 && first < 200 + TOLERANCE, qPrintable(QString::number(first)));
+
+    // Held, the duration does not move.
+    QTest::qSleep(100);
+    QCOMPARE(tracker->duration(2), first);
+
+    tracker->start(2);
+    QTest::qSleep(200);
+    qint64 second = tracker->duration(2);
+    QVERIFY2(second >= first + 200 && second < first + 200 + TOLERANCE, qPrintable(QString::number(second)));
+
+    tracker->forget(2);
+}
+
+void tst_VoiceCallDurationTracker::restartKeepsDuration()
+{
+    VoiceCallDurationTracker *tracker = VoiceCallDurationTracker::instance();
+
+    tracker->start(3);
+    QTest::qSleep(200);
+
+    // A second start of a running call changes nothing.
+    tracker->start(3);
+    QVERIFY(tracker->duration(3) >= 200);
+
+    tracker->forget(3);
+}
+
+void tst_VoiceCallDurationTracker::forgets()
+{
+    VoiceCallDurationTracker *tracker = VoiceCallDurationTracker::instance();
+
+    tracker->start(4);
+    tracker->forget(4);
+    QCOMPARE(tracker->duration(4), Q_INT64_C(-1));
+
+    // Starting again counts from zero.
+    tracker->start(4);
+    QVERIFY(tracker->duration(4) < TOLERANCE);
+    tracker->forget(4);
+}
+
+void tst_VoiceCallDurationTracker::roundsSeconds()
+{
+    VoiceCallDurationTracker *tracker = VoiceCallDurationTracker::instance();
+
+    tracker->start(5);
+    QTest::qSleep(600);
+    tracker->stop(5);
+
+    QCOMPARE(tracker->seconds(5), 1);
+    tracker->forget(5);
+}
+
+void tst_VoiceCallDurationTracker::ticksWhileSubscribed()
+{
+    VoiceCallDurationTracker *tracker = VoiceCallDurationTracker::instance();
+    QSignalSpy ticks(tracker, SIGNAL(tick()));
+
+    // Subscribed, but no call is running.
+    QObject consumer;
+    tracker->subscribe(&consumer);
+    QTest::qWait(1100);
+    QCOMPARE(ticks.count(), 0);
+
+    tracker->start(6);
+    QTRY_VERIFY_WITH_TIMEOUT(ticks.count() >= 2, 2500);
+
+    tracker->stop(6);
+    QTest::qWait(100);
+    ticks.clear();
+    QTest::qWait(1100);
+    QCOMPARE(ticks.count(), 0);
+
+    // A call is running, but nobody is listening.
+    tracker->start(6);
+    tracker->unsubscribe(&consumer);
+    QTest::qWait(1100);
+    QCOMPARE(ticks.count(), 0);
+
+    tracker->forget(6);
+}
+
+void tst_VoiceCallDurationTracker::unsubscribesDestroyed()
+{
+    VoiceCallDurationTracker *tracker = VoiceCallDurationTracker::instance();
+    QSignalSpy ticks(tracker, SIGNAL(tick()));
+
+    tracker->start(7);
+    {
+        QObject consumer;
+        tracker->subscribe(&consumer);
+        QTRY_VERIFY_WITH_TIMEOUT(ticks.count() >= 1, 2500);
+    }
+
+    QTest::qWait(100);
+    ticks.clear();
+    QTest::qWait(1100);
+    QCOMPARE(ticks.count(), 0);
+
+    tracker->forget(7);
+}
+
+QTEST_GUILESS_MAIN(tst_VoiceCallDurationTracker)
+
+#include "tst_voicecalldurationtracker.moc"
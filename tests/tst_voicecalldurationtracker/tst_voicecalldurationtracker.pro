@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_voicecalldurationtracker
+
+SOURCES += tst_voicecalldurationtracker.cpp
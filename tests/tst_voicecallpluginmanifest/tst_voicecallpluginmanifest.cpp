@@ -0,0 +1,151 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include <QtTest>
+
+#include "voicecallpluginmanifest.h"
+
+static VoiceCallPluginInfo plugin(const QString &id, const QStringList &dependencies = QStringList(),
+                                  bool isLazy = false)
+{
+    VoiceCallPluginInfo info;
+    info.filePath = QString("/usr/lib/voicecall/plugins/lib%1.so").arg(id);
+    info.id = id;
+    info.dependencies = dependencies;
+    info.isLazy = isLazy;
+    return info;
+}
+
+static QStringList ids(const QList<VoiceCallPluginInfo> &plugins)
+{
+    QStringList result;
+    foreach(const VoiceCallPluginInfo &info, plugins)
+    {
+        result.append(info.id);
+    }
+    return result;
+}
+
+static const VoiceCallPluginInfo *find(const QList<VoiceCallPluginInfo> &plugins, const QString &id)
+{
+    for(int i = 0; i < plugins.count(); ++i)
+    {
+        if(plugins.at(i).id == id) return &plugins.at(i);
+    }
+    return 0;
+}
+
+class tst_VoiceCallPluginManifest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void keepsIndependentOrder();
+    void ordersDependencies();
+    void promotesDependencies();
+    void keepsLazyDependents();
+    void dropsDuplicates();
+    void dropsCycles();
+    void ignoresUnknownDependencies();
+};
+
+void tst_VoiceCallPluginManifest::keepsIndependentOrder()
+{
+    QList<VoiceCallPluginInfo> plugins;
+    plugins << plugin("ofono") << plugin("ngf") << plugin("mce");
+
+    QCOMPARE(ids(VoiceCallPluginManifest::sort(plugins)), QStringList() << "ofono" << "ngf" << "mce");
+}
+
+void tst_VoiceCallPluginManifest::ordersDependencies()
+{
+    QList<VoiceCallPluginInfo> plugins;
+    plugins << plugin("ui", QStringList() << "ngf" << "audio")
+            << plugin("ngf", QStringList() << "audio")
+            << plugin("audio");
+
+    QCOMPARE(ids(VoiceCallPluginManifest::sort(plugins)), QStringList() << "audio" << "ngf" << "ui");
+}
+
+void tst_VoiceCallPluginManifest::promotesDependencies()
+{
+    QList<VoiceCallPluginInfo> plugins;
+    plugins << plugin("ofono", QStringList() << "audio")
+            << plugin("audio", QStringList() << "policy", true)
+            << plugin("policy", QStringList(), true)
+            << plugin("ngf", QStringList(), true);
+
+    QList<VoiceCallPluginInfo> sorted = VoiceCallPluginManifest::sort(plugins);
+    QCOMPARE(ids(sorted), QStringList() << "policy" << "audio" << "ofono" << "ngf");
+
+    // Promoted through the lazy plugin in between.
+    QVERIFY(!find(sorted, "audio")->isLazy);
+    QVERIFY(!find(sorted, "policy")->isLazy);
+    QVERIFY(find(sorted, "ngf")->isLazy);
+}
+
+void tst_VoiceCallPluginManifest::keepsLazyDependents()
+{
+    QList<VoiceCallPluginInfo> plugins;
+    plugins << plugin("ngf", QStringList() << "ofono", true)
+            << plugin("ofono");
+
+    QList<VoiceCallPluginInfo> sorted = VoiceCallPluginManifest::sort(plugins);
+    QCOMPARE(ids(sorted), QStringList() << "ofono" << "ngf");
+    QVERIFY(find(sorted, "ngf")->isLazy);
+    QVERIFY(!find(sorted, "ofono")->isLazy);
+}
+
+void tst_VoiceCallPluginManifest::dropsDuplicates()
+{
+    VoiceCallPluginInfo first = plugin("ofono");
+    VoiceCallPluginInfo second = plugin("ofono");
+    second.filePath = "/usr/lib/voicecall/plugins/libofono2.so";
+
+    QList<VoiceCallPluginInfo> sorted = VoiceCallPluginManifest::sort(QList<VoiceCallPluginInfo>() << first << second);
+    QCOMPARE(sorted.count(), 1);
+    QCOMPARE(sorted.first().filePath, first.filePath);
+}
+
+void tst_VoiceCallPluginManifest::dropsCycles()
+{
+    QList<VoiceCallPluginInfo> plugins;
+    plugins << plugin("a", QStringList() << "b")
+            << plugin("b", QStringList() << "a")
+            << plugin("c", QStringList() << "a")
+            << plugin("self", QStringList() << "self")
+            << plugin("d");
+
+    // Anything depending on a cycle goes with it.
+    QCOMPARE(ids(VoiceCallPluginManifest::sort(plugins)), QStringList() << "d");
+}
+
+void tst_VoiceCallPluginManifest::ignoresUnknownDependencies()
+{
+    QList<VoiceCallPluginInfo> plugins;
+    plugins << plugin("ngf", QStringList() << "voicecall-playback-manager-plugin")
+            << plugin("mce");
+
+    QCOMPARE(ids(VoiceCallPluginManifest::sort(plugins)), QStringList() << "ngf" << "mce");
+}
+
+QTEST_GUILESS_MAIN(tst_VoiceCallPluginManifest)
+
+#include "tst_voicecallpluginmanifest.moc"
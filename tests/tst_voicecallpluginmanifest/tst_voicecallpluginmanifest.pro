@@ -0,0 +1,13 @@
+include(../tests.pri)
+
+TARGET = tst_voicecallpluginmanifest
+
+# The manifest is part of the daemon, build it in.
+INCLUDEPATH += ../../src
+
+HEADERS += \
+    ../../src/voicecallpluginmanifest.h
+
+SOURCES += \
+    tst_voicecallpluginmanifest.cpp \
+    ../../src/voicecallpluginmanifest.cpp
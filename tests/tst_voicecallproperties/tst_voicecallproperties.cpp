@@ -0,0 +1,303 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include <QtTest>
+#include <QDir>
+#include <QDBusServer>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusMetaType>
+
+#include "voicecallhandle.h"
+#include "dbus/voicecallproperties.h"
+#include "dbus/voicecalldbustypes.h"
+
+#define TEST_INTERFACE "org.nemomobile.voicecall.Test"
+#define TEST_CONNECTION "tst_voicecallproperties"
+
+// Calls in the benchmark payloads, as many as a large conference has.
+#define TEST_CALL_COUNT 16
+
+// A struct of the next version, which adds a field at the end.
+struct FutureCallProperties
+{
+    VoiceCallProperties properties;
+    QString extra;
+};
+
+Q_DECLARE_METATYPE(FutureCallProperties)
+
+QDBusArgument &operator<<(QDBusArgument &argument, const FutureCallProperties &future)
+{
+    const VoiceCallProperties &properties = future.properties;
+    argument.beginStructure();
+    argument << uint(VoiceCallProperties::Version + 1)
+             << properties.handlerId
+             << properties.providerId
+             << properties.status
+             << properties.statusText
+             << properties.lineId
+             << properties.startedAt
+             << properties.duration
+             << properties.connectedAt
+             << properties.heldTime
+             << properties.isIncoming
+             << properties.isEmergency
+             << properties.isMultiparty
+             << properties.isForwarded
+             << properties.isRemoteHeld
+             << properties.parentHandlerId
+             << properties.childCalls
+             << future.extra;
+    argument.endStructure();
+    return argument;
+}
+
+// Only sent by the test, never read.
+const QDBusArgument &operator>>(const QDBusArgument &argument, FutureCallProperties &)
+{
+    return argument;
+}
+
+static VoiceCallProperties testCall(int index)
+{
+    VoiceCallProperties call;
+    call.handlerId = VoiceCallHandle(Q_UINT64_C(0x5e8f3a2000000000) + index + 1).toString();
+    call.providerId = "telepathy-ring/tel/ril_0";
+    call.status = 2;
+    call.statusText = "active";
+    call.lineId = QString("+35850123%1").arg(index, 4, 10, QLatin1Char('0'));
+    call.startedAt = Q_INT64_C(1586000000000) + index;
+    call.duration = 61 + index;
+    call.connectedAt = Q_INT64_C(123456789) + index;
+    call.heldTime = 2500;
+    call.isIncoming = index % 2;
+    call.isEmergency = false;
+    call.isMultiparty = true;
+    call.isForwarded = index % 3 == 0;
+    call.isRemoteHeld = false;
+    call.parentHandlerId = VoiceCallHandle(Q_UINT64_C(0x5e8f3a2000000000)).toString();
+    return call;
+}
+
+static void compareCalls(const VoiceCallProperties &actual, const VoiceCallProperties &expected)
+{
+    QCOMPARE(actual.version, expected.version);
+    QCOMPARE(actual.handlerId, expected.handlerId);
+    QCOMPARE(actual.providerId, expected.providerId);
+    QCOMPARE(actual.status, expected.status);
+    QCOMPARE(actual.statusText, expected.statusText);
+    QCOMPARE(actual.lineId, expected.lineId);
+    QCOMPARE(actual.startedAt, expected.startedAt);
+    QCOMPARE(actual.duration, expected.duration);
+    QCOMPARE(actual.connectedAt, expected.connectedAt);
+    QCOMPARE(actual.heldTime, expected.heldTime);
+    QCOMPARE(actual.isIncoming, expected.isIncoming);
+    QCOMPARE(actual.isEmergency, expected.isEmergency);
+    QCOMPARE(actual.isMultiparty, expected.isMultiparty);
+    QCOMPARE(actual.isForwarded, expected.isForwarded);
+    QCOMPARE(actual.isRemoteHeld, expected.isRemoteHeld);
+    QCOMPARE(actual.parentHandlerId, expected.parentHandlerId);
+    QCOMPARE(actual.childCalls, expected.childCalls);
+}
+
+/*
+ * Serves the calls over a peer connection, in both forms, like the manager does.
+ */
+class CallServer : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.nemomobile.voicecall.Test")
+
+public:
+    VoiceCallPropertiesList calls;
+
+public Q_SLOTS:
+    VoiceCallPropertiesList GetCallList()
+    {
+        return calls;
+    }
+
+    VoiceCallPropertiesMap GetCalls()
+    {
+        VoiceCallPropertiesMap results;
+        foreach(const VoiceCallProperties &call, calls)
+        {
+            results.insert(call.handlerId, call.toMap());
+        }
+        return results;
+    }
+
+    FutureCallProperties GetFutureCall()
+    {
+        FutureCallProperties future;
+        future.properties = calls.first();
+        future.extra = "extra";
+        return future;
+    }
+};
+
+class tst_VoiceCallProperties : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void mapRoundTrip();
+    void structRoundTrip();
+    void unknownVersion();
+
+    void encodeStruct();
+    void encodeMap();
+    void decodeStruct();
+    void decodeMap();
+
+private:
+    QDBusMessage call(const QString &member);
+
+    QDBusServer *m_server;
+    bool m_registered;
+    CallServer m_object;
+};
+
+void tst_VoiceCallProperties::initTestCase()
+{
+    qDBusRegisterMetaType<VoiceCallProperties>();
+    qDBusRegisterMetaType<VoiceCallPropertiesList>();
+    qDBusRegisterMetaType<VoiceCallPropertiesMap>();
+    qDBusRegisterMetaType<FutureCallProperties>();
+
+    for(int i = 0; i < TEST_CALL_COUNT; ++i)
+    {
+        m_object.calls.append(testCall(i));
+        if(i) m_object.calls[0].childCalls.append(m_object.calls.last().handlerId);
+    }
+
+    m_registered = false;
+    m_server = new QDBusServer("unix:tmpdir=" + QDir::tempPath(), this);
+    QVERIFY(m_server->isConnected());
+    QObject::connect(m_server, &QDBusServer::newConnection, this, [this](const QDBusConnection &peer) {
+        QDBusConnection connection(peer);
+        m_registered = connection.registerObject("/", &m_object, QDBusConnection::ExportAllSlots);
+    });
+
+    QVERIFY(QDBusConnection::connectToPeer(m_server->address(), TEST_CONNECTION).isConnected());
+    QTRY_VERIFY(m_registered);
+}
+
+void tst_VoiceCallProperties::cleanupTestCase()
+{
+    QDBusConnection::disconnectFromPeer(TEST_CONNECTION);
+}
+
+QDBusMessage tst_VoiceCallProperties::call(const QString &member)
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(QString(), "/", TEST_INTERFACE, member);
+
+    // Both ends live in this thread, keep its event loop running while waiting.
+    return QDBusConnection(TEST_CONNECTION).call(message, QDBus::BlockWithGui);
+}
+
+void tst_VoiceCallProperties::mapRoundTrip()
+{
+    foreach(const VoiceCallProperties &expected, m_object.calls)
+    {
+        VoiceCallProperties actual = VoiceCallProperties::fromMap(expected.toMap());
+        QVERIFY(actual.isValid());
+        compareCalls(actual, expected);
+    }
+}
+
+void tst_VoiceCallProperties::structRoundTrip()
+{
+    QDBusMessage reply = call("GetCallList");
+    QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+    QCOMPARE(reply.signature(), QString("a" VOICECALL_PROPERTIES_SIGNATURE));
+
+    VoiceCallPropertiesList calls = qdbus_cast<VoiceCallPropertiesList>(reply.arguments().at(0));
+    QCOMPARE(calls.count(), m_object.calls.count());
+
+    for(int i = 0; i < calls.count(); ++i)
+    {
+        QVERIFY(calls.at(i).isValid());
+        compareCalls(calls.at(i), m_object.calls.at(i));
+    }
+}
+
+void tst_VoiceCallProperties::unknownVersion()
+{
+    QDBusMessage reply = call("GetFutureCall");
+    QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+
+    VoiceCallProperties properties = qdbus_cast<VoiceCallProperties>(reply.arguments().at(0));
+    QCOMPARE(properties.version, uint(VoiceCallProperties::Version + 1));
+    QVERIFY(!properties.isValid());
+    QVERIFY(properties.handlerId.isEmpty());
+    QVERIFY(properties.childCalls.isEmpty());
+}
+
+void tst_VoiceCallProperties::encodeStruct()
+{
+    QBENCHMARK {
+        QDBusArgument argument;
+        argument << m_object.calls;
+    }
+}
+
+void tst_VoiceCallProperties::encodeMap()
+{
+    QBENCHMARK {
+        QDBusArgument argument;
+        argument << m_object.GetCalls();
+    }
+}
+
+// A QDBusArgument can only be read from a received message, so decoding is
+// measured as a whole call over the peer connection, which adds the same
+// transport cost to both forms, and the encoding measured above.
+void tst_VoiceCallProperties::decodeStruct()
+{
+    QBENCHMARK {
+        QDBusMessage reply = call("GetCallList");
+        VoiceCallPropertiesList calls = qdbus_cast<VoiceCallPropertiesList>(reply.arguments().at(0));
+        QCOMPARE(calls.count(), TEST_CALL_COUNT);
+    }
+}
+
+void tst_VoiceCallProperties::decodeMap()
+{
+    QBENCHMARK {
+        QDBusMessage reply = call("GetCalls");
+        VoiceCallPropertiesMap map = qdbus_cast<VoiceCallPropertiesMap>(reply.arguments().at(0));
+
+        VoiceCallPropertiesList calls;
+        for(VoiceCallPropertiesMap::const_iterator it = map.constBegin(); it != map.constEnd(); ++it)
+        {
+            calls.append(VoiceCallProperties::fromMap(it.value()));
+        }
+        QCOMPARE(calls.count(), TEST_CALL_COUNT);
+    }
+}
+
+QTEST_GUILESS_MAIN(tst_VoiceCallProperties)
+
+#include "tst_voicecallproperties.moc"
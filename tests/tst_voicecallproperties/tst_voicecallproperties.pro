@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_voicecallproperties
+
+SOURCES += tst_voicecallproperties.cpp
@@ -0,0 +1,133 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include <QtTest>
+
+#include "voicecallsequence.h"
+
+// Sequence numbers of two daemon instances, as started at different times.
+static qulonglong sequence(quint32 epoch, quint32 serial)
+{
+    return (qulonglong(epoch) << 32) | serial;
+}
+
+#define FIRST_EPOCH 0x5e8f3a20
+#define SECOND_EPOCH 0x5e8f3b07
+
+class tst_VoiceCallSequence : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void resyncsWithoutSnapshot();
+    void appliesNextChange();
+    void ignoresKnownChanges();
+    void resyncsOnGap();
+    void resyncsOnRestart_data();
+    void resyncsOnRestart();
+    void resyncsAfterReset();
+    void startsFromEpoch();
+};
+
+void tst_VoiceCallSequence::resyncsWithoutSnapshot()
+{
+    VoiceCallSequence calls;
+    QCOMPARE(calls.generation(), qulonglong(0));
+    QCOMPARE(calls.check(sequence(FIRST_EPOCH, 1)), VoiceCallSequence::Resync);
+    QCOMPARE(calls.generation(), qulonglong(0));
+}
+
+void tst_VoiceCallSequence::appliesNextChange()
+{
+    VoiceCallSequence calls;
+    calls.reset(sequence(FIRST_EPOCH, 5));
+
+    QCOMPARE(calls.check(sequence(FIRST_EPOCH, 6)), VoiceCallSequence::Apply);
+    QCOMPARE(calls.generation(), sequence(FIRST_EPOCH, 6));
+    QCOMPARE(calls.check(sequence(FIRST_EPOCH, 7)), VoiceCallSequence::Apply);
+    QCOMPARE(calls.generation(), sequence(FIRST_EPOCH, 7));
+}
+
+void tst_VoiceCallSequence::ignoresKnownChanges()
+{
+    VoiceCallSequence calls;
+    calls.reset(sequence(FIRST_EPOCH, 5));
+
+    // Signals sent before the snapshot was taken, delivered after it.
+    QCOMPARE(calls.check(sequence(FIRST_EPOCH, 5)), VoiceCallSequence::Ignore);
+    QCOMPARE(calls.check(sequence(FIRST_EPOCH, 2)), VoiceCallSequence::Ignore);
+    QCOMPARE(calls.generation(), sequence(FIRST_EPOCH, 5));
+}
+
+void tst_VoiceCallSequence::resyncsOnGap()
+{
+    VoiceCallSequence calls;
+    calls.reset(sequence(FIRST_EPOCH, 5));
+
+    QCOMPARE(calls.check(sequence(FIRST_EPOCH, 7)), VoiceCallSequence::Resync);
+    QCOMPARE(calls.generation(), sequence(FIRST_EPOCH, 5));
+}
+
+void tst_VoiceCallSequence::resyncsOnRestart_data()
+{
+    QTest::addColumn<qulonglong>("snapshot");
+    QTest::addColumn<qulonglong>("change");
+
+    QTest::newRow("restarted") << sequence(FIRST_EPOCH, 5) << sequence(SECOND_EPOCH, 1);
+    QTest::newRow("restarted, same count") << sequence(FIRST_EPOCH, 5) << sequence(SECOND_EPOCH, 6);
+    QTest::newRow("older instance") << sequence(SECOND_EPOCH, 5) << sequence(FIRST_EPOCH, 6);
+    QTest::newRow("restarted, no changes") << sequence(FIRST_EPOCH, 0) << sequence(SECOND_EPOCH, 1);
+}
+
+void tst_VoiceCallSequence::resyncsOnRestart()
+{
+    QFETCH(qulonglong, snapshot);
+    QFETCH(qulonglong, change);
+
+    VoiceCallSequence calls;
+    calls.reset(snapshot);
+
+    QCOMPARE(calls.check(change), VoiceCallSequence::Resync);
+    QCOMPARE(calls.generation(), snapshot);
+}
+
+void tst_VoiceCallSequence::resyncsAfterReset()
+{
+    VoiceCallSequence calls;
+    calls.reset(sequence(FIRST_EPOCH, 5));
+    QCOMPARE(calls.check(sequence(FIRST_EPOCH, 6)), VoiceCallSequence::Apply);
+
+    // As done when the daemon went away.
+    calls.reset();
+    QCOMPARE(calls.check(sequence(FIRST_EPOCH, 7)), VoiceCallSequence::Resync);
+
+    calls.reset(sequence(SECOND_EPOCH, 0));
+    QCOMPARE(calls.check(sequence(SECOND_EPOCH, 1)), VoiceCallSequence::Apply);
+}
+
+void tst_VoiceCallSequence::startsFromEpoch()
+{
+    QCOMPARE(VoiceCallSequence::instanceOf(sequence(FIRST_EPOCH, 42)), quint32(FIRST_EPOCH));
+    QCOMPARE(VoiceCallSequence::instanceOf(sequence(SECOND_EPOCH, 0xffffffff)), quint32(SECOND_EPOCH));
+}
+
+QTEST_GUILESS_MAIN(tst_VoiceCallSequence)
+
+#include "tst_voicecallsequence.moc"
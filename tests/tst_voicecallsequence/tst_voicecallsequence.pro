@@ -0,0 +1,8 @@
+include(../tests.pri)
+
+TARGET = tst_voicecallsequence
+
+# VoiceCallSequence is part of the QML plugin, header only.
+INCLUDEPATH += ../../plugins/declarative/src
+
+SOURCES += tst_voicecallsequence.cpp
@@ -0,0 +1,283 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include <QtTest>
+#include <QDir>
+#include <QDBusServer>
+#include <QDBusConnection>
+#include <QDBusMessage>
+
+#include "dbus/voicecallsignalscheduler.h"
+
+#define MANAGER_INTERFACE "org.nemomobile.voicecall.VoiceCallManager"
+#define CALL_INTERFACE "org.nemomobile.voicecall.VoiceCall"
+#define PROPERTIES_INTERFACE "org.freedesktop.DBus.Properties"
+
+#define CALL_PATH "/calls/5e8f3a2000000001"
+#define OTHER_CALL_PATH "/calls/5e8f3a2000000002"
+
+// VOICECALL_PEER_MAX_QUEUE of the scheduler.
+#define MAX_QUEUE 512
+
+static QDBusMessage propertiesChanged(const QString &path, const QVariantMap &changed,
+                                      const QStringList &invalidated = QStringList())
+{
+    QDBusMessage message = QDBusMessage::createSignal(path, PROPERTIES_INTERFACE, "PropertiesChanged");
+    message << QString(CALL_INTERFACE) << changed << invalidated;
+    return message;
+}
+
+static QDBusMessage statusChanged(const QString &path, int status)
+{
+    QDBusMessage message = QDBusMessage::createSignal(path, CALL_INTERFACE, "statusChanged");
+    message << status << QString();
+    return message;
+}
+
+static QDBusMessage callAdded(qulonglong sequence)
+{
+    QDBusMessage message = QDBusMessage::createSignal("/", MANAGER_INTERFACE, "CallAdded");
+    message << sequence << QString::number(sequence) << QVariantMap();
+    return message;
+}
+
+/*
+ * Each test gets a fresh peer connection: the daemon's end is served by
+ * m_server and named m_peer, the client's end receives into m_received.
+ */
+class tst_VoiceCallSignalScheduler : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void sendsSeparately();
+    void mergesPropertiesChanged();
+    void replacesState();
+    void keepsEvents();
+    void keepsOrder();
+    void reportsQueues();
+    void disconnectsBacklog();
+
+    void onSignal(const QDBusMessage &message);
+
+private:
+    QVariantMap queue() const;
+
+    QDBusServer *m_server;
+    QString m_peer;
+    QString m_client;
+    int m_clients;
+    QList<QDBusMessage> m_received;
+};
+
+void tst_VoiceCallSignalScheduler::initTestCase()
+{
+    m_clients = 0;
+    m_server = new QDBusServer("unix:tmpdir=" + QDir::tempPath(), this);
+    QVERIFY(m_server->isConnected());
+    QObject::connect(m_server, &QDBusServer::newConnection, this, [this](const QDBusConnection &peer) {
+        m_peer = peer.name();
+    });
+}
+
+void tst_VoiceCallSignalScheduler::init()
+{
+    m_peer.clear();
+    m_received.clear();
+    m_client = QString("tst_voicecallsignalscheduler_%1").arg(++m_clients);
+
+    QDBusConnection client = QDBusConnection::connectToPeer(m_server->address(), m_client);
+    QVERIFY(client.isConnected());
+    QVERIFY(client.connect(QString(), QString(), PROPERTIES_INTERFACE, "PropertiesChanged",
+                           this, SLOT(onSignal(QDBusMessage))));
+    QVERIFY(client.connect(QString(), QString(), CALL_INTERFACE, "statusChanged",
+                           this, SLOT(onSignal(QDBusMessage))));
+    QVERIFY(client.connect(QString(), QString(), MANAGER_INTERFACE, "CallAdded",
+                           this, SLOT(onSignal(QDBusMessage))));
+
+    QTRY_VERIFY(!m_peer.isEmpty());
+}
+
+void tst_VoiceCallSignalScheduler::cleanup()
+{
+    VoiceCallSignalScheduler::instance()->removeConnection(m_peer);
+    QDBusConnection::disconnectFromPeer(m_peer);
+    QDBusConnection::disconnectFromPeer(m_client);
+}
+
+void tst_VoiceCallSignalScheduler::onSignal(const QDBusMessage &message)
+{
+    m_received.append(message);
+}
+
+QVariantMap tst_VoiceCallSignalScheduler::queue() const
+{
+    return VoiceCallSignalScheduler::instance()->queues().value(m_peer).toMap();
+}
+
+void tst_VoiceCallSignalScheduler::sendsSeparately()
+{
+    VoiceCallSignalScheduler *scheduler = VoiceCallSignalScheduler::instance();
+
+    // Different objects and members do not replace each other.
+    scheduler->send(m_peer, statusChanged(CALL_PATH, 1));
+    scheduler->send(m_peer, statusChanged(OTHER_CALL_PATH, 2));
+    scheduler->send(m_peer, propertiesChanged(CALL_PATH, QVariantMap()));
+
+    QTRY_COMPARE(m_received.count(), 3);
+    QCOMPARE(m_received.at(0).path(), QString(CALL_PATH));
+    QCOMPARE(m_received.at(1).path(), QString(OTHER_CALL_PATH));
+    QCOMPARE(m_received.at(2).member(), QString("PropertiesChanged"));
+}
+
+void tst_VoiceCallSignalScheduler::mergesPropertiesChanged()
+{
+    VoiceCallSignalScheduler *scheduler = VoiceCallSignalScheduler::instance();
+
+    QVariantMap first;
+    first.insert("status", 1);
+    first.insert("lineId", "+358501234567");
+    scheduler->send(m_peer, propertiesChanged(CALL_PATH, first, QStringList() << "duration"));
+
+    QVariantMap second;
+    second.insert("status", 3);
+    second.insert("duration", 5);
+    scheduler->send(m_peer, propertiesChanged(CALL_PATH, second, QStringList() << "lineId"));
+
+    QTRY_COMPARE(m_received.count(), 1);
+    QTest::qWait(100);
+    QCOMPARE(m_received.count(), 1);
+
+    QVariantList arguments = m_received.first().arguments();
+    QCOMPARE(arguments.count(), 3);
+    QCOMPARE(arguments.at(0).toString(), QString(CALL_INTERFACE));
+
+    QVariantMap changed = qdbus_cast<QVariantMap>(arguments.at(1));
+    QCOMPARE(changed.count(), 2);
+    QCOMPARE(changed.value("status").toInt(), 3);
+    QCOMPARE(changed.value("duration").toInt(), 5);
+    QCOMPARE(arguments.at(2).toStringList(), QStringList() << "lineId");
+}
+
+void tst_VoiceCallSignalScheduler::replacesState()
+{
+    VoiceCallSignalScheduler *scheduler = VoiceCallSignalScheduler::instance();
+
+    for(int status = 1; status <= 5; ++status)
+    {
+        scheduler->send(m_peer, statusChanged(CALL_PATH, status));
+    }
+
+    QTRY_COMPARE(m_received.count(), 1);
+    QTest::qWait(100);
+    QCOMPARE(m_received.count(), 1);
+    QCOMPARE(m_received.first().arguments().at(0).toInt(), 5);
+}
+
+void tst_VoiceCallSignalScheduler::keepsEvents()
+{
+    VoiceCallSignalScheduler *scheduler = VoiceCallSignalScheduler::instance();
+
+    for(qulonglong sequence = 1; sequence <= 5; ++sequence)
+    {
+        scheduler->send(m_peer, callAdded(sequence));
+    }
+
+    QTRY_COMPARE(m_received.count(), 5);
+    for(int i = 0; i < m_received.count(); ++i)
+    {
+        QCOMPARE(m_received.at(i).arguments().at(0).toULongLong(), qulonglong(i + 1));
+    }
+}
+
+void tst_VoiceCallSignalScheduler::keepsOrder()
+{
+    VoiceCallSignalScheduler *scheduler = VoiceCallSignalScheduler::instance();
+
+    // A replaced signal moves behind the signals sent before its replacement.
+    scheduler->send(m_peer, statusChanged(CALL_PATH, 1));
+    scheduler->send(m_peer, callAdded(1));
+    scheduler->send(m_peer, statusChanged(CALL_PATH, 2));
+    scheduler->send(m_peer, callAdded(2));
+
+    QTRY_COMPARE(m_received.count(), 3);
+    QCOMPARE(m_received.at(0).member(), QString("CallAdded"));
+    QCOMPARE(m_received.at(0).arguments().at(0).toULongLong(), qulonglong(1));
+    QCOMPARE(m_received.at(1).member(), QString("statusChanged"));
+    QCOMPARE(m_received.at(1).arguments().at(0).toInt(), 2);
+    QCOMPARE(m_received.at(2).member(), QString("CallAdded"));
+    QCOMPARE(m_received.at(2).arguments().at(0).toULongLong(), qulonglong(2));
+}
+
+void tst_VoiceCallSignalScheduler::reportsQueues()
+{
+    VoiceCallSignalScheduler *scheduler = VoiceCallSignalScheduler::instance();
+
+    scheduler->send(m_peer, statusChanged(CALL_PATH, 1));
+    scheduler->send(m_peer, statusChanged(CALL_PATH, 2));
+    scheduler->send(m_peer, callAdded(1));
+    scheduler->send(m_peer, callAdded(2));
+
+    // Nothing is sent before the event loop runs.
+    QVariantMap depths = queue();
+    QCOMPARE(depths.value("depth").toInt(), 3);
+    QCOMPARE(depths.value("maxDepth").toInt(), 3);
+    QCOMPARE(depths.value("coalesced").toULongLong(), Q_UINT64_C(1));
+    QCOMPARE(depths.value("sent").toULongLong(), Q_UINT64_C(0));
+
+    QTRY_COMPARE(m_received.count(), 3);
+    depths = queue();
+    QCOMPARE(depths.value("depth").toInt(), 0);
+    QCOMPARE(depths.value("maxDepth").toInt(), 3);
+    QCOMPARE(depths.value("sent").toULongLong(), Q_UINT64_C(3));
+    QCOMPARE(depths.value("stalled").toBool(), false);
+}
+
+void tst_VoiceCallSignalScheduler::disconnectsBacklog()
+{
+    VoiceCallSignalScheduler *scheduler = VoiceCallSignalScheduler::instance();
+
+    // State signals are replaced, they never fill the queue.
+    for(int status = 0; status < 2 * MAX_QUEUE; ++status)
+    {
+        scheduler->send(m_peer, statusChanged(CALL_PATH, status));
+    }
+    QVERIFY(QDBusConnection(m_peer).isConnected());
+    QCOMPARE(queue().value("depth").toInt(), 1);
+
+    // Events are not, the peer is dropped once too many are held back.
+    int sent = 0;
+    while(sent < 2 * MAX_QUEUE && QDBusConnection(m_peer).isConnected())
+    {
+        scheduler->send(m_peer, callAdded(++sent));
+    }
+
+    QCOMPARE(sent, MAX_QUEUE);
+    QVERIFY(!scheduler->queues().contains(m_peer));
+    QTRY_VERIFY(!QDBusConnection(m_client).isConnected());
+}
+
+QTEST_GUILESS_MAIN(tst_VoiceCallSignalScheduler)
+
+#include "tst_voicecallsignalscheduler.moc"
@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_voicecallsignalscheduler
+
+SOURCES += tst_voicecallsignalscheduler.cpp
@@ -0,0 +1,170 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include <QtTest>
+
+#include "voicecallstatemachine.h"
+
+typedef VoiceCallStateMachine::Status Status;
+typedef VoiceCallStateMachine::Transition Transition;
+
+Q_DECLARE_METATYPE(Status)
+Q_DECLARE_METATYPE(Transition)
+
+class tst_VoiceCallStateMachine : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void transition_data();
+    void transition();
+
+    void appliesTransitions();
+    void rejectsForbidden();
+    void runsHooks();
+    void statusText();
+};
+
+void tst_VoiceCallStateMachine::transition_data()
+{
+    QTest::addColumn<Status>("from");
+    QTest::addColumn<Status>("to");
+    QTest::addColumn<Transition>("expected");
+
+    const Transition A = VoiceCallStateMachine::TRANSITION_ALLOWED;
+    const Transition U = VoiceCallStateMachine::TRANSITION_UNEXPECTED;
+    const Transition F = VoiceCallStateMachine::TRANSITION_FORBIDDEN;
+
+    QTest::newRow("null -> dialing") << AbstractVoiceCallHandler::STATUS_NULL << AbstractVoiceCallHandler::STATUS_DIALING << A;
+    QTest::newRow("null -> incoming") << AbstractVoiceCallHandler::STATUS_NULL << AbstractVoiceCallHandler::STATUS_INCOMING << A;
+    QTest::newRow("dialing -> alerting") << AbstractVoiceCallHandler::STATUS_DIALING << AbstractVoiceCallHandler::STATUS_ALERTING << A;
+    QTest::newRow("alerting -> active") << AbstractVoiceCallHandler::STATUS_ALERTING << AbstractVoiceCallHandler::STATUS_ACTIVE << A;
+    QTest::newRow("active -> held") << AbstractVoiceCallHandler::STATUS_ACTIVE << AbstractVoiceCallHandler::STATUS_HELD << A;
+    QTest::newRow("held -> active") << AbstractVoiceCallHandler::STATUS_HELD << AbstractVoiceCallHandler::STATUS_ACTIVE << A;
+    QTest::newRow("incoming -> waiting") << AbstractVoiceCallHandler::STATUS_INCOMING << AbstractVoiceCallHandler::STATUS_WAITING << A;
+    QTest::newRow("waiting -> active") << AbstractVoiceCallHandler::STATUS_WAITING << AbstractVoiceCallHandler::STATUS_ACTIVE << A;
+    QTest::newRow("alerting -> disconnected") << AbstractVoiceCallHandler::STATUS_ALERTING << AbstractVoiceCallHandler::STATUS_DISCONNECTED << A;
+    QTest::newRow("disconnected -> null") << AbstractVoiceCallHandler::STATUS_DISCONNECTED << AbstractVoiceCallHandler::STATUS_NULL << A;
+
+    QTest::newRow("active -> dialing") << AbstractVoiceCallHandler::STATUS_ACTIVE << AbstractVoiceCallHandler::STATUS_DIALING << U;
+    QTest::newRow("dialing -> held") << AbstractVoiceCallHandler::STATUS_DIALING << AbstractVoiceCallHandler::STATUS_HELD << U;
+    QTest::newRow("alerting -> dialing") << AbstractVoiceCallHandler::STATUS_ALERTING << AbstractVoiceCallHandler::STATUS_DIALING << U;
+    QTest::newRow("incoming -> held") << AbstractVoiceCallHandler::STATUS_INCOMING << AbstractVoiceCallHandler::STATUS_HELD << U;
+
+    QTest::newRow("disconnected -> active") << AbstractVoiceCallHandler::STATUS_DISCONNECTED << AbstractVoiceCallHandler::STATUS_ACTIVE << F;
+    QTest::newRow("disconnected -> incoming") << AbstractVoiceCallHandler::STATUS_DISCONNECTED << AbstractVoiceCallHandler::STATUS_INCOMING << F;
+    QTest::newRow("out of range") << AbstractVoiceCallHandler::STATUS_ACTIVE << Status(AbstractVoiceCallHandler::STATUS_DISCONNECTED + 1) << F;
+}
+
+void tst_VoiceCallStateMachine::transition()
+{
+    QFETCH(Status, from);
+    QFETCH(Status, to);
+    QFETCH(Transition, expected);
+
+    QCOMPARE(VoiceCallStateMachine::transition(from, to), expected);
+}
+
+void tst_VoiceCallStateMachine::appliesTransitions()
+{
+    VoiceCallStateMachine machine;
+    QCOMPARE(machine.status(), AbstractVoiceCallHandler::STATUS_NULL);
+
+    QVERIFY(machine.setStatus(AbstractVoiceCallHandler::STATUS_DIALING));
+    QVERIFY(!machine.setStatus(AbstractVoiceCallHandler::STATUS_DIALING));
+    QCOMPARE(machine.status(), AbstractVoiceCallHandler::STATUS_DIALING);
+
+    // Unexpected transitions are still applied.
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("Unexpected call status transition dialing -> held"));
+    QVERIFY(machine.setStatus(AbstractVoiceCallHandler::STATUS_HELD));
+    QCOMPARE(machine.status(), AbstractVoiceCallHandler::STATUS_HELD);
+    QVERIFY(machine.isOngoing());
+    QCOMPARE(machine.statusText(), QString("held"));
+}
+
+void tst_VoiceCallStateMachine::rejectsForbidden()
+{
+    VoiceCallStateMachine machine;
+    QVERIFY(machine.setStatus(AbstractVoiceCallHandler::STATUS_ACTIVE));
+    QVERIFY(machine.setStatus(AbstractVoiceCallHandler::STATUS_DISCONNECTED));
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("Rejected call status transition disconnected -> active"));
+    QVERIFY(!machine.setStatus(AbstractVoiceCallHandler::STATUS_ACTIVE));
+    QCOMPARE(machine.status(), AbstractVoiceCallHandler::STATUS_DISCONNECTED);
+
+    // Handlers are still torn down through null.
+    QVERIFY(machine.setStatus(AbstractVoiceCallHandler::STATUS_NULL));
+}
+
+void tst_VoiceCallStateMachine::runsHooks()
+{
+    VoiceCallStateMachine machine;
+    QStringList hooks;
+
+    machine.setHook(VoiceCallStateMachine::HOOK_RINGING_START, [&hooks](Status, Status) { hooks << "ringing-start"; });
+    machine.setHook(VoiceCallStateMachine::HOOK_RINGING_STOP, [&hooks](Status, Status) { hooks << "ringing-stop"; });
+    machine.setHook(VoiceCallStateMachine::HOOK_DURATION_START, [&hooks](Status, Status) { hooks << "duration-start"; });
+    machine.setHook(VoiceCallStateMachine::HOOK_DURATION_STOP, [&hooks](Status from, Status to) {
+        hooks << QString("duration-stop %1 -> %2").arg(VoiceCallStateMachine::statusText(from),
+                                                        VoiceCallStateMachine::statusText(to));
+    });
+
+    machine.setStatus(AbstractVoiceCallHandler::STATUS_INCOMING);
+    QCOMPARE(hooks, QStringList() << "ringing-start");
+
+    // Only the groups of states are hooked, not the moves within them.
+    machine.setStatus(AbstractVoiceCallHandler::STATUS_WAITING);
+    QCOMPARE(hooks.count(), 1);
+
+    hooks.clear();
+    machine.setStatus(AbstractVoiceCallHandler::STATUS_ACTIVE);
+    QCOMPARE(hooks, QStringList() << "ringing-stop" << "duration-start");
+
+    hooks.clear();
+    machine.setStatus(AbstractVoiceCallHandler::STATUS_HELD);
+    machine.setStatus(AbstractVoiceCallHandler::STATUS_ACTIVE);
+    QVERIFY(hooks.isEmpty());
+
+    machine.setStatus(AbstractVoiceCallHandler::STATUS_DISCONNECTED);
+    QCOMPARE(hooks, QStringList() << "duration-stop active -> disconnected");
+
+    // A rejected transition runs nothing.
+    hooks.clear();
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("Rejected call status transition"));
+    machine.setStatus(AbstractVoiceCallHandler::STATUS_INCOMING);
+    QVERIFY(hooks.isEmpty());
+}
+
+void tst_VoiceCallStateMachine::statusText()
+{
+    for(int i = AbstractVoiceCallHandler::STATUS_ACTIVE; i <= AbstractVoiceCallHandler::STATUS_DISCONNECTED; ++i)
+    {
+        Status status = Status(i);
+        QCOMPARE(VoiceCallStateMachine::statusFromText(VoiceCallStateMachine::statusText(status)), status);
+    }
+
+    QCOMPARE(VoiceCallStateMachine::statusText(AbstractVoiceCallHandler::STATUS_NULL), QString("null"));
+    QCOMPARE(VoiceCallStateMachine::statusText(Status(42)), QString("null"));
+    QCOMPARE(VoiceCallStateMachine::statusFromText("ringing"), AbstractVoiceCallHandler::STATUS_NULL);
+}
+
+QTEST_GUILESS_MAIN(tst_VoiceCallStateMachine)
+
+#include "tst_voicecallstatemachine.moc"
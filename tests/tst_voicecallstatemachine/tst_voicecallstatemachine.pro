@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_voicecallstatemachine
+
+SOURCES += tst_voicecallstatemachine.cpp
@@ -0,0 +1,494 @@
+/*
+ * This file is a part of the Voice Call Manager Plugin project.
+ *
+ * Copyright (c) 2020 Open Mobile Platform LLC.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include <QtTest>
+#include <QFile>
+
+#include "voicecallmanagerinterface.h"
+#include "voicecallstatetable.h"
+#include "voicecallstatetablewriter.h"
+#include "dbus/voicecallhandlerdbusobject.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef F_SEAL_FUTURE_WRITE
+#define F_SEAL_FUTURE_WRITE 0x0010 // Linux 5.1
+#endif
+
+#define TEST_EPOCH Q_UINT64_C(0x5e8f3a2000000000)
+
+class TestCall : public AbstractVoiceCallHandler
+{
+public:
+    explicit TestCall(int serial, QObject *parent = 0)
+        : AbstractVoiceCallHandler(parent), m_handle(TEST_EPOCH + serial),
+          m_status(STATUS_DIALING), m_incoming(false), m_emergency(false),
+          m_startedAt(QDateTime::fromMSecsSinceEpoch(Q_INT64_C(1586000000000) + serial))
+    {
+        m_lineId = QString("+35850123%1").arg(serial, 4, 10, QLatin1Char('0'));
+    }
+
+    AbstractVoiceCallProvider* provider() const { return NULL; }
+
+    const VoiceCallHandle& handle() const { return m_handle; }
+    QString handlerId() const { return m_handle.toString(); }
+    QString lineId() const { return m_lineId; }
+    QDateTime startedAt() const { return m_startedAt; }
+    int duration() const { return 0; }
+    bool isIncoming() const { return m_incoming; }
+    bool isMultiparty() const { return false; }
+    bool isEmergency() const { return m_emergency; }
+    bool isForwarded() const { return false; }
+    bool isRemoteHeld() const { return false; }
+    QString parentHandlerId() const { return QString(); }
+    QList<AbstractVoiceCallHandler*> childCalls() const { return QList<AbstractVoiceCallHandler*>(); }
+
+    VoiceCallStatus status() const { return m_status; }
+
+    void answer() {}
+    void hangup() {}
+    void hold(bool) {}
+    void deflect(const QString &) {}
+    void sendDtmf(const QString &) {}
+    void merge(const QString &) {}
+    void split() {}
+
+    VoiceCallHandle m_handle;
+    VoiceCallStatus m_status;
+    QString m_lineId;
+    bool m_incoming;
+    bool m_emergency;
+    QDateTime m_startedAt;
+};
+
+/*
+ * Holds the calls, the test commits its changes to the writer itself.
+ */
+class TestManager : public VoiceCallManagerInterface
+{
+public:
+    TestManager() : m_active(NULL) {}
+
+    QList<AbstractVoiceCallProvider*> providers() const { return QList<AbstractVoiceCallProvider*>(); }
+
+    VoiceCallHandle generateHandle() { return VoiceCallHandle(); }
+    quint32 handleEpoch() const { return quint32(TEST_EPOCH >> 32); }
+    QString generateHandlerId() { return QString(); }
+
+    int voiceCallCount() const { return m_calls.count(); }
+    QList<AbstractVoiceCallHandler*> voiceCalls() const { return m_calls; }
+
+    int voiceCallCount(AbstractVoiceCallHandler::VoiceCallStatus status) const { return voiceCalls(status).count(); }
+    QList<AbstractVoiceCallHandler*> voiceCalls(AbstractVoiceCallHandler::VoiceCallStatus status) const
+    {
+        QList<AbstractVoiceCallHandler*> results;
+        foreach(AbstractVoiceCallHandler *handler, m_calls)
+        {
+            if(handler->status() == status) results.append(handler);
+        }
+        return results;
+    }
+
+    AbstractVoiceCallHandler* activeVoiceCall() const { return m_active; }
+
+    QString audioMode() const { return QString(); }
+    bool isAudioRouted() const { return false; }
+    bool isMicrophoneMuted() const { return false; }
+    bool isSpeakerMuted() const { return false; }
+
+    QString errorString() const { return QString(); }
+
+    int totalOutgoingCallDuration() const { return 0; }
+    int totalIncomingCallDuration() const { return 0; }
+    void resetCallDurationCounters() {}
+
+    bool isIdle() const { return m_calls.isEmpty(); }
+
+    VoiceCallPendingOperation* requestDial(const QString &, const QString &) { return NULL; }
+
+    void setError(const QString &) {}
+    void commitChanges() {}
+    void appendProvider(AbstractVoiceCallProvider *) {}
+    void removeProvider(AbstractVoiceCallProvider *) {}
+    bool dial(const QString &, const QString &) { return false; }
+    void silenceRingtone() {}
+    void setAudioMode(const QString &) {}
+    void setAudioRouted(bool) {}
+    void setMuteMicrophone(bool) {}
+    void setMuteSpeaker(bool) {}
+    void onAudioModeChanged(const QString &) {}
+    void onAudioRoutedChanged(bool) {}
+    void onMuteMicrophoneChanged(bool) {}
+    void onMuteSpeakerChanged(bool) {}
+    void startEventTone(ToneType, int) {}
+    void stopEventTone() {}
+    void startDtmfTone(const QString &, int) {}
+    void stopDtmfTone() {}
+
+    QList<AbstractVoiceCallHandler*> m_calls;
+    AbstractVoiceCallHandler *m_active;
+};
+
+/*
+ * A table created by the test itself, writable so that it can be left in the
+ * states a writer that died mid update leaves it in.
+ */
+class TestTable
+{
+public:
+    TestTable() : fd(-1), table(NULL)
+    {
+        fd = memfd_create("tst-voicecall-state", MFD_CLOEXEC);
+        if(fd < 0 || ftruncate(fd, sizeof(VoiceCallStateTableLayout)) < 0) return;
+
+        void *mapping = mmap(NULL, sizeof(VoiceCallStateTableLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(mapping == MAP_FAILED) return;
+
+        table = new (mapping) VoiceCallStateTableLayout();
+        table->header.magic = VOICECALL_STATE_TABLE_MAGIC;
+        table->header.version = VOICECALL_STATE_TABLE_VERSION;
+        table->header.recordSize = sizeof(VoiceCallStateRecord);
+        table->header.recordCount = VOICECALL_STATE_TABLE_RECORDS;
+        table->header.writerPid = quint32(getpid());
+        table->header.generation = 1;
+    }
+
+    ~TestTable()
+    {
+        if(table) munmap(table, sizeof(VoiceCallStateTableLayout));
+        if(fd >= 0) close(fd);
+    }
+
+    int fd;
+    VoiceCallStateTableLayout *table;
+};
+
+class tst_VoiceCallStateTable : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void publishesCalls();
+    void followsChanges();
+    void queuesCallsWhenFull();
+    void truncatesLineId();
+    void isReadOnly();
+    void reportsWriterGone();
+
+    void rejectsLayout();
+    void skipsInconsistentRecords();
+    void givesUpOnHeader();
+    void checksWriterProcess();
+
+private:
+    TestCall* addCall(int serial);
+    void commit(const VoiceCallChangeSet &changes);
+
+    TestManager *m_manager;
+    VoiceCallHandlerDBusObject *m_calls;
+    VoiceCallStateTableWriter *m_writer;
+    VoiceCallStateTable *m_reader;
+};
+
+void tst_VoiceCallStateTable::init()
+{
+    m_manager = new TestManager;
+    m_calls = new VoiceCallHandlerDBusObject(m_manager);
+    m_writer = NULL;
+    m_reader = new VoiceCallStateTable;
+}
+
+void tst_VoiceCallStateTable::cleanup()
+{
+    delete m_reader;
+    delete m_writer;
+    qDeleteAll(m_manager->m_calls);
+    delete m_manager;
+}
+
+TestCall* tst_VoiceCallStateTable::addCall(int serial)
+{
+    TestCall *call = new TestCall(serial);
+    m_manager->m_calls.append(call);
+    return call;
+}
+
+void tst_VoiceCallStateTable::commit(const VoiceCallChangeSet &changes)
+{
+    emit m_manager->changesCommitted(changes);
+}
+
+void tst_VoiceCallStateTable::publishesCalls()
+{
+    TestCall *first = addCall(1);
+    first->m_status = AbstractVoiceCallHandler::STATUS_ACTIVE;
+    TestCall *second = addCall(2);
+    second->m_status = AbstractVoiceCallHandler::STATUS_INCOMING;
+    second->m_incoming = true;
+    second->m_emergency = true;
+    m_manager->m_active = first;
+
+    m_writer = new VoiceCallStateTableWriter(m_manager, m_calls);
+    QVERIFY(m_writer->isValid());
+    QVERIFY(m_reader->attach(m_writer->fileDescriptor()));
+
+    QVERIFY(m_reader->generation() > 0);
+    QCOMPARE(m_reader->activeHandle(), first->handle().value());
+    QVERIFY(m_reader->isWriterAlive());
+
+    bool ok = false;
+    QList<VoiceCallStateTable::Call> calls = m_reader->calls(&ok);
+    QVERIFY(ok);
+    QCOMPARE(calls.count(), 2);
+
+    QCOMPARE(calls.at(0).handle, first->handle().value());
+    QCOMPARE(calls.at(0).status, int(AbstractVoiceCallHandler::STATUS_ACTIVE));
+    QCOMPARE(calls.at(0).flags, quint32(VoiceCallStateRecord::FLAG_IN_USE));
+    QCOMPARE(calls.at(0).lineId, first->lineId());
+    QCOMPARE(calls.at(0).startedAt, first->startedAt().toMSecsSinceEpoch());
+
+    QCOMPARE(calls.at(1).handle, second->handle().value());
+    QCOMPARE(calls.at(1).status, int(AbstractVoiceCallHandler::STATUS_INCOMING));
+    QCOMPARE(calls.at(1).flags, quint32(VoiceCallStateRecord::FLAG_IN_USE
+                                        | VoiceCallStateRecord::FLAG_INCOMING
+                                        | VoiceCallStateRecord::FLAG_EMERGENCY));
+}
+
+void tst_VoiceCallStateTable::followsChanges()
+{
+    m_writer = new VoiceCallStateTableWriter(m_manager, m_calls);
+    QVERIFY(m_reader->attach(m_writer->fileDescriptor()));
+    quint64 generation = m_reader->generation();
+    QVERIFY(m_reader->calls().isEmpty());
+
+    VoiceCallChangeSet added;
+    TestCall *call = addCall(1);
+    added.addCall(call);
+    commit(added);
+
+    QVERIFY(m_reader->generation() > generation);
+    generation = m_reader->generation();
+    QCOMPARE(m_reader->calls().count(), 1);
+    QCOMPARE(m_reader->calls().first().status, int(AbstractVoiceCallHandler::STATUS_DIALING));
+
+    VoiceCallChangeSet changed;
+    call->m_status = AbstractVoiceCallHandler::STATUS_ACTIVE;
+    m_manager->m_active = call;
+    changed.changeCall(call, VoiceCallChangeSet::StatusProperty);
+    changed.changeManager(VoiceCallChangeSet::ActiveVoiceCallProperty);
+    commit(changed);
+
+    QVERIFY(m_reader->generation() > generation);
+    generation = m_reader->generation();
+    QCOMPARE(m_reader->calls().first().status, int(AbstractVoiceCallHandler::STATUS_ACTIVE));
+    QCOMPARE(m_reader->activeHandle(), call->handle().value());
+
+    // Duration ticks alone leave the table alone.
+    VoiceCallChangeSet ticked;
+    ticked.changeCall(call, VoiceCallChangeSet::DurationProperty);
+    commit(ticked);
+    QCOMPARE(m_reader->generation(), generation);
+
+    VoiceCallChangeSet removed;
+    m_manager->m_active = NULL;
+    m_manager->m_calls.removeOne(call);
+    removed.removeCall(call);
+    removed.changeManager(VoiceCallChangeSet::ActiveVoiceCallProperty);
+    commit(removed);
+    delete call;
+
+    QVERIFY(m_reader->generation() > generation);
+    QVERIFY(m_reader->calls().isEmpty());
+    QCOMPARE(m_reader->activeHandle(), quint64(0));
+}
+
+void tst_VoiceCallStateTable::queuesCallsWhenFull()
+{
+    m_writer = new VoiceCallStateTableWriter(m_manager, m_calls);
+    QVERIFY(m_reader->attach(m_writer->fileDescriptor()));
+
+    VoiceCallChangeSet added;
+    for(int serial = 1; serial <= VOICECALL_STATE_TABLE_RECORDS + 2; ++serial)
+    {
+        added.addCall(addCall(serial));
+    }
+    commit(added);
+    QCOMPARE(m_reader->calls().count(), VOICECALL_STATE_TABLE_RECORDS);
+
+    // A call removed while waiting is never published.
+    AbstractVoiceCallHandler *waiting = m_manager->m_calls.takeLast();
+    VoiceCallChangeSet dropped;
+    dropped.removeCall(waiting);
+    commit(dropped);
+    delete waiting;
+
+    // The other one takes the first record that is freed.
+    AbstractVoiceCallHandler *freed = m_manager->m_calls.takeFirst();
+    VoiceCallChangeSet removed;
+    removed.removeCall(freed);
+    commit(removed);
+    delete freed;
+
+    QList<VoiceCallStateTable::Call> calls = m_reader->calls();
+    QCOMPARE(calls.count(), VOICECALL_STATE_TABLE_RECORDS);
+    QCOMPARE(calls.first().handle, m_manager->m_calls.last()->handle().value());
+}
+
+void tst_VoiceCallStateTable::truncatesLineId()
+{
+    TestCall *call = addCall(1);
+    call->m_lineId = QString(2 * VOICECALL_STATE_LINE_ID_SIZE, QLatin1Char('5'));
+
+    m_writer = new VoiceCallStateTableWriter(m_manager, m_calls);
+    QVERIFY(m_reader->attach(m_writer->fileDescriptor()));
+
+    QCOMPARE(m_reader->calls().first().lineId, call->m_lineId.left(VOICECALL_STATE_LINE_ID_SIZE - 1));
+}
+
+void tst_VoiceCallStateTable::isReadOnly()
+{
+    m_writer = new VoiceCallStateTableWriter(m_manager, m_calls);
+    QVERIFY(m_writer->isValid());
+
+    int seals = fcntl(m_writer->fileDescriptor(), F_GET_SEALS);
+    QVERIFY(seals & F_SEAL_SEAL);
+    QCOMPARE(ftruncate(m_writer->fileDescriptor(), 0), -1);
+
+    // The writer goes on without the write seal on kernels that lack it.
+    if(!(seals & F_SEAL_FUTURE_WRITE))
+        QSKIP("The kernel does not support F_SEAL_FUTURE_WRITE");
+
+    QByteArray path = QFile::encodeName(QString("/proc/self/fd/%1").arg(m_writer->fileDescriptor()));
+    int fd = open(path.constData(), O_RDWR | O_CLOEXEC);
+    if(fd >= 0)
+    {
+        QCOMPARE(write(fd, "x", 1), ssize_t(-1));
+        QCOMPARE(errno, EPERM);
+        QVERIFY(mmap(NULL, sizeof(VoiceCallStateTableLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) == MAP_FAILED);
+        close(fd);
+    }
+}
+
+void tst_VoiceCallStateTable::reportsWriterGone()
+{
+    m_writer = new VoiceCallStateTableWriter(m_manager, m_calls);
+    QVERIFY(m_reader->attach(m_writer->fileDescriptor()));
+    QVERIFY(m_reader->isWriterAlive());
+
+    // The reader keeps its mapping, and can tell nobody updates it any more.
+    delete m_writer;
+    m_writer = NULL;
+    QVERIFY(!m_reader->isWriterAlive());
+    QVERIFY(m_reader->generation() > 0);
+}
+
+void tst_VoiceCallStateTable::rejectsLayout()
+{
+    TestTable table;
+    QVERIFY(table.table);
+
+    table.table->header.version = VOICECALL_STATE_TABLE_VERSION + 1;
+    QVERIFY(!m_reader->attach(table.fd));
+    QVERIFY(!m_reader->isAttached());
+
+    table.table->header.version = VOICECALL_STATE_TABLE_VERSION;
+    table.table->header.recordSize = sizeof(VoiceCallStateRecord) + 8;
+    QVERIFY(!m_reader->attach(table.fd));
+
+    table.table->header.recordSize = sizeof(VoiceCallStateRecord);
+    QVERIFY(m_reader->attach(table.fd));
+}
+
+void tst_VoiceCallStateTable::skipsInconsistentRecords()
+{
+    TestTable table;
+    QVERIFY(table.table);
+
+    for(int i = 0; i < 2; ++i)
+    {
+        table.table->records[i].flags = VoiceCallStateRecord::FLAG_IN_USE;
+        table.table->records[i].handle = TEST_EPOCH + i + 1;
+    }
+
+    // Left in the middle of an update for good.
+    table.table->records[0].sequence.store(1);
+
+    QVERIFY(m_reader->attach(table.fd));
+
+    bool ok = true;
+    QList<VoiceCallStateTable::Call> calls = m_reader->calls(&ok);
+    QVERIFY(!ok);
+    QCOMPARE(calls.count(), 1);
+    QCOMPARE(calls.first().handle, TEST_EPOCH + 2);
+
+    table.table->records[0].sequence.store(2);
+    calls = m_reader->calls(&ok);
+    QVERIFY(ok);
+    QCOMPARE(calls.count(), 2);
+}
+
+void tst_VoiceCallStateTable::givesUpOnHeader()
+{
+    TestTable table;
+    QVERIFY(table.table);
+    table.table->header.activeHandle = TEST_EPOCH + 1;
+    QVERIFY(m_reader->attach(table.fd));
+
+    QCOMPARE(m_reader->generation(), quint64(1));
+    QCOMPARE(m_reader->activeHandle(), TEST_EPOCH + 1);
+
+    table.table->header.sequence.store(3);
+    QCOMPARE(m_reader->generation(), quint64(0));
+    QCOMPARE(m_reader->activeHandle(), quint64(0));
+    QVERIFY(!m_reader->isWriterAlive());
+}
+
+void tst_VoiceCallStateTable::checksWriterProcess()
+{
+    TestTable table;
+    QVERIFY(table.table);
+    QVERIFY(m_reader->attach(table.fd));
+
+    QVERIFY(m_reader->isWriterAlive());
+
+    table.table->header.writerPid = 0;
+    QVERIFY(!m_reader->isWriterAlive());
+
+    // A writer that exited without clearing its pid.
+    pid_t child = fork();
+    if(child == 0) _exit(0);
+    QVERIFY(child > 0);
+    QCOMPARE(waitpid(child, NULL, 0), child);
+
+    table.table->header.writerPid = quint32(child);
+    QVERIFY(!m_reader->isWriterAlive());
+}
+
+QTEST_GUILESS_MAIN(tst_VoiceCallStateTable)
+
+#include "tst_voicecallstatetable.moc"
@@ -0,0 +1,13 @@
+include(../tests.pri)
+
+TARGET = tst_voicecallstatetable
+
+# The writer is part of the daemon, build it in.
+INCLUDEPATH += ../../src
+
+HEADERS += \
+    ../../src/voicecallstatetablewriter.h
+
+SOURCES += \
+    tst_voicecallstatetable.cpp \
+    ../../src/voicecallstatetablewriter.cpp
@@ -1,8 +1,9 @@
 TEMPLATE = subdirs
-SUBDIRS += src lib plugins
+SUBDIRS += src lib plugins tests
 
 plugins.depends = lib
 src.depends = lib
+tests.depends = lib
 
 OTHER_FILES = LICENSE makedist rpm/voicecall-qt5.spec
 